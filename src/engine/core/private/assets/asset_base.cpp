@@ -4,6 +4,12 @@
 
 namespace Eng
 {
+static std::atomic_uint64_t render_revision_counter = 0;
+
+AssetBase::AssetBase()
+{
+    mark_render_dirty();
+}
 
 AssetBase::~AssetBase()
 {
@@ -12,4 +18,9 @@ AssetBase::~AssetBase()
         cl->second.erase(this);
 }
 
+void AssetBase::mark_render_dirty()
+{
+    render_revision.store(++render_revision_counter, std::memory_order_release);
+}
+
 } // namespace Eng
\ No newline at end of file
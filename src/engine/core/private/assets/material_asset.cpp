@@ -11,12 +11,15 @@ namespace Eng
 {
 MaterialAsset::MaterialAsset() = default;
 
-void MaterialAsset::set_shader_code(const std::filesystem::path& code, const std::optional<std::vector<StageInputOutputDescription>>& vertex_input_override)
+void MaterialAsset::set_shader_code(const std::filesystem::path& code, const std::optional<std::vector<StageInputOutputDescription>>& vertex_input_override,
+                                    const std::optional<std::vector<StageInputOutputDescription>>& instance_input_override)
 {
     std::unique_lock lk(pipeline_mutex);
     PROFILER_SCOPE_NAMED(LoadMat, "Load material from path " + code.string());
     if (vertex_input_override)
         vertex_inputs = *vertex_input_override;
+    if (instance_input_override)
+        instance_inputs = *instance_input_override;
     shader_virtual_path = code;
 
     permutations.clear();
@@ -30,6 +33,7 @@ void MaterialAsset::set_shader_code(const std::filesystem::path& code, const std
         last_update = last_write_time(shader_real_path);
     }
     default_permutation = compiler_session->get_default_permutations_description();
+    mark_render_dirty();
 }
 
 std::weak_ptr<MaterialPermutation> MaterialAsset::get_permutation(const Gfx::PermutationDescription& permutation)
@@ -112,7 +116,7 @@ std::shared_ptr<Gfx::Pipeline> MaterialPermutation::get_resource(const Gfx::Rend
         modules.emplace_back(Gfx::ShaderModule::create(device, stage.second));
     }
     if (!modules.empty() && render_pass_object.lock())
-        infos.pipeline = Gfx::Pipeline::create(owner->get_name(), device, render_pass_object, modules, Gfx::Pipeline::CreateInfos{.options = owner->options, .vertex_inputs = owner->vertex_inputs});
+        infos.pipeline = Gfx::Pipeline::create(owner->get_name(), device, render_pass_object, modules, Gfx::Pipeline::CreateInfos{.options = owner->options, .vertex_inputs = owner->vertex_inputs, .instance_inputs = owner->instance_inputs});
 
     return passes.emplace(render_pass, infos).first->second.pipeline;
 };
@@ -7,6 +7,7 @@
 #include "gfx/vulkan/descriptor_sets.hpp"
 #include "object_ptr.hpp"
 #include "profiler.hpp"
+#include "scene/scene_view.hpp"
 
 namespace Eng
 {
@@ -35,19 +36,41 @@ std::shared_ptr<Gfx::Pipeline> MaterialInstanceAsset::get_base_resource(const Gf
     return perm->get_resource(render_pass_id);
 }
 
-std::shared_ptr<Gfx::DescriptorSet> MaterialInstanceAsset::get_descriptor_resource(const Gfx::RenderPassRef& render_pass_id)
+std::shared_ptr<Gfx::DescriptorSet> MaterialInstanceAsset::get_descriptor_resource(const Gfx::RenderPassRef& render_pass_id, const SceneView* view)
 {
+    const DescriptorKey key{render_pass_id, view ? view->get_id() : 0};
     {
         std::shared_lock lk(descriptor_lock);
-        if (auto found = descriptors.find(render_pass_id); found != descriptors.end())
+        if (auto found = descriptors.find(key); found != descriptors.end())
             return found->second;
     }
     PROFILER_SCOPE(GetUpdateDescriptorResources);
     std::unique_lock lk(descriptor_lock);
+    if (auto found = descriptors.find(key); found != descriptors.end())
+        return found->second;
+
+    if (view)
+    {
+        // New view : forget the destroyed ones
+        std::erase_if(views,
+                      [&](const auto& entry)
+                      {
+                          if (!entry.second.expired())
+                              return false;
+                          std::erase_if(descriptors,
+                                        [&](const auto& descriptor)
+                                        {
+                                            return descriptor.first.view_id == entry.first;
+                                        });
+                          return true;
+                      });
+        views.emplace(key.view_id, view->weak_from_this());
+    }
+
     if (auto base_material = get_base_resource(render_pass_id))
     {
         auto new_descriptor =
-            descriptors.emplace(render_pass_id, Gfx::DescriptorSet::create(std::string(get_name()) + "_descriptors_" + render_pass_id.to_string(), Engine::get().get_device(), base_material->get_layout())).first->second;
+            descriptors.emplace(key, Gfx::DescriptorSet::create(std::string(get_name()) + "_descriptors_" + render_pass_id.to_string(), Engine::get().get_device(), base_material->get_layout())).first->second;
 
         for (const auto& sampler : samplers)
             new_descriptor->bind_sampler(sampler.first, sampler.second->get_resource());
@@ -70,11 +93,26 @@ std::shared_ptr<Gfx::DescriptorSet> MaterialInstanceAsset::get_descriptor_resour
                 new_descriptor->bind_buffer(buffer.first, buffer.second.lock());
         }
 
+        if (view)
+            new_descriptor->bind_buffer("scene_data_buffer", view->get_view_buffer());
+
         return new_descriptor;
     }
     return {};
 }
 
+void MaterialInstanceAsset::release_view_descriptors(uint64_t view_id)
+{
+    std::unique_lock lk(descriptor_lock);
+    if (!views.erase(view_id))
+        return;
+    std::erase_if(descriptors,
+                  [&](const auto& descriptor)
+                  {
+                      return descriptor.first.view_id == view_id;
+                  });
+}
+
 void MaterialInstanceAsset::set_sampler(const std::string& binding, const TObjectRef<SamplerAsset>& sampler)
 {
     PROFILER_SCOPE(SetSampler1);
@@ -82,6 +120,7 @@ void MaterialInstanceAsset::set_sampler(const std::string& binding, const TObjec
     samplers.insert_or_assign(binding, sampler);
     for (const auto& desc : descriptors)
         desc.second->bind_sampler(binding, sampler->get_resource());
+    binding_revision.fetch_add(1, std::memory_order_release);
 }
 
 void MaterialInstanceAsset::set_texture(const std::string& binding, const TObjectRef<TextureAsset>& texture)
@@ -91,6 +130,7 @@ void MaterialInstanceAsset::set_texture(const std::string& binding, const TObjec
     textures.insert_or_assign(binding, texture);
     for (const auto& desc : descriptors)
         desc.second->bind_image(binding, texture->get_view());
+    binding_revision.fetch_add(1, std::memory_order_release);
 }
 
 void MaterialInstanceAsset::set_buffer(const std::string& binding, const std::weak_ptr<Gfx::Buffer>& buffer)
@@ -100,14 +140,26 @@ void MaterialInstanceAsset::set_buffer(const std::string& binding, const std::we
     buffers.insert_or_assign(binding, buffer);
     for (const auto& desc : descriptors)
         desc.second->bind_buffer(binding, buffer.lock());
+    binding_revision.fetch_add(1, std::memory_order_release);
 }
 
 void MaterialInstanceAsset::set_sampler(const Gfx::RenderPassRef& render_pass_id, const std::string& binding, const TObjectRef<SamplerAsset>& sampler)
 {
     PROFILER_SCOPE(SetSampler);
     std::unique_lock lk(descriptor_lock);
-    if (auto found = descriptors.find(render_pass_id); found != descriptors.end())
-        found->second->bind_sampler(binding, sampler->get_resource());
+    // Also bound to the descriptors of each view of this pass
+    bool b_bound = false;
+    for (const auto& [key, descriptor] : descriptors)
+        if (key.render_pass == render_pass_id)
+        {
+            descriptor->bind_sampler(binding, sampler->get_resource());
+            b_bound = true;
+        }
+    if (b_bound)
+    {
+        pass_data[render_pass_id].samplers.insert_or_assign(binding, sampler);
+        binding_revision.fetch_add(1, std::memory_order_release);
+    }
     else
     {
         if (auto existing = samplers.find(binding); existing != samplers.end())
@@ -125,8 +177,19 @@ void MaterialInstanceAsset::set_texture(const Gfx::RenderPassRef& render_pass_id
 {
     PROFILER_SCOPE(SetTexture);
     std::unique_lock lk(descriptor_lock);
-    if (auto found = descriptors.find(render_pass_id); found != descriptors.end())
-        found->second->bind_image(binding, texture->get_view());
+    // Also bound to the descriptors of each view of this pass
+    bool b_bound = false;
+    for (const auto& [key, descriptor] : descriptors)
+        if (key.render_pass == render_pass_id)
+        {
+            descriptor->bind_image(binding, texture->get_view());
+            b_bound = true;
+        }
+    if (b_bound)
+    {
+        pass_data[render_pass_id].textures.insert_or_assign(binding, texture);
+        binding_revision.fetch_add(1, std::memory_order_release);
+    }
     else
     {
         if (auto existing = textures.find(binding); existing != textures.end())
@@ -144,8 +207,19 @@ void MaterialInstanceAsset::set_buffer(const Gfx::RenderPassRef& render_pass_id,
 {
     PROFILER_SCOPE_NAMED(SetBufferWithLock, "Set buffer " + buffer.lock()->get_name());
     std::unique_lock lk(descriptor_lock);
-    if (auto found = descriptors.find(render_pass_id); found != descriptors.end())
-        found->second->bind_buffer(binding, buffer.lock());
+    // Also bound to the descriptors of each view of this pass, except their own scene data
+    bool b_bound = false;
+    for (const auto& [key, descriptor] : descriptors)
+        if (key.render_pass == render_pass_id && !(key.view_id != 0 && binding == "scene_data_buffer"))
+        {
+            descriptor->bind_buffer(binding, buffer.lock());
+            b_bound = true;
+        }
+    if (b_bound)
+    {
+        pass_data[render_pass_id].buffers.insert_or_assign(binding, buffer);
+        binding_revision.fetch_add(1, std::memory_order_release);
+    }
     else
     {
         if (auto existing = buffers.find(binding); existing != buffers.end())
@@ -159,15 +233,6 @@ void MaterialInstanceAsset::set_buffer(const Gfx::RenderPassRef& render_pass_id,
     }
 }
 
-void MaterialInstanceAsset::set_scene_data(const Gfx::RenderPassRef& render_pass_id, const std::weak_ptr<Gfx::Buffer>& buffer_data)
-{
-    std::lock_guard lk(test);
-    if (auto found = last_scene_buffer.find(render_pass_id); found != last_scene_buffer.end() && buffer_data.lock() == found->second.lock())
-        return;
-    last_scene_buffer.insert_or_assign(render_pass_id, buffer_data);
-    set_buffer(render_pass_id, "scene_data_buffer", buffer_data);
-}
-
 void MaterialInstanceAsset::prepare_for_passes(const Gfx::RenderPassGenericId& render_pass_id)
 {
     for (const auto& pass : Engine::get().get_device().lock()->get_all_pass_of_type(render_pass_id))
@@ -183,5 +248,12 @@ void MaterialInstanceAsset::set_permutation(const Gfx::PermutationDescription& p
 {
     permutation_description = perm;
     permutation             = {};
+    mark_render_dirty();
+}
+
+uint64_t MaterialInstanceAsset::get_pipeline_revision() const
+{
+    // Revisions are increasing values of a single counter : any modification of one of the two assets gives a new maximum
+    return std::max(get_render_revision(), base->get_render_revision());
 }
 } // namespace Eng
\ No newline at end of file
@@ -18,5 +18,17 @@ void MeshAsset::add_section(const std::string& section_name, const std::vector<V
 
     mesh_sections.emplace_back(section_bounds, Gfx::Mesh::create(section_name, Engine::get().get_device(), Gfx::EBufferType::IMMUTABLE, Gfx::BufferData(vertices.data(), sizeof(Vertex), vertices.size()), &indices),
                                material);
+    mark_render_dirty();
+}
+
+void MeshAsset::set_occluder(std::vector<glm::vec3> vertices, std::vector<uint32_t> indices)
+{
+    if (indices.size() % 3 != 0)
+    {
+        LOG_ERROR("Occluder of mesh {} is not made of triangles", get_name());
+        return;
+    }
+    occluder_vertices = std::move(vertices);
+    occluder_indices  = std::move(indices);
 }
 } // namespace Eng
\ No newline at end of file
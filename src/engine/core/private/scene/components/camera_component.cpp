@@ -36,6 +36,7 @@ SceneView& CameraComponent::get_view()
         scene_view->set_fov(fov);
         scene_view->set_z_far(z_far);
         scene_view->set_z_near(z_near);
+        scene_view->set_occlusion_culling(true);
     }
     return *scene_view;
 
@@ -6,51 +6,142 @@
 #include "gfx/vulkan/buffer.hpp"
 #include "gfx/vulkan/command_buffer.hpp"
 #include "profiler.hpp"
+#include "render_queue.hpp"
 #include "gfx/mesh.hpp"
 #include "scene/scene_view.hpp"
 #include "scene/components/camera_component.hpp"
 
-struct Pc
-{
-    glm::mat4 model;
-};
+#include <algorithm>
 
 namespace Eng
 {
-void MeshComponent::draw(Gfx::CommandBuffer& command_buffer, const SceneView& view)
+MeshComponent::~MeshComponent()
 {
-    if (mesh)
+    // The component can be destroyed while the scene is queried (ex : IObject::destroy() during a frame), the bvh is only modified by the tick
+    if (spatial_proxy != DynamicBvh::NULL_NODE)
+        get_scene().release_spatial_proxy(spatial_proxy);
+    for (PassDrawPackets* it = draw_packets.load(); it;)
+        delete std::exchange(it, it->next);
+}
+
+void MeshComponent::set_mesh(const TObjectRef<MeshAsset>& in_mesh)
+{
+    mesh = in_mesh;
+    on_transform_changed();
+}
+
+void MeshComponent::on_transform_changed()
+{
+    // Not registered in the scene yet (called from the constructor), the scene will mark it once added
+    if (!as_ref())
+        return;
+    last_move_tick = get_scene().get_tick_count();
+    if (b_spatial_dirty)
+        return;
+    b_spatial_dirty = true;
+    get_scene().mark_spatial_dirty(as_ref().cast<MeshComponent>());
+}
+
+MeshComponent::PassDrawPackets& MeshComponent::get_pass_packets(const Gfx::RenderPassRef& render_pass, const SceneView& view)
+{
+    PassDrawPackets* head = draw_packets.load(std::memory_order_acquire);
+    for (PassDrawPackets* it = head; it; it = it->next)
+        if (it->pass_id == render_pass.unique_id() && it->view_id == view.get_id())
+            return *it;
+
+    // First draw for this view. Another pass or view can insert its own list at the same time.
+    auto* new_packets = new PassDrawPackets{.pass_id = render_pass.unique_id(), .view_id = view.get_id(), .next = head};
+    while (!draw_packets.compare_exchange_weak(new_packets->next, new_packets, std::memory_order_release, std::memory_order_acquire))
     {
-        if (!view.frustum_test(get_world_transform() * mesh->get_bounds()))
-            return;
+    }
+    return *new_packets;
+}
 
-        PROFILER_SCOPE_NAMED(DrawMesh, "Draw mesh component " + std::string(get_name()) + " : " + std::to_string(mesh->get_sections().size()) + " sections");
-        for (const auto& section : mesh->get_sections())
+bool MeshComponent::are_packets_valid(const PassDrawPackets& pass_packets) const
+{
+    if (pass_packets.mesh_revision != (mesh ? mesh->get_render_revision() : 0))
+        return false;
+    for (const auto& packet : pass_packets.packets)
+        if (packet.material_revision != packet.material->get_pipeline_revision())
+            return false;
+    return true;
+}
+
+void MeshComponent::rebuild_packets(PassDrawPackets& pass_packets, const SceneView& view, const Gfx::RenderPassRef& render_pass)
+{
+    PROFILER_SCOPE(RebuildDrawPackets);
+    pass_packets.packets.clear();
+    pass_packets.mesh_revision = mesh ? mesh->get_render_revision() : 0;
+    if (!mesh)
+        return;
+    for (const auto& section : mesh->get_sections())
+    {
+        if (!section.material)
+            continue;
+        MeshDrawPacket& packet   = pass_packets.packets.emplace_back();
+        packet.bounds            = section.bounds;
+        packet.material          = section.material;
+        packet.material_revision = section.material->get_pipeline_revision();
+        packet.mesh              = section.mesh;
+
+        packet.pipeline = section.material->get_base_resource(render_pass);
+        if (!packet.pipeline)
+            continue;
+        // The scene data of each view is bound to its own descriptors
+        packet.descriptors = section.material->get_descriptor_resource(render_pass, &view);
+        assert(packet.descriptors);
+        packet.pipeline_id    = DrawSortKey::resource_id(packet.pipeline.get());
+        packet.descriptors_id = DrawSortKey::resource_id(packet.descriptors.get());
+        packet.mesh_id        = DrawSortKey::resource_id(packet.mesh.get());
+        packet.b_blended      = packet.pipeline->infos().options.alpha != Gfx::EAlphaMode::Opaque;
+    }
+}
+
+void MeshComponent::release_view_packets(std::span<const uint64_t> view_ids)
+{
+    PassDrawPackets*  kept = nullptr;
+    PassDrawPackets** tail = &kept;
+    for (PassDrawPackets* it = draw_packets.load(std::memory_order_acquire); it;)
+    {
+        PassDrawPackets* next = it->next;
+        if (std::ranges::find(view_ids, it->view_id) != view_ids.end())
+        {
+            for (const auto& packet : it->packets)
+                if (packet.material)
+                    packet.material->release_view_descriptors(it->view_id);
+            delete it;
+        }
+        else
         {
-            if (!view.frustum_test(get_world_transform() * section.bounds))
-                continue;
-            if (section.material)
-            {
-                //PROFILER_SCOPE_NAMED(DrawMeshSection, "Draw mesh section" + section.mesh->get_name());
-                section.material->set_scene_data(command_buffer.render_pass(), view.get_view_buffer());
-
-                //PROFILER_SCOPE(DrawMeshSectionA);
-                auto pipeline = section.material->get_base_resource(command_buffer.render_pass());
-                if (!pipeline)
-                    return;
-                //PROFILER_SCOPE(DrawMeshSectionB);
-                command_buffer.bind_pipeline(pipeline);
-                command_buffer.push_constant(Gfx::EShaderStage::Vertex, *pipeline, Gfx::BufferData(Pc{.model = get_world_transform()}));
-
-                //PROFILER_SCOPE(DrawMeshSectionC);
-                auto resources = section.material->get_descriptor_resource(command_buffer.render_pass());
-                //PROFILER_SCOPE(DrawMeshSectionC1);
-                assert(resources);
-                command_buffer.bind_descriptors(*resources, *pipeline);
-                //PROFILER_SCOPE(DrawMeshSectionD);
-                command_buffer.draw_mesh(*section.mesh);
-            }
+            *tail = it;
+            tail  = &it->next;
         }
+        it = next;
+    }
+    *tail = nullptr;
+    draw_packets.store(kept, std::memory_order_release);
+}
+
+void MeshComponent::collect_draws(std::vector<MeshDraw>& out_draws, const SceneView& view, const Gfx::RenderPassRef& render_pass)
+{
+    PassDrawPackets& pass_packets = get_pass_packets(render_pass, view);
+    if (!are_packets_valid(pass_packets))
+        rebuild_packets(pass_packets, view, render_pass);
+
+    const glm::mat4& transform = get_world_transform();
+    for (const auto& packet : pass_packets.packets)
+    {
+        if (!packet.pipeline)
+            continue;
+        const Bounds section_bounds = transform * packet.bounds;
+        if (!view.frustum_test(section_bounds))
+            continue;
+
+        const float depth = view.get_normalized_depth(section_bounds.center());
+        // Blended sections are drawn after the opaque ones, from back to front
+        const uint64_t sort_key = packet.b_blended ? DrawSortKey::make_back_to_front(1, depth, packet.pipeline_id, packet.descriptors_id, packet.mesh_id)
+                                                   : DrawSortKey::make(0, packet.pipeline_id, packet.descriptors_id, packet.mesh_id, depth);
+        out_draws.emplace_back(MeshDraw{.sort_key = sort_key, .component = this, .packet = &packet});
     }
 }
 } // namespace Eng
\ No newline at end of file
@@ -2,23 +2,21 @@
 
 #include <imgui.h>
 
-#include <ranges>
+#include <vector>
 
 namespace Eng
 {
 void SceneComponent::internal_tick(double delta_second)
 {
-    std::vector<std::vector<TObjectPtr<SceneComponent>>::iterator> deleted_nodes;
-    for (auto node = children.begin(); node != children.end(); ++node)
-    {
-        if (*node)
-            (*node)->tick(delta_second);
-        else
-            deleted_nodes.push_back(node);
-    }
+    for (const auto& node : children)
+        if (node)
+            node->tick(delta_second);
 
-    for (auto& deleted_node : std::ranges::reverse_view(deleted_nodes))
-        children.erase(deleted_node);
+    std::erase_if(children,
+                  [](const TObjectPtr<SceneComponent>& node)
+                  {
+                      return !node;
+                  });
     tick(delta_second);
 }
 
@@ -1,59 +1,412 @@
+#include <algorithm>
 #include <ranges>
 
 #include "scene/scene.hpp"
 
 #include "engine.hpp"
+#include "frustum_culling.hpp"
+#include "assets/mesh_asset.hpp"
 #include "gfx/vulkan/buffer.hpp"
 #include "object_allocator.hpp"
 #include "profiler.hpp"
 #include "gfx/renderer/instance/render_pass_instance_base.hpp"
+#include "scene/components/mesh_component.hpp"
+#include "scene/scene_shadows.hpp"
+#include "scene/scene_view.hpp"
 #include "scene/components/scene_component.hpp"
 
 namespace Eng
 {
 Scene::Scene()
 {
-    merge_queue_mtx = std::make_unique<std::mutex>();
-    allocator       = std::make_unique<ContiguousObjectAllocator>();
+    merge_queue_mtx   = std::make_unique<std::mutex>();
+    destroy_queue_mtx = std::make_unique<std::mutex>();
+    views_mtx         = std::make_unique<std::mutex>();
+    spatial_mtx       = std::make_unique<std::mutex>();
+    allocator         = std::make_unique<ContiguousObjectAllocator>();
+    // Components whose last TObjectPtr is dropped are destroyed by flush_destroyed(), not in the middle of a frame
+    allocator->set_deferred_release(true);
+}
+
+Scene::~Scene()
+{
+    root_nodes.clear();
+    if (allocator)
+        allocator->flush_released();
 }
 
 void Scene::tick(double delta_second)
 {
     PROFILER_SCOPE(SceneTick);
+    ++tick_count;
     {
         PROFILER_SCOPE(MergeScenes);
         std::lock_guard lk(*merge_queue_mtx);
         for (auto& scene : scenes_to_merge)
-        {
-            scene.for_each<SceneComponent>(
-                [&](SceneComponent& object)
-                {
-                    object.scene = this;
-                });
-            assert(scene.allocator);
-            allocator->merge_with(*scene.allocator);
-            root_nodes.reserve(root_nodes.size() + scene.root_nodes.size());
-            for (const auto& component : scene.root_nodes)
-                root_nodes.push_back(component);
-            scene.root_nodes.clear();
-        }
+            merge_scene(scene);
         scenes_to_merge.clear();
     }
 
-    std::vector<std::vector<TObjectPtr<SceneComponent>>::iterator> deleted_nodes;
-    for (auto node = root_nodes.begin(); node != root_nodes.end(); ++node)
-    {
-        if (!*node)
-            deleted_nodes.push_back(node);
-    }
-    for (auto& deleted_node : std::ranges::reverse_view(deleted_nodes))
-        root_nodes.erase(deleted_node);
+    flush_destroyed();
 
     for_each<SceneComponent>(
         [delta_second](SceneComponent& object)
         {
             object.tick(delta_second);
         });
+
+    update_spatial_index();
+    if (shadows)
+        shadows->update();
+    release_destroyed_views();
+    cull_views();
+}
+
+SceneShadows& Scene::get_shadows()
+{
+    if (!shadows)
+        shadows = std::make_shared<SceneShadows>(*this);
+    return *shadows;
+}
+
+void Scene::destroy_deferred(const TObjectRef<SceneComponent>& component) const
+{
+    std::lock_guard lk(*destroy_queue_mtx);
+    destroy_queue.emplace_back(component);
+}
+
+void Scene::flush_destroyed()
+{
+    std::vector<TObjectRef<SceneComponent>> destroyed;
+    {
+        std::lock_guard lk(*destroy_queue_mtx);
+        destroyed.swap(destroy_queue);
+    }
+
+    if (!destroyed.empty())
+    {
+        PROFILER_SCOPE(DestroyComponents);
+        // Components can be moved in memory by each destruction, keep references to the parents
+        std::vector<TObjectRef<SceneComponent>> parents;
+        for (auto& component : destroyed)
+        {
+            // Already destroyed (queued twice or destroyed with its parent)
+            if (!component)
+                continue;
+            // Siblings are usually destroyed together
+            if (component->parent && (parents.empty() || !(parents.back() == component->parent)))
+                parents.emplace_back(component->parent);
+            component.destroy();
+        }
+
+        // Children lists of the surviving parents are compacted after every destruction
+        for (const auto& parent : parents)
+            if (parent)
+                std::erase_if(parent->children,
+                              [](const TObjectPtr<SceneComponent>& child)
+                              {
+                                  return !child;
+                              });
+    }
+
+    // Components released during the frame, and the children of the destroyed ones
+    {
+        PROFILER_SCOPE(ReleaseComponents);
+        allocator->flush_released();
+    }
+    // The bvh must not return the destroyed components to the queries of this tick
+    remove_released_proxies();
+
+    // Roots can also be destroyed directly. Remove them in a single stable pass.
+    std::erase_if(root_nodes,
+                  [](const TObjectPtr<SceneComponent>& node)
+                  {
+                      return !node;
+                  });
+}
+
+void Scene::query_meshes(const CullingPlanes& planes, std::vector<MeshComponent*>& out_components) const
+{
+    PROFILER_SCOPE(SceneQueryMeshes);
+    thread_local std::vector<uint32_t> visible;
+    visible.clear();
+    mesh_bvh.query_frustum(planes, visible);
+    out_components.reserve(out_components.size() + visible.size());
+    for (const auto& slot : visible)
+        out_components.emplace_back(spatial_components[slot].operator->());
+}
+
+void Scene::query_meshes(std::span<const CullingPlanes> views, std::span<std::vector<MeshComponent*>* const> out_components) const
+{
+    PROFILER_SCOPE(SceneQueryMeshesMultiView);
+    thread_local std::vector<std::vector<uint32_t>>  visible;
+    thread_local std::vector<std::vector<uint32_t>*> outputs;
+    visible.resize(views.size());
+    outputs.clear();
+    for (size_t v = 0; v < views.size(); ++v)
+    {
+        visible[v].clear();
+        outputs.emplace_back(&visible[v]);
+    }
+    mesh_bvh.query_frustums(views, outputs);
+
+    for (size_t v = 0; v < views.size(); ++v)
+    {
+        out_components[v]->reserve(out_components[v]->size() + visible[v].size());
+        for (const auto& slot : visible[v])
+            out_components[v]->emplace_back(spatial_components[slot].operator->());
+    }
+}
+
+bool Scene::raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, SceneHit& out_hit) const
+{
+    BvhRayHit hit;
+    if (!mesh_bvh.raycast(origin, direction, max_distance, hit))
+        return false;
+    out_hit = {.component = spatial_components[hit.user_data], .distance = hit.distance};
+    return true;
+}
+
+bool Scene::nearest(const glm::vec3& position, float max_distance, SceneHit& out_hit) const
+{
+    BvhRayHit hit;
+    if (!mesh_bvh.nearest(position, max_distance, hit))
+        return false;
+    out_hit = {.component = spatial_components[hit.user_data], .distance = hit.distance};
+    return true;
+}
+
+void Scene::overlap_box(const Bounds& bounds, std::vector<MeshComponent*>& out_components) const
+{
+    thread_local std::vector<uint32_t> found;
+    found.clear();
+    mesh_bvh.query_overlap(bounds, found);
+    for (const auto& slot : found)
+        out_components.emplace_back(spatial_components[slot].operator->());
+}
+
+void Scene::overlap_sphere(const glm::vec3& center, float radius, std::vector<MeshComponent*>& out_components) const
+{
+    thread_local std::vector<uint32_t> found;
+    found.clear();
+    mesh_bvh.query_sphere(center, radius, found);
+    for (const auto& slot : found)
+        out_components.emplace_back(spatial_components[slot].operator->());
+}
+
+void Scene::query_batch(size_t count, const std::function<void(size_t)>& query) const
+{
+    PROFILER_SCOPE(SceneQueryBatch);
+    // Small batches are not worth the scheduling cost
+    constexpr size_t MIN_QUERIES_PER_JOB = 64;
+    const size_t     job_count           = std::min(static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency())), (count + MIN_QUERIES_PER_JOB - 1) / MIN_QUERIES_PER_JOB);
+    if (job_count <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+            query(i);
+        return;
+    }
+
+    std::vector<JobHandle<void>> jobs;
+    for (size_t job = 0; job < job_count; ++job)
+        jobs.emplace_back(JobSystem::get().schedule(
+            [&query, first = count * job / job_count, last = count * (job + 1) / job_count]
+            {
+                for (size_t i = first; i < last; ++i)
+                    query(i);
+            }));
+    for (const auto& job : jobs)
+        job.await();
+}
+
+void Scene::register_view(const std::weak_ptr<SceneView>& view) const
+{
+    std::lock_guard lk(*views_mtx);
+    registered_views.emplace_back(view);
+    if (auto locked = view.lock())
+        drawn_views.emplace(locked->get_id(), view);
+}
+
+void Scene::release_destroyed_views()
+{
+    std::vector<uint64_t> destroyed;
+    {
+        std::lock_guard lk(*views_mtx);
+        std::erase_if(drawn_views,
+                      [&](const auto& view)
+                      {
+                          if (!view.second.expired())
+                              return false;
+                          destroyed.emplace_back(view.first);
+                          return true;
+                      });
+    }
+    if (destroyed.empty())
+        return;
+
+    PROFILER_SCOPE(ReleaseDestroyedViews);
+    for_each<MeshComponent>(
+        [&](MeshComponent& component)
+        {
+            component.release_view_packets(destroyed);
+        });
+}
+
+void Scene::cull_views()
+{
+    std::vector<std::shared_ptr<SceneView>> views;
+    {
+        std::lock_guard lk(*views_mtx);
+        for (const auto& view : registered_views)
+            if (auto locked = view.lock())
+                views.emplace_back(locked);
+        registered_views.clear();
+    }
+    if (views.empty())
+        return;
+
+    PROFILER_SCOPE(SceneCullViews);
+    // A view could be drawn by multiple passes
+    std::ranges::sort(views);
+    views.erase(std::ranges::unique(views).begin(), views.end());
+
+    std::vector<CullingPlanes>                planes;
+    std::vector<std::vector<MeshComponent*>*> outputs;
+    for (const auto& view : views)
+    {
+        planes.emplace_back(view->prepare_culling());
+        outputs.emplace_back(&view->visible_components);
+    }
+    query_meshes(planes, outputs);
+}
+
+void Scene::mark_spatial_dirty(const TObjectRef<MeshComponent>& component)
+{
+    std::lock_guard lk(*spatial_mtx);
+    spatial_dirty.emplace_back(component);
+}
+
+void Scene::release_spatial_proxy(uint32_t proxy)
+{
+    std::lock_guard lk(*spatial_mtx);
+    released_spatial_proxies.emplace_back(proxy);
+}
+
+void Scene::remove_spatial_proxy(uint32_t proxy)
+{
+    const uint32_t slot      = mesh_bvh.get_user_data(proxy);
+    spatial_components[slot] = {};
+    free_spatial_slots.emplace_back(slot);
+    mesh_bvh.remove(proxy);
+}
+
+void Scene::remove_released_proxies()
+{
+    std::vector<uint32_t> released;
+    {
+        std::lock_guard lk(*spatial_mtx);
+        released.swap(released_spatial_proxies);
+    }
+    for (const auto& proxy : released)
+        remove_spatial_proxy(proxy);
+}
+
+void Scene::update_spatial_index()
+{
+    remove_released_proxies();
+
+    std::vector<TObjectRef<MeshComponent>> dirty;
+    {
+        std::lock_guard lk(*spatial_mtx);
+        dirty.swap(spatial_dirty);
+    }
+    if (dirty.empty())
+        return;
+
+    PROFILER_SCOPE(UpdateSpatialIndex);
+    size_t inserted = 0;
+    for (const auto& component : dirty)
+    {
+        // Destroyed since it was marked
+        if (!component)
+            continue;
+        MeshComponent& mesh_component  = *component.operator->();
+        mesh_component.b_spatial_dirty = false;
+
+        if (!mesh_component.mesh)
+        {
+            if (mesh_component.spatial_proxy != DynamicBvh::NULL_NODE)
+                remove_spatial_proxy(mesh_component.spatial_proxy);
+            mesh_component.spatial_proxy = DynamicBvh::NULL_NODE;
+            continue;
+        }
+
+        const Bounds bounds = mesh_component.get_world_transform() * mesh_component.mesh->get_bounds();
+        if (mesh_component.spatial_proxy == DynamicBvh::NULL_NODE)
+        {
+            uint32_t slot;
+            if (free_spatial_slots.empty())
+            {
+                slot = static_cast<uint32_t>(spatial_components.size());
+                spatial_components.emplace_back();
+            }
+            else
+            {
+                slot = free_spatial_slots.back();
+                free_spatial_slots.pop_back();
+            }
+            spatial_components[slot]     = component;
+            mesh_component.spatial_proxy = mesh_bvh.insert(bounds, slot);
+            ++inserted;
+        }
+        else
+            mesh_bvh.update(mesh_component.spatial_proxy, bounds);
+    }
+
+    // Large batches of insertion (scene loading) produce a poor tree
+    if (inserted > 1024 && inserted * 4 > mesh_bvh.size())
+    {
+        PROFILER_SCOPE(RebuildSpatialIndex);
+        mesh_bvh.rebuild();
+    }
+}
+
+void Scene::merge_scene(Scene& other_scene)
+{
+    // The released components still belong to the other scene
+    other_scene.allocator->flush_released();
+    other_scene.for_each<SceneComponent>(
+        [&](SceneComponent& object)
+        {
+            object.scene = this;
+        });
+    // Proxies were registered in the other scene's bvh
+    {
+        std::lock_guard lk(*spatial_mtx);
+        other_scene.for_each<MeshComponent>(
+            [&](MeshComponent& object)
+            {
+                object.spatial_proxy   = DynamicBvh::NULL_NODE;
+                object.b_spatial_dirty = true;
+                spatial_dirty.emplace_back(object.as_ref().cast<MeshComponent>());
+            });
+    }
+    assert(other_scene.allocator);
+    allocator->merge_with(*other_scene.allocator);
+    // The views that drew the other scene also have draw packets in its components
+    {
+        std::lock_guard lk(*views_mtx);
+        std::lock_guard other_lk(*other_scene.views_mtx);
+        drawn_views.insert(other_scene.drawn_views.begin(), other_scene.drawn_views.end());
+    }
+    // Shadowed lights are now drawn in the atlas of this scene
+    if (other_scene.shadows)
+        for (const auto& light : other_scene.shadows->get_lights())
+            get_shadows().add_light(light);
+    root_nodes.reserve(root_nodes.size() + other_scene.root_nodes.size());
+    for (const auto& component : other_scene.root_nodes)
+        root_nodes.push_back(component);
+    other_scene.root_nodes.clear();
 }
 
 void Scene::merge(Scene&& other_scene)
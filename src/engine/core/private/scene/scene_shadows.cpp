@@ -0,0 +1,171 @@
+#include "scene/scene_shadows.hpp"
+
+#include "image_signatures.hpp"
+#include "profiler.hpp"
+#include "gfx/renderer/definition/renderer.hpp"
+#include "gfx/renderer/instance/render_pass_instance_base.hpp"
+#include "gfx/vulkan/command_buffer.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_view.hpp"
+#include "scene/components/camera_component.hpp"
+#include "scene/components/light_component.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace Eng
+{
+class ShadowAtlasInterface : public Gfx::IRenderPass
+{
+public:
+    ShadowAtlasInterface(SceneShadows* in_shadows, Scene* in_scene, bool in_dynamic) : shadows(in_shadows), scene(in_scene), b_dynamic(in_dynamic)
+    {
+    }
+
+    void pre_draw(const Gfx::RenderPassInstanceBase& rp) override
+    {
+        tile_views = shadows->get_tile_views(b_dynamic);
+        signature  = tile_views.size();
+        for (const auto& tile_view : tile_views)
+        {
+            tile_view.view->pre_draw(*scene, rp);
+            for (uint64_t value : {tile_view.view->get_content_signature(), static_cast<uint64_t>(tile_view.tile.x) << 32 | tile_view.tile.y, static_cast<uint64_t>(tile_view.tile.size)})
+                signature ^= value + 0x9e3779b97f4a7c15ull + (signature << 6) + (signature >> 2);
+        }
+    }
+
+    // The copy of the atlas used by this frame is only drawn again when the layout, a light or one of its visible casters changed since it was drawn
+    bool should_render(const Gfx::RenderPassInstanceBase& rp) override
+    {
+        return rendered_signatures.update(rp.get_current_swapchain_image(), signature);
+    }
+
+    // New attachments have no content
+    void on_create_framebuffer(const Gfx::RenderPassInstanceBase& rp) override
+    {
+        rendered_signatures.reset(rp.get_image_count());
+    }
+
+    std::optional<size_t> get_draw_count(const Gfx::RenderPassInstanceBase&) override
+    {
+        size_t count = 0;
+        for (const auto& tile_view : tile_views)
+            count += tile_view.view->get_visible_count();
+        return count;
+    }
+
+    void draw(const Gfx::RenderPassInstanceBase& rp, Gfx::CommandBuffer& command_buffer, size_t thread_index) override
+    {
+        for (const auto& tile_view : tile_views)
+        {
+            // Flipped like the full pass viewport (see RenderPassInstance::fill_command_buffer())
+            const ShadowAtlasTile& tile = tile_view.tile;
+            command_buffer.set_viewport({
+                .x      = static_cast<float>(tile.x),
+                .y      = static_cast<float>(tile.y + tile.size),
+                .width  = static_cast<float>(tile.size),
+                .height = -static_cast<float>(tile.size),
+            });
+            command_buffer.set_scissor({static_cast<int32_t>(tile.x), static_cast<int32_t>(tile.y), tile.size, tile.size});
+            tile_view.view->draw(*scene, rp, command_buffer, thread_index, rp.get_record_jobs());
+        }
+    }
+
+    size_t record_threads() override
+    {
+        return std::thread::hardware_concurrency() * 3;
+    }
+
+    void pre_submit(const Gfx::RenderPassInstanceBase&) override
+    {
+        for (const auto& tile_view : tile_views)
+            tile_view.view->pre_submit();
+    }
+
+private:
+    SceneShadows*               shadows;
+    Scene*                      scene;
+    bool                        b_dynamic;
+    std::vector<ShadowTileView> tile_views;
+    uint64_t                    signature = 0;
+    ImageSignatures             rendered_signatures;
+};
+
+SceneShadows::SceneShadows(Scene& in_scene) : scene(&in_scene), atlas(ATLAS_SIZE, MIN_TILE_SIZE)
+{
+}
+
+SceneShadows::~SceneShadows()
+{
+    if (atlas_pass)
+        scene->remove_custom_pass(atlas_pass);
+    if (dynamic_atlas_pass)
+        scene->remove_custom_pass(dynamic_atlas_pass);
+}
+
+void SceneShadows::add_light(const TObjectRef<LightComponent>& light)
+{
+    if (std::ranges::find(lights, light) == lights.end())
+        lights.emplace_back(light);
+    if (!atlas_pass)
+        create_passes();
+}
+
+void SceneShadows::remove_light(const TObjectRef<LightComponent>& light)
+{
+    std::erase(lights, light);
+}
+
+void SceneShadows::create_passes()
+{
+    const auto create_pass = [&](bool b_dynamic)
+    {
+        Gfx::Renderer renderer;
+        renderer["shadows"]
+            .render_pass<ShadowAtlasInterface>(this, scene, b_dynamic)
+            .flip_culling(true)
+            .resize_callback(
+                [](const glm::uvec2&) -> glm::uvec2
+                {
+                    return {ATLAS_SIZE, ATLAS_SIZE};
+                })
+            [Gfx::Attachment::slot("depth").format(Gfx::ColorFormat::D24_UNORM_S8_UINT).clear_depth({0.0f, 0.0f}).persistent(true)];
+        return scene->add_custom_pass({"gbuffer_resolve"}, renderer);
+    };
+    atlas_pass         = create_pass(false);
+    dynamic_atlas_pass = create_pass(true);
+}
+
+void SceneShadows::update()
+{
+    PROFILER_SCOPE(AllocateShadowAtlas);
+
+    // Destroyed lights
+    std::erase_if(lights,
+                  [](const TObjectRef<LightComponent>& light)
+                  {
+                      return !light;
+                  });
+
+    const TObjectRef<CameraComponent>& camera       = scene->get_active_camera();
+    const float                        tan_half_fov = camera ? camera->get_view().get_light_cluster_view().tan_half_height : 1.f;
+    requests.clear();
+    for (const auto& light : lights)
+    {
+        const float importance = camera ? ShadowAtlas::screen_importance(light->get_relative_position(), light->orthographic_width * 0.5f, camera->get_relative_position(), tan_half_fov) : 1.f;
+        requests.emplace_back(ShadowAtlasRequest{importance, light->shadow_resolution});
+    }
+    atlas.allocate(requests, tiles);
+
+    tile_views.clear();
+    dynamic_tile_views.clear();
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        lights[i]->shadow_tile = tiles[i];
+        if (!tiles[i].is_valid())
+            continue;
+        tile_views.emplace_back(ShadowTileView{lights[i]->shadow_view, tiles[i]});
+        dynamic_tile_views.emplace_back(ShadowTileView{lights[i]->dynamic_shadow_view, tiles[i]});
+    }
+}
+} // namespace Eng
@@ -0,0 +1,113 @@
+#include "scene/scene_streaming.hpp"
+
+#include "logger.hpp"
+#include "profiler.hpp"
+#include "scene/scene.hpp"
+#include "scene/components/scene_component.hpp"
+
+namespace Eng
+{
+SceneStreaming::SceneStreaming(Scene& in_scene, const WorldPartition& partition, CellLoader in_loader) : scene(in_scene), loader(std::move(in_loader)), streamer(partition, make_callbacks())
+{
+}
+
+SceneStreaming::~SceneStreaming()
+{
+    for (const auto& job : running_loads)
+        job.await();
+}
+
+void SceneStreaming::update(const glm::vec3& position)
+{
+    PROFILER_SCOPE(SceneStreaming);
+    std::erase_if(running_loads,
+                  [](const JobHandle<void>& job)
+                  {
+                      return job.finished();
+                  });
+    streamer.update(position, budget_ms);
+}
+
+WorldStreamer::Callbacks SceneStreaming::make_callbacks()
+{
+    WorldStreamer::Callbacks callbacks;
+    callbacks.load = [this](const WorldCell& cell)
+    {
+        load_cell(cell);
+    };
+    callbacks.merge = [this](const WorldCell& cell)
+    {
+        merge_cell(cell);
+    };
+    callbacks.unload = [this](const WorldCell& cell, bool b_merged)
+    {
+        unload_cell(cell, b_merged);
+    };
+    return callbacks;
+}
+
+void SceneStreaming::load_cell(const WorldCell& cell)
+{
+    running_loads.emplace_back(JobSystem::get().schedule(
+        [this, cell]
+        {
+            PROFILER_SCOPE(LoadSceneCell);
+            auto cell_scene = std::make_unique<Scene>(loader(cell));
+            {
+                std::lock_guard lk(loaded_mtx);
+                loaded_cells.insert_or_assign(cell, std::move(cell_scene));
+            }
+            streamer.finish_load(cell);
+        }));
+}
+
+void SceneStreaming::merge_cell(const WorldCell& cell)
+{
+    PROFILER_SCOPE(MergeSceneCell);
+    std::unique_ptr<Scene> cell_scene;
+    {
+        std::lock_guard lk(loaded_mtx);
+        auto            found = loaded_cells.find(cell);
+        if (found == loaded_cells.end())
+        {
+            LOG_ERROR("Cell {}x{} (level {}) was not loaded", cell.x, cell.z, cell.level);
+            return;
+        }
+        cell_scene = std::move(found->second);
+        loaded_cells.erase(found);
+    }
+
+    // Keep track of the roots to destroy them on unload (refs stay valid when the allocations are moved to the scene)
+    auto& roots = merged_cells[cell];
+    for (const auto& root : cell_scene->get_nodes())
+        roots.emplace_back(root);
+    scene.merge_scene(*cell_scene);
+}
+
+void SceneStreaming::unload_cell(const WorldCell& cell, bool b_merged)
+{
+    if (!b_merged)
+    {
+        std::unique_ptr<Scene> cell_scene;
+        {
+            std::lock_guard lk(loaded_mtx);
+            if (auto found = loaded_cells.find(cell); found != loaded_cells.end())
+            {
+                cell_scene = std::move(found->second);
+                loaded_cells.erase(found);
+            }
+        }
+        // The chunk is destroyed outside of the lock
+        return;
+    }
+
+    PROFILER_SCOPE(UnloadSceneCell);
+    if (auto found = merged_cells.find(cell); found != merged_cells.end())
+    {
+        // Destroyed with the other components released this frame, during the next tick
+        for (const auto& root : found->second)
+            scene.destroy_deferred(root);
+        merged_cells.erase(found);
+    }
+}
+} // namespace Eng
@@ -2,15 +2,27 @@
 
 #include "engine.hpp"
 #include "profiler.hpp"
+#include "render_queue.hpp"
 #include "gfx/renderer/instance/render_pass_instance_base.hpp"
+#include "assets/material_instance_asset.hpp"
+#include "assets/mesh_asset.hpp"
 #include "gfx/vulkan/buffer.hpp"
+#include "gfx/vulkan/command_buffer.hpp"
+#include "gfx/vulkan/pipeline.hpp"
+#include "scene/scene.hpp"
 #include "scene/components/mesh_component.hpp"
 
+#include <bit>
 #include <glm/ext/matrix_float4x4.hpp>
 
 namespace Eng
 {
 
+struct MeshPushConstants
+{
+    glm::mat4 model;
+};
+
 struct SceneBufferData
 {
     glm::mat4 perspective_view_mat;
@@ -21,12 +33,32 @@ struct SceneBufferData
     glm::mat4 inv_perspective_mat;
 };
 
-void SceneView::pre_draw(const Gfx::RenderPassInstanceBase& render_pass)
+void SceneView::pre_draw(const Scene& scene, const Gfx::RenderPassInstanceBase& render_pass)
 {
     PROFILER_SCOPE(ScenePreDraw);
 
     update_matrices(render_pass.resolution(), render_pass.get_definition().reversed_logarithmic_depth);
 
+    // Visible components are usually collected by the scene with every other view. Fallback to a single query for new or modified views.
+    if (!b_culled || culled_projection_view != projection_view)
+    {
+        visible_components.clear();
+        scene.query_meshes(get_culling_planes(), visible_components);
+    }
+    b_culled = false;
+    scene.register_view(weak_from_this());
+
+    if (b_occlusion_culling)
+        occlusion_cull();
+
+    if (mobility != EViewMobility::All)
+        std::erase_if(visible_components,
+                      [this](const MeshComponent* component)
+                      {
+                          return component->is_static() != (mobility == EViewMobility::Static);
+                      });
+    update_content_signature();
+
     glm::mat4 inv_view             = inverse(view);
     glm::mat4 inv_perspective      = inverse(projection_view);
     glm::mat4 inv_perspective_view = inv_view * inv_perspective;
@@ -44,17 +76,168 @@ void SceneView::pre_draw(const Gfx::RenderPassInstanceBase& render_pass)
 void SceneView::pre_submit() const
 {
     view_buffer->wait_data_upload();
+    std::lock_guard lk(instance_buffers_mtx);
+    for (const auto& buffer : instance_buffers)
+        if (buffer)
+            buffer->wait_data_upload();
 }
 
-void SceneView::draw(const Scene& scene, const Gfx::RenderPassInstanceBase&, Gfx::CommandBuffer& command_buffer, size_t idx, size_t num_threads) const
+void SceneView::draw(const Scene&, const Gfx::RenderPassInstanceBase&, Gfx::CommandBuffer& command_buffer, size_t idx, size_t num_threads) const
 {
     PROFILER_SCOPE(SceneDraw);
-    scene.for_each_part<MeshComponent>(
-        [&command_buffer, this](MeshComponent& object)
+
+    // Visible components were collected in pre_draw, split them between the record threads
+    const size_t part_count = std::max(1llu, num_threads);
+    const size_t first      = visible_components.size() * idx / part_count;
+    const size_t last       = visible_components.size() * (idx + 1) / part_count;
+
+    // Each record thread sorts its own draws
+    thread_local std::vector<MeshDraw> draws;
+    thread_local RenderQueue           queue;
+    {
+        PROFILER_SCOPE(SortDraws);
+        draws.clear();
+        queue.clear();
+        for (size_t i = first; i < last; ++i)
+            visible_components[i]->collect_draws(draws, *this, command_buffer.render_pass());
+        queue.reserve(draws.size());
+        for (uint32_t i = 0; i < draws.size(); ++i)
+            queue.push(draws[i].sort_key, i);
+        queue.sort();
+    }
+
+    if (queue.size() == 0)
+        return;
+
+    // Write the model matrices in the sorted order : the draws of a batch read consecutive instances
+    thread_local std::vector<glm::mat4> instances;
+    thread_local std::vector<DrawBatch> batches;
+    std::shared_ptr<Gfx::Buffer>        instance_buffer;
+    {
+        PROFILER_SCOPE(BuildInstances);
+        instances.clear();
+        batches.clear();
+        instances.reserve(queue.size());
+        for (const auto& item : queue.items())
+            instances.emplace_back(draws[item.index].component->get_world_transform());
+        queue.build_batches(
+            [](uint32_t a, uint32_t b)
+            {
+                const MeshDrawPacket& draw_a = *draws[a].packet;
+                const MeshDrawPacket& draw_b = *draws[b].packet;
+                return draw_a.pipeline == draw_b.pipeline && draw_a.descriptors == draw_b.descriptors && draw_a.mesh == draw_b.mesh && draw_a.pipeline->uses_instance_stream();
+            },
+            batches);
+
+        std::lock_guard lk(instance_buffers_mtx);
+        if (instance_buffers.size() <= idx)
+            instance_buffers.resize(idx + 1);
+        if (!instance_buffers[idx])
+            instance_buffers[idx] = Gfx::Buffer::create("Instance_buffer", Engine::get().get_device(), Gfx::Buffer::CreateInfos{.usage = Gfx::EBufferUsage::VERTEX_DATA, .type = Gfx::EBufferType::IMMEDIATE},
+                                                        sizeof(glm::mat4), instances.size());
+        instance_buffer = instance_buffers[idx];
+    }
+    instance_buffer->set_data(0, Gfx::BufferData(instances));
+
+    PROFILER_SCOPE(SubmitDraws);
+    DrawStateTracker state;
+    bool             b_instance_buffer_bound = false;
+    for (const auto& batch : batches)
+    {
+        // Packets are read by reference : no lock or ref counting here
+        const MeshDrawPacket& packet      = *draws[queue.items()[batch.first].index].packet;
+        const bool            b_instanced = packet.pipeline->uses_instance_stream();
+        if (state.set_pipeline(packet.pipeline.get()))
+            command_buffer.bind_pipeline(packet.pipeline);
+        if (state.set_material(packet.descriptors.get()))
+            command_buffer.bind_descriptors(*packet.descriptors, *packet.pipeline);
+        if (b_instanced)
         {
-            object.draw(command_buffer, *this);
-        },
-        idx, std::max(1llu, num_threads));
+            if (!b_instance_buffer_bound)
+                command_buffer.bind_vertex_buffer(1, *instance_buffer);
+            b_instance_buffer_bound = true;
+        }
+        else
+            command_buffer.push_constant(Gfx::EShaderStage::Vertex, *packet.pipeline, Gfx::BufferData(MeshPushConstants{.model = instances[batch.first]}));
+        if (state.set_mesh(packet.mesh.get()))
+            command_buffer.bind_mesh(*packet.mesh);
+        command_buffer.draw_bound_mesh(*packet.mesh, batch.count, b_instanced ? batch.first : 0);
+        state.add_draw();
+    }
+    // Packets can be rebuilt before the next frame
+    draws.clear();
+}
+
+void SceneView::occlusion_cull()
+{
+    if (resolution.x == 0 || resolution.y == 0)
+        return;
+
+    PROFILER_SCOPE(SceneOcclusionCulling);
+    const uint32_t height = std::max(1u, static_cast<uint32_t>(static_cast<float>(OCCLUSION_WIDTH * resolution.y) / static_cast<float>(resolution.x)));
+    occlusion_buffer.begin(projection_view, {OCCLUSION_WIDTH, height}, b_reversed_z);
+    for (const auto& component : visible_components)
+    {
+        const TObjectRef<MeshAsset>& mesh = component->get_mesh();
+        if (mesh && mesh->has_occluder())
+            occlusion_buffer.add_occluder(mesh->get_occluder_vertices(), mesh->get_occluder_indices(), component->get_world_transform());
+    }
+
+    if (occlusion_buffer.polygon_count() == 0)
+        return;
+
+    {
+        PROFILER_SCOPE(RasterizeOccluders);
+        std::vector<JobHandle<void>> jobs;
+        for (uint32_t band = 0; band < occlusion_buffer.band_count(); ++band)
+            jobs.emplace_back(JobSystem::get().schedule(
+                [this, band]
+                {
+                    occlusion_buffer.rasterize_band(band);
+                }));
+        for (const auto& job : jobs)
+            job.await();
+    }
+
+    std::erase_if(visible_components,
+                  [this](MeshComponent* component)
+                  {
+                      return component->get_mesh() && !occlusion_buffer.test(component->get_world_transform() * component->get_mesh()->get_bounds());
+                  });
+}
+
+void SceneView::update_content_signature()
+{
+    const auto mix = [](uint64_t value)
+    {
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdull;
+        value ^= value >> 33;
+        value *= 0xc4ceb9fe1a85ec53ull;
+        value ^= value >> 33;
+        return value;
+    };
+
+    uint64_t signature = mix(visible_components.size());
+    for (int column = 0; column < 4; ++column)
+        for (int row = 0; row < 4; ++row)
+            signature = mix(signature ^ std::bit_cast<uint32_t>(projection_view[column][row]));
+
+    // The visible list order depends on the culling jobs : combine the components with an order independent sum
+    // Components relocated in memory are seen as different components (only causes an additional draw)
+    uint64_t components = 0;
+    for (const auto& component : visible_components)
+    {
+        // Edited materials update their descriptors : commands recorded with the previous ones can't be executed again
+        const TObjectRef<MeshAsset>& mesh      = component->get_mesh();
+        uint64_t                     revisions = mesh ? mesh->get_render_revision() : 0;
+        if (mesh)
+            for (const auto& section : mesh->get_sections())
+                if (section.material)
+                    revisions = mix(revisions ^ section.material->get_pipeline_revision() ^ mix(section.material->get_binding_revision()));
+        components += mix(reinterpret_cast<uintptr_t>(component) ^ mix(component->get_last_move_tick() ^ mix(revisions)));
+    }
+    content_signature = mix(signature ^ components);
 }
 
 void SceneView::set_position(const glm::vec3& in_position)
@@ -73,13 +256,37 @@ void SceneView::set_rotation(const glm::quat& in_rotation)
     outdated = true;
 }
 
+const CullingPlanes& SceneView::prepare_culling()
+{
+    update_matrices(resolution, b_reversed_z);
+    visible_components.clear();
+    culled_projection_view = projection_view;
+    b_culled               = true;
+    return get_culling_planes();
+}
+
+LightClusterView SceneView::get_light_cluster_view() const
+{
+    const float tan_half_fov = std::tan(glm::radians(fov) * 0.5f);
+    const float aspect       = resolution.x == 0 || resolution.y == 0 ? 1.f : static_cast<float>(resolution.x) / static_cast<float>(resolution.y);
+    return {.position        = position,
+            .forward         = rotation * glm::vec3{1, 0, 0},
+            .right           = rotation * glm::vec3{0, 1, 0},
+            .up              = rotation * glm::vec3{0, 0, 1},
+            .tan_half_width  = tan_half_fov * aspect,
+            .tan_half_height = tan_half_fov,
+            .z_near          = z_near,
+            .z_far           = z_far};
+}
+
 void SceneView::update_matrices(const glm::uvec2& in_resolution, bool reversed_z)
 {
-    if (!outdated && resolution == in_resolution)
+    if (!outdated && resolution == in_resolution && b_reversed_z == reversed_z)
         return;
     if (orthographic && reversed_z)
         LOG_ERROR("Reversed_z with orthographic perspectives is not supported");
-    outdated = false;
+    outdated     = false;
+    b_reversed_z = reversed_z;
 
     view       = translate(mat4_cast(inverse(rotation)), -position);
     resolution = in_resolution;
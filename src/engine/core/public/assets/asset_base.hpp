@@ -2,6 +2,7 @@
 
 #include "object_ptr.hpp"
 
+#include <atomic>
 #include <glm/vec3.hpp>
 #include "assets/asset_base.gen.hpp"
 
@@ -43,13 +44,22 @@ public:
         return {1, 1, 1};
     }
 
+    // Changes each time the render resources of this asset are modified. Values are taken from a global counter and never reused (even by another asset).
+    uint64_t get_render_revision() const
+    {
+        return render_revision.load(std::memory_order_acquire);
+    }
+
 protected:
-    AssetBase() = default;
+    AssetBase();
+
+    void mark_render_dirty();
 
 private:
     TObjectRef<AssetBase> this_ref_obj;
     friend class AssetRegistry;
-    char*          name;
-    AssetRegistry* registry;
+    char*                name;
+    AssetRegistry*       registry;
+    std::atomic_uint64_t render_revision;
 };
 } // namespace Eng
@@ -49,7 +49,9 @@ class MaterialAsset : public AssetBase
 public:
     MaterialAsset();
 
-    void set_shader_code(const std::filesystem::path& code, const std::optional<std::vector<StageInputOutputDescription>>& vertex_input_override = {});
+    // instance_input_override : attributes of the per instance vertex stream (see Gfx::Pipeline::CreateInfos::instance_inputs)
+    void set_shader_code(const std::filesystem::path& code, const std::optional<std::vector<StageInputOutputDescription>>& vertex_input_override = {},
+                         const std::optional<std::vector<StageInputOutputDescription>>& instance_input_override = {});
 
     Gfx::PermutationDescription get_default_permutation() const
     {
@@ -81,6 +83,7 @@ private:
     std::shared_ptr<ShaderCompiler::Session> compiler_session;
     std::filesystem::path                    shader_virtual_path;
     std::vector<StageInputOutputDescription> vertex_inputs;
+    std::vector<StageInputOutputDescription> instance_inputs;
     Spinlock                                 pipeline_mutex;
     Gfx::PipelineOptions                     options;
 };
@@ -11,6 +11,7 @@ namespace Eng
 {
 
 class SamplerAsset;
+class SceneView;
 class TextureAsset;
 struct MaterialPermutation;
 class MaterialAsset;
@@ -32,7 +33,10 @@ public:
     MaterialInstanceAsset(const TObjectRef<MaterialAsset>& base_material);
 
     std::shared_ptr<Gfx::Pipeline>      get_base_resource(const Gfx::RenderPassRef& render_pass_id);
-    std::shared_ptr<Gfx::DescriptorSet> get_descriptor_resource(const Gfx::RenderPassRef& render_pass_id);
+    // With a view, the descriptors are specific to this view of the pass and bind its scene data (ex : the tiles of the shadow atlas are drawn in the same pass)
+    std::shared_ptr<Gfx::DescriptorSet> get_descriptor_resource(const Gfx::RenderPassRef& render_pass_id, const SceneView* view = nullptr);
+    // Release the descriptors of a destroyed view (the ones of the other destroyed views are also released when a new view is drawn)
+    void release_view_descriptors(uint64_t view_id);
 
     void set_sampler(const std::string& binding, const TObjectRef<SamplerAsset>& sampler);
     void set_texture(const std::string& binding, const TObjectRef<TextureAsset>& texture);
@@ -40,7 +44,6 @@ public:
     void set_sampler(const Gfx::RenderPassRef& render_pass_id, const std::string& binding, const TObjectRef<SamplerAsset>& sampler);
     void set_texture(const Gfx::RenderPassRef& render_pass_id, const std::string& binding, const TObjectRef<TextureAsset>& texture);
     void set_buffer(const Gfx::RenderPassRef& render_pass_id, const std::string& binding, const std::weak_ptr<Gfx::Buffer>& buffer);
-    void set_scene_data(const Gfx::RenderPassRef& render_pass_id, const std::weak_ptr<Gfx::Buffer>& buffer);
 
     // Compile shader for given pass if available (avoid lag spike later)
     void prepare_for_passes(const Gfx::RenderPassGenericId& render_pass_id);
@@ -54,10 +57,40 @@ public:
 
     void set_permutation(const Gfx::PermutationDescription& perm);
 
+    // Also changes when the pipelines of the base material are recompiled
+    uint64_t get_pipeline_revision() const;
+
+    // Changes when a sampler, a texture or a buffer is bound to the existing descriptors
+    uint64_t get_binding_revision() const
+    {
+        return binding_revision.load(std::memory_order_acquire);
+    }
+
   private:
-    TObjectRef<MaterialAsset>                                                             base;
-    Spinlock                                                                              descriptor_lock;
-    ankerl::unordered_dense::map<Gfx::RenderPassRef, std::shared_ptr<Gfx::DescriptorSet>> descriptors;
+    struct DescriptorKey
+    {
+        Gfx::RenderPassRef render_pass;
+        uint64_t           view_id = 0; // 0 for the descriptors shared by every view of the pass
+
+        bool operator==(const DescriptorKey& other) const
+        {
+            return render_pass == other.render_pass && view_id == other.view_id;
+        }
+    };
+
+    struct DescriptorKeyHash
+    {
+        size_t operator()(const DescriptorKey& key) const
+        {
+            return std::hash<Gfx::RenderPassRef>()(key.render_pass) ^ std::hash<uint64_t>()(key.view_id) * 31;
+        }
+    };
+
+    TObjectRef<MaterialAsset>                                                                           base;
+    Spinlock                                                                                            descriptor_lock;
+    ankerl::unordered_dense::map<DescriptorKey, std::shared_ptr<Gfx::DescriptorSet>, DescriptorKeyHash> descriptors;
+    ankerl::unordered_dense::map<uint64_t, std::weak_ptr<const SceneView>>                              views; // Views owning descriptors
+    std::atomic_uint64_t                                                                                binding_revision = 0;
 
     Gfx::PermutationDescription        permutation_description;
     std::weak_ptr<MaterialPermutation> permutation;
@@ -74,8 +107,5 @@ public:
     ankerl::unordered_dense::map<std::string, TObjectRef<SamplerAsset>>   samplers;
     ankerl::unordered_dense::map<std::string, TObjectRef<TextureAsset>>   textures;
     ankerl::unordered_dense::map<std::string, std::weak_ptr<Gfx::Buffer>> buffers;
-
-    Spinlock                   test;
-    ankerl::unordered_dense::map<Gfx::RenderPassRef, std::weak_ptr<Gfx::Buffer>> last_scene_buffer;
 };
 } // namespace Eng
\ No newline at end of file
@@ -67,8 +67,29 @@ public:
         return bounds;
     }
 
+    // Simplified geometry rasterized by the cpu occlusion culling. It should stay inside the rendered mesh.
+    void set_occluder(std::vector<glm::vec3> vertices, std::vector<uint32_t> indices);
+
+    bool has_occluder() const
+    {
+        return !occluder_indices.empty();
+    }
+
+    const std::vector<glm::vec3>& get_occluder_vertices() const
+    {
+        return occluder_vertices;
+    }
+
+    const std::vector<uint32_t>& get_occluder_indices() const
+    {
+        return occluder_indices;
+    }
+
 private:
     Bounds               bounds;
     std::vector<Section> mesh_sections;
+
+    std::vector<glm::vec3> occluder_vertices;
+    std::vector<uint32_t>  occluder_indices;
 };
 } // namespace Eng
@@ -31,6 +31,7 @@ public:
         Gfx::ColorFormat  format        = Gfx::ColorFormat::UNDEFINED;
         Gfx::GenerateMips generate_mips = Gfx::GenerateMips::none();
         uint32_t          array_size    = 1;
+        bool              b_transparent = false; // Some texels are not fully opaque (cutouts are discarded by the default materials)
     };
 
     const std::shared_ptr<Gfx::ImageView>& get_view() const
@@ -42,6 +43,11 @@ public:
 
     static TObjectRef<TextureAsset> get_default_asset();
 
+    bool has_transparency() const
+    {
+        return infos.b_transparent;
+    }
+
     std::shared_ptr<Gfx::ImageView> get_thumbnail() override
     {
         return view;
@@ -1,7 +1,9 @@
 #pragma once
 #include "macros.hpp"
 #include "scene_component.hpp"
+#include "shadow_atlas.hpp"
 
+#include <functional>
 #include <glm/vec3.hpp>
 
 #include "scene/components/light_component.gen.hpp"
@@ -22,15 +24,22 @@ enum class ELightType
 class LightComponent : public SceneComponent
 {
     REFLECT_BODY()
+    friend class SceneShadows;
 
     LightComponent();
 
 
     void enable_shadow(ELightType light_type = ELightType::Stationary, bool enabled = true);
 
-    const std::shared_ptr<Gfx::RenderPassInstanceBase>& get_shadow_pass() const
+    bool has_shadows() const
     {
-        return shadow_update_pass;
+        return shadows;
+    }
+
+    // Location of the shadow map in the scene shadow atlas (see SceneShadows). Invalid if the atlas is full.
+    const ShadowAtlasTile& get_shadow_tile() const
+    {
+        return shadow_tile;
     }
 
     const std::shared_ptr<SceneView>& get_shadow_view() const
@@ -38,12 +47,25 @@ class LightComponent : public SceneComponent
         return shadow_view;
     }
 
+    // Lights with a radius only affect the clusters their sphere intersects, a radius of 0 means an infinite range (directional light)
+    void set_attenuation_radius(float in_radius)
+    {
+        attenuation_radius = in_radius;
+    }
+
+    float get_attenuation_radius() const
+    {
+        return attenuation_radius;
+    }
+
     void set_position(glm::vec3 in_position) override;
     void set_rotation(glm::quat in_rotation) override;
 
     void build_outliner(Gfx::ImGuiWrapper& ctx) override;
 
 protected:
+    void for_each_shadow_view(const std::function<void(SceneView&)>& callback) const;
+
     virtual void void_create_shadow_resources()
     {
 
@@ -54,10 +76,12 @@ protected:
     float                                        orthographic_width = 5000;
     float                                        z_far              = 5000;
     float                                        z_near             = -5000;
+    float                                        attenuation_radius = 0;
     bool                                         shadows            = false;
     ELightType                                   light_type         = ELightType::Stationary;
-    std::shared_ptr<Gfx::RenderPassInstanceBase> shadow_update_pass;
-    std::shared_ptr<SceneView>                   shadow_view;
+    std::shared_ptr<SceneView>                   shadow_view;         // Static casters
+    std::shared_ptr<SceneView>                   dynamic_shadow_view; // Dynamic casters
+    ShadowAtlasTile                              shadow_tile;
     uint32_t                                     shadow_map_id = 0;
 };
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 #pragma once
 #include "scene_component.hpp"
 
+#include <atomic>
+#include <memory>
+#include <span>
+#include <vector>
+
 #include "scene/components/mesh_component.gen.hpp"
 
 namespace Eng
@@ -19,19 +24,106 @@ namespace Eng
 class MeshAsset;
 }
 
+namespace Eng::Gfx
+{
+class Mesh;
+class Pipeline;
+class DescriptorSet;
+class RenderPassRef;
+class Buffer;
+}
+
 namespace Eng
 {
+class MeshComponent;
+
+// Resources of a mesh section for a render pass. Packets are cached by the component and only rebuilt when the mesh or a material changes.
+struct MeshDrawPacket
+{
+    Bounds                              bounds; // Local bounds of the section
+    TObjectRef<MaterialInstanceAsset>   material;
+    uint64_t                            material_revision = 0;
+    std::shared_ptr<Gfx::Mesh>          mesh;
+    std::shared_ptr<Gfx::Pipeline>      pipeline; // Null if the material is not available for this pass
+    std::shared_ptr<Gfx::DescriptorSet> descriptors;
+    uint16_t                            pipeline_id    = 0;
+    uint16_t                            descriptors_id = 0;
+    uint16_t                            mesh_id        = 0;
+    bool                                b_blended      = false;
+};
+
+// Draw of a mesh section for a render pass. Draws are collected then sorted by key before submission (see SceneView::draw)
+struct MeshDraw
+{
+    uint64_t              sort_key;
+    MeshComponent*        component;
+    const MeshDrawPacket* packet;
+};
 
 class MeshComponent : public SceneComponent
 {
     REFLECT_BODY();
+    friend class Scene;
 
   public:
     MeshComponent(const TObjectRef<MeshAsset>& in_mesh = {}) : mesh(in_mesh){};
+    ~MeshComponent() override;
 
-    void draw(Gfx::CommandBuffer& command_buffer, const SceneView& view);
+    // Append the draws of the visible sections. The component bounds are expected to be already culled against the view (see SceneView::pre_draw)
+    // A component should only be collected by one thread per render pass at a time.
+    void collect_draws(std::vector<MeshDraw>& out_draws, const SceneView& view, const Gfx::RenderPassRef& render_pass);
+
+    // The spatial index is updated during the next tick
+    void set_mesh(const TObjectRef<MeshAsset>& in_mesh);
+
+    const TObjectRef<MeshAsset>& get_mesh() const
+    {
+        return mesh;
+    }
+
+    // A component is static once it didn't move for STATIC_TICKS ticks (used to cache the shadows of the static casters)
+    static constexpr uint64_t STATIC_TICKS = 30;
+
+    bool is_static() const
+    {
+        return get_scene().get_tick_count() >= last_move_tick + STATIC_TICKS;
+    }
+
+    uint64_t get_last_move_tick() const
+    {
+        return last_move_tick;
+    }
+
+  protected:
+    void on_transform_changed() override;
+
+  private:
+    /**
+     * Draw packets of every section for one view of a render pass (a pass can draw several views, ex : the tiles of the shadow atlas).
+     * Each list is only modified by the thread recording this view.
+     */
+    struct PassDrawPackets
+    {
+        size_t                      pass_id;
+        uint64_t                    view_id;
+        PassDrawPackets*            next          = nullptr;
+        uint64_t                    mesh_revision = 0; // Revisions are unique : this also identifies the mesh asset
+        std::vector<MeshDrawPacket> packets;
+    };
+
+    PassDrawPackets& get_pass_packets(const Gfx::RenderPassRef& render_pass, const SceneView& view);
+    bool             are_packets_valid(const PassDrawPackets& pass_packets) const;
+    void             rebuild_packets(PassDrawPackets& pass_packets, const SceneView& view, const Gfx::RenderPassRef& render_pass);
+    // Release the packets and the descriptors of destroyed views. Called by the scene during the tick : the lists are not read by any render pass.
+    void             release_view_packets(std::span<const uint64_t> view_ids);
 
     TObjectRef<MeshAsset> mesh;
+
+    uint32_t spatial_proxy   = DynamicBvh::NULL_NODE;
+    bool     b_spatial_dirty = false;
+    uint64_t last_move_tick  = 0;
+    // Lock free list (insertion only) : render passes can be recorded in parallel
+    std::atomic<PassDrawPackets*> draw_packets = nullptr;
 };
 
 } // namespace Eng
@@ -60,6 +60,7 @@ public:
         obj_ptr->parent   = this_ref_tmp;
         obj_ptr->this_ref = obj_ptr;
         this_ref_tmp->children.emplace_back(obj_ptr);
+        obj_ptr->mark_transform_dirty();
         return obj_ptr;
     }
 
@@ -135,12 +136,25 @@ protected:
     {
     }
 
+    // Called when the world transform of this component is invalidated (including by a parent)
+    virtual void on_transform_changed()
+    {
+    }
+
 private:
+    /**
+     * A dirty component never has clean children : get_world_transform() cleans the parents first. The propagation stops at the children that
+     * are still dirty and were already notified during this tick, so repeated edits of a parent during the same frame don't walk its subtree
+     * again. A child left dirty since a previous tick is notified again : the listeners (spatial proxies, move tick) need to know it moved.
+     */
     void mark_transform_dirty()
     {
+        b_transform_dirty      = true;
+        transform_changed_tick = scene->get_tick_count();
+        on_transform_changed();
         for (const auto& child : children)
-            child->mark_transform_dirty();
-        b_transform_dirty = true;
+            if (child && (!child->b_transform_dirty || child->transform_changed_tick != transform_changed_tick))
+                child->mark_transform_dirty();
     }
 
     const char*                             name;
@@ -150,7 +164,8 @@ private:
     std::vector<TObjectPtr<SceneComponent>> children{};
 
 
-    bool      b_transform_dirty = true;
+    bool      b_transform_dirty      = true;
+    uint64_t  transform_changed_tick = UINT64_MAX;
     glm::mat4 world_transform{1};
 
     glm::vec3 position{0};
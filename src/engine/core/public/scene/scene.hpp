@@ -1,10 +1,14 @@
 #pragma once
+#include "dynamic_bvh.hpp"
 #include "logger.hpp"
 #include "macros.hpp"
 #include "object_allocator.hpp"
 #include "object_ptr.hpp"
 
+#include <functional>
+#include <span>
 #include <vector>
+#include <ankerl/unordered_dense.h>
 #include <glm/ext/matrix_float4x4.hpp>
 
 #include "scene/scene.gen.hpp"
@@ -38,20 +42,29 @@ class CommandBuffer;
 }
 
 class SceneComponent;
+class MeshComponent;
+class SceneView;
+class SceneShadows;
+struct CullingPlanes;
+
+struct SceneHit
+{
+    TObjectRef<MeshComponent> component;
+    float                     distance = 0;
+};
 
 class Scene final
 {
     REFLECT_BODY();
     friend class SceneComponent;
+    friend class MeshComponent;
+    friend class SceneStreaming;
 
 public:
     Scene();
     Scene(Scene&& other) = default;
 
-    ~Scene()
-    {
-        root_nodes.clear();
-    }
+    ~Scene();
 
     template <typename T, typename... Args> TObjectRef<T> add_component(const std::string& name, Args&&... args)
     {
@@ -69,11 +82,28 @@ public:
         TObjectPtr<T> obj_ptr(alloc);
         obj_ptr->this_ref = obj_ptr;
         root_nodes.emplace_back(obj_ptr);
+        obj_ptr->mark_transform_dirty();
         return obj_ptr;
     }
 
     void tick(double delta_second);
 
+    // Shadow atlas of the shadowed lights, created on first use
+    SceneShadows& get_shadows();
+
+    // Number of ticks since the creation of the scene
+    uint64_t get_tick_count() const
+    {
+        return tick_count;
+    }
+
+    /**
+     * Destroy the component (and its children) at the beginning of the next tick instead of immediately.
+     * Thread safe : components can be released during the frame (ex : while the scene is drawn) without running their destructor in place.
+     * Dropping the last TObjectPtr of a component is deferred the same way.
+     */
+    void destroy_deferred(const TObjectRef<SceneComponent>& component) const;
+
     template <typename T> void for_each(const std::function<void(T&)>& callback) const
     {
         allocator->for_each(callback);
@@ -112,17 +142,91 @@ public:
 
     void remove_custom_pass(const std::shared_ptr<Gfx::RenderPassInstanceBase>& pass) const;
 
+    /**
+     * Append every mesh component whose world bounds intersect the given planes (using the scene bvh).
+     * The spatial index is updated during tick(). Pointers are valid until the next scene modification.
+     */
+    void query_meshes(const CullingPlanes& planes, std::vector<MeshComponent*>& out_components) const;
+
+    // Same as query_meshes() for multiple views in a single bvh traversal
+    void query_meshes(std::span<const CullingPlanes> views, std::span<std::vector<MeshComponent*>* const> out_components) const;
+
+    /**
+     * Views drawn during the current frame are registered here (thread safe).
+     * At the end of the next tick they are all culled together, so their pre_draw don't need to query the scene again.
+     */
+    void register_view(const std::weak_ptr<SceneView>& view) const;
+
+    /**
+     * Spatial queries against the world bounds of the mesh components (the spatial index is updated during tick()).
+     * Queries can run concurrently. Pointers are valid until the next scene modification.
+     */
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, SceneHit& out_hit) const;
+    // Closest component within max_distance (distance to its bounds, 0 if the position is inside)
+    bool nearest(const glm::vec3& position, float max_distance, SceneHit& out_hit) const;
+    void overlap_box(const Bounds& bounds, std::vector<MeshComponent*>& out_components) const;
+    void overlap_sphere(const glm::vec3& center, float radius, std::vector<MeshComponent*>& out_components) const;
+
+    /**
+     * Run count independent queries split between the job system workers. query(index) is called once per index, returns when every query is done.
+     * ex : scene.query_batch(rays.size(), [&](size_t i) { scene.raycast(rays[i].origin, rays[i].direction, 100, hits[i]); });
+     */
+    void query_batch(size_t count, const std::function<void(size_t index)>& query) const;
+
+    const DynamicBvh& get_spatial_index() const
+    {
+        return mesh_bvh;
+    }
+
+    // Mesh component owning this bvh user data
+    const TObjectRef<MeshComponent>& get_spatial_component(uint32_t user_data) const
+    {
+        return spatial_components[user_data];
+    }
+
 private:
+    // Move the components of the other scene into this one immediately (merge() defers it to the next tick)
+    void merge_scene(Scene& other_scene);
+    // Run the deferred destructions then remove the destroyed roots
+    void flush_destroyed();
+    // Thread safe, the spatial index is updated during the next tick
+    void mark_spatial_dirty(const TObjectRef<MeshComponent>& component);
+    // Thread safe, the proxy of a destroyed component is removed during the next tick
+    void release_spatial_proxy(uint32_t proxy);
+    void remove_spatial_proxy(uint32_t proxy);
+    void remove_released_proxies();
+    void update_spatial_index();
+    void cull_views();
+    // Release the draw packets of the views destroyed since the last tick
+    void release_destroyed_views();
+
     std::weak_ptr<Gfx::CustomPassList> custom_passes;
 
     TObjectRef<CameraComponent> active_camera;
 
     glm::mat4 last_pv;
+    uint64_t  tick_count = 0;
 
     std::unique_ptr<std::mutex> merge_queue_mtx;
     std::vector<Scene>          scenes_to_merge;
 
+    std::unique_ptr<std::mutex>                     destroy_queue_mtx;
+    mutable std::vector<TObjectRef<SceneComponent>> destroy_queue;
+
     std::vector<TObjectPtr<SceneComponent>>    root_nodes;
     std::unique_ptr<ContiguousObjectAllocator> allocator;
+
+    DynamicBvh                             mesh_bvh;
+    std::vector<TObjectRef<MeshComponent>> spatial_components; // Indexed by bvh user data
+    std::vector<uint32_t>                  free_spatial_slots;
+    std::unique_ptr<std::mutex>            spatial_mtx;
+    std::vector<TObjectRef<MeshComponent>> spatial_dirty;
+    std::vector<uint32_t>                  released_spatial_proxies;
+
+    std::shared_ptr<SceneShadows> shadows;
+
+    std::unique_ptr<std::mutex>                                             views_mtx;
+    mutable std::vector<std::weak_ptr<SceneView>>                           registered_views;
+    mutable ankerl::unordered_dense::map<uint64_t, std::weak_ptr<SceneView>> drawn_views; // Every view that drew this scene, by id
 };
 } // namespace Eng
@@ -0,0 +1,85 @@
+#pragma once
+#include "object_ptr.hpp"
+#include "shadow_atlas.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace Eng
+{
+namespace Gfx
+{
+class RenderPassInstanceBase;
+}
+
+class Scene;
+class SceneView;
+class LightComponent;
+
+// View of a shadowed light and its location in the atlas
+struct ShadowTileView
+{
+    std::shared_ptr<SceneView> view;
+    ShadowAtlasTile            tile;
+};
+
+/**
+ * Shadow maps of every shadowed light of a scene, packed in a single depth atlas.
+ * Tiles are allocated during the scene tick from the screen space importance of each light's shadow volume.
+ * The static casters are drawn in a cached atlas pass and the dynamic ones in an overlay atlas with the same layout.
+ * Each pass records every tile (each record thread draws its share of every tile) and is skipped when none of its tiles changed.
+ */
+class SceneShadows
+{
+public:
+    static constexpr uint32_t ATLAS_SIZE    = 4096;
+    static constexpr uint32_t MIN_TILE_SIZE = 128;
+
+    SceneShadows(Scene& in_scene);
+    ~SceneShadows();
+
+    void add_light(const TObjectRef<LightComponent>& light);
+    void remove_light(const TObjectRef<LightComponent>& light);
+
+    // Allocate the atlas tiles for the active camera (called by the scene during tick)
+    void update();
+
+    // Atlas of the static casters
+    const std::shared_ptr<Gfx::RenderPassInstanceBase>& get_atlas_pass() const
+    {
+        return atlas_pass;
+    }
+
+    // Atlas of the dynamic casters
+    const std::shared_ptr<Gfx::RenderPassInstanceBase>& get_dynamic_atlas_pass() const
+    {
+        return dynamic_atlas_pass;
+    }
+
+    const std::vector<ShadowTileView>& get_tile_views(bool b_dynamic) const
+    {
+        return b_dynamic ? dynamic_tile_views : tile_views;
+    }
+
+    // Lights can be moved to another scene (see Scene::merge())
+    const std::vector<TObjectRef<LightComponent>>& get_lights() const
+    {
+        return lights;
+    }
+
+private:
+    void create_passes();
+
+    Scene*      scene;
+    ShadowAtlas atlas;
+
+    std::vector<TObjectRef<LightComponent>> lights;
+    std::vector<ShadowAtlasRequest>         requests;
+    std::vector<ShadowAtlasTile>            tiles;
+    std::vector<ShadowTileView>             tile_views;
+    std::vector<ShadowTileView>             dynamic_tile_views;
+
+    std::shared_ptr<Gfx::RenderPassInstanceBase> atlas_pass;
+    std::shared_ptr<Gfx::RenderPassInstanceBase> dynamic_atlas_pass;
+};
+} // namespace Eng
@@ -0,0 +1,68 @@
+#pragma once
+#include "object_ptr.hpp"
+#include "world_partition.hpp"
+#include "jobsys/job_sys.hpp"
+
+#include <ankerl/unordered_dense.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Eng
+{
+class Scene;
+class SceneComponent;
+
+/**
+ * Stream the cells of a world partition in and out of a scene.
+ * Each cell is an independent scene chunk built in the background by the loader (called from worker threads, ex : import of the cell file),
+ * then merged into the scene during update() within the time budget. Unloading a cell destroys the root components it brought.
+ */
+class SceneStreaming
+{
+public:
+    using CellLoader = std::function<Scene(const WorldCell& cell)>;
+
+    SceneStreaming(Scene& in_scene, const WorldPartition& partition, CellLoader in_loader);
+
+    // Wait for the running loads. Merged cells stay in the scene.
+    ~SceneStreaming();
+
+    // Should be called once per frame on the game thread, before Scene::tick()
+    void update(const glm::vec3& position);
+
+    // Maximum time spent merging or unloading cells per update (at least one cell is processed per update)
+    void set_budget(double in_budget_ms)
+    {
+        budget_ms = in_budget_ms;
+    }
+
+    WorldStreamer& get_streamer()
+    {
+        return streamer;
+    }
+
+    const WorldStreamingStats& get_stats() const
+    {
+        return streamer.get_stats();
+    }
+
+private:
+    WorldStreamer::Callbacks make_callbacks();
+    void                     load_cell(const WorldCell& cell);
+    void                     merge_cell(const WorldCell& cell);
+    void                     unload_cell(const WorldCell& cell, bool b_merged);
+
+    Scene&        scene;
+    CellLoader    loader;
+    WorldStreamer streamer;
+    double        budget_ms = 2.0;
+
+    std::mutex                                                      loaded_mtx;
+    ankerl::unordered_dense::map<WorldCell, std::unique_ptr<Scene>> loaded_cells;
+
+    ankerl::unordered_dense::map<WorldCell, std::vector<TObjectRef<SceneComponent>>> merged_cells;
+    std::vector<JobHandle<void>>                                                     running_loads;
+};
+} // namespace Eng
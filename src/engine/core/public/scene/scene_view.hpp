@@ -1,7 +1,14 @@
 #pragma once
 #include "bounds.hpp"
+#include "frustum_culling.hpp"
+#include "light_clusters.hpp"
+#include "occlusion_buffer.hpp"
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <vector>
+#include <glm/geometric.hpp>
 #include <glm/ext/matrix_float4x4.hpp>
 #include <glm/ext/quaternion_float.hpp>
 
@@ -15,6 +22,7 @@ class CommandBuffer;
 }
 
 class Scene;
+class MeshComponent;
 
 // Quickly grabbed from https://gist.github.com/podgorskiy/e698d18879588ada9014768e3e82a644
 class Frustum
@@ -45,8 +53,9 @@ class Frustum
         return res * (-1.0f / D);
     }
 
-    glm::vec4 m_planes[Count];
-    glm::vec3 m_points[4];
+    glm::vec4     m_planes[Count];
+    glm::vec3     m_points[4];
+    CullingPlanes culling_planes;
 
 public:
     Frustum() = default;
@@ -60,6 +69,9 @@ public:
         m_planes[Top]    = view_proj[3] - view_proj[1];
         m_planes[Near]   = view_proj[3] + view_proj[2];
 
+        for (const auto& plane : m_planes)
+            culling_planes.add_plane(plane);
+
         glm::vec3 crosses[Combinations] = {
             cross(glm::vec3(m_planes[Left]), glm::vec3(m_planes[Right])), cross(glm::vec3(m_planes[Left]), glm::vec3(m_planes[Bottom])), cross(glm::vec3(m_planes[Left]), glm::vec3(m_planes[Top])),
             cross(glm::vec3(m_planes[Left]), glm::vec3(m_planes[Near])), cross(glm::vec3(m_planes[Right]), glm::vec3(m_planes[Bottom])),
@@ -73,6 +85,12 @@ public:
         m_points[3] = intersection<Right, Top, Near>(crosses);
     }
 
+    // Planes used by the batch culling kernels
+    const CullingPlanes& get_culling_planes() const
+    {
+        return culling_planes;
+    }
+
     bool test(const Bounds& bounds) const
     {
         // check box outside/inside of frustum
@@ -123,15 +141,32 @@ public:
     }
 };
 
-class SceneView
+// Mesh components drawn by a view (see MeshComponent::is_static())
+enum class EViewMobility
 {
+    All,
+    Static,
+    Dynamic,
+};
+
+class SceneView : public std::enable_shared_from_this<SceneView>
+{
+    friend class Scene;
+
 public:
     static std::shared_ptr<SceneView> create()
     {
         return std::shared_ptr<SceneView>(new SceneView());
     }
 
-    void pre_draw(const Gfx::RenderPassInstanceBase& render_pass);
+    // Unique id, never reused by another view (the caches of the destroyed views are released using it)
+    uint64_t get_id() const
+    {
+        return id;
+    }
+
+    // Update the view matrices and collect the visible mesh components of the scene
+    void pre_draw(const Scene& scene, const Gfx::RenderPassInstanceBase& render_pass);
     void pre_submit() const;
     void draw(const Scene& scene, const Gfx::RenderPassInstanceBase& render_pass, Gfx::CommandBuffer& command_buffer, size_t idx, size_t num_threads) const;
 
@@ -153,6 +188,52 @@ public:
         return frustum.test(bounds);
     }
 
+    const CullingPlanes& get_culling_planes() const
+    {
+        return frustum.get_culling_planes();
+    }
+
+    // Distance to the view position divided by z_far (used to sort the draws)
+    float get_normalized_depth(const glm::vec3& world_position) const
+    {
+        return glm::length(world_position - position) / z_far;
+    }
+
+    // Rasterize the occluders of the visible meshes on the cpu and discard the meshes they hide
+    void set_occlusion_culling(bool b_enabled)
+    {
+        b_occlusion_culling = b_enabled;
+    }
+
+    const OcclusionBuffer& get_occlusion_buffer() const
+    {
+        return occlusion_buffer;
+    }
+
+    // Only draw the static or the dynamic components (ex : cached shadows of the static casters + dynamic overlay)
+    void set_mobility(EViewMobility in_mobility)
+    {
+        mobility = in_mobility;
+    }
+
+    /**
+     * Hash of the matrices and of the visible components (with their last move, mesh and material revisions), updated by pre_draw.
+     * If it did not change since the last rendered frame, the result of the draw would be the same.
+     */
+    uint64_t get_content_signature() const
+    {
+        return content_signature;
+    }
+
+    // Mesh components collected by pre_draw
+    size_t get_visible_count() const
+    {
+        return visible_components.size();
+    }
+
+    // Perspective parameters used to assign the lights to clusters (the view looks toward +x, horizontal axis is y)
+    LightClusterView get_light_cluster_view() const;
+
     void set_fov(float in_fov)
     {
         if (in_fov != fov)
@@ -204,12 +285,22 @@ public:
     }
 
   private:
-    SceneView()
+    SceneView() : id(next_id.fetch_add(1, std::memory_order_relaxed))
     {
     }
 
     void update_matrices(const glm::uvec2& in_resolution, bool reversed_z);
 
+    void occlusion_cull();
+
+    void update_content_signature();
+
+    // Called by the scene before culling this view with the others : update the matrices using the last known resolution and clear the visible list
+    const CullingPlanes& prepare_culling();
+
+    static inline std::atomic<uint64_t> next_id = 1;
+    uint64_t                            id;
+
     glm::quat rotation = glm::identity<glm::quat>();
     glm::vec3 position = {0, 0, 0};
 
@@ -225,7 +316,24 @@ public:
 
     Frustum frustum;
 
+    std::vector<MeshComponent*> visible_components;
+    // View matrix used to fill visible_components (if it doesn't match during pre_draw, the view is culled again)
+    glm::mat4 culled_projection_view;
+    bool      b_culled       = false;
+    bool      b_reversed_z   = false;
+
+    static constexpr uint32_t OCCLUSION_WIDTH     = 256;
+    bool                      b_occlusion_culling = false;
+    OcclusionBuffer           occlusion_buffer;
+
+    EViewMobility mobility          = EViewMobility::All;
+    uint64_t      content_signature = 0;
+
     std::shared_ptr<Gfx::Buffer> view_buffer;
+
+    // Per instance model matrices of the sorted draws, one buffer per record thread
+    mutable std::mutex                                instance_buffers_mtx;
+    mutable std::vector<std::shared_ptr<Gfx::Buffer>> instance_buffers;
 };
 
 
@@ -2,6 +2,7 @@
 
 #include "gfx/vulkan/swapchain.hpp"
 #include "logger.hpp"
+#include "render_graph_schedule.hpp"
 
 #include <ranges>
 
@@ -57,6 +58,23 @@ Renderer Renderer::compile(ColorFormat target_format, const std::weak_ptr<Device
     if (!root)
         LOG_FATAL("Failed to compile renderer, no root");
 
+    // The instances are executed following a flat plan (see RenderPassInstanceBase::compile_plan()) : make sure one exists
+    ankerl::unordered_dense::map<RenderPassGenericId, uint32_t> node_indices;
+    for (const auto& node_name : copy.nodes | std::views::keys)
+        node_indices.emplace(node_name, static_cast<uint32_t>(node_indices.size()));
+    std::vector<std::vector<uint32_t>> dependencies;
+    for (const auto& node : copy.nodes | std::views::values)
+    {
+        auto& node_dependencies = dependencies.emplace_back();
+        for (const auto& require : node.dependencies)
+            if (auto found = node_indices.find(require); found != node_indices.end())
+                node_dependencies.emplace_back(found->second);
+            else
+                LOG_FATAL("Failed to compile renderer : {} requires unknown render pass {}", node.render_pass_ref, require);
+    }
+    if (!RenderGraphSchedule{}.build(dependencies))
+        LOG_FATAL("Failed to compile renderer : circular dependency");
+
     for (auto& node : copy.nodes)
     {
         node.second.render_pass_ref.id = ++UNIQUE_PASS_ID;
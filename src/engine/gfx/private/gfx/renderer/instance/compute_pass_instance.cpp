@@ -1,5 +1,8 @@
 #include "gfx/renderer/instance/compute_pass_instance.hpp"
 
+#include "profiler.hpp"
+#include "gfx/vulkan/command_buffer.hpp"
+
 namespace Eng::Gfx
 {
 
@@ -7,7 +10,32 @@ ComputePassInstance::ComputePassInstance(std::weak_ptr<Device> device, const Ren
 {
 }
 
-void ComputePassInstance::render_internal(SwapchainImageId, DeviceImageId)
+void ComputePassInstance::render_internal(SwapchainImageId swapchain_image, DeviceImageId device_image)
 {
+    // Recorded on the async compute queue when available : the graphic passes that do not depend on it keep running
+    CommandBuffer& cmd = command_buffers->begin_primary(device_image);
+    write_begin_timestamp(cmd, device_image);
+
+    if (render_pass_interface)
+    {
+        PROFILER_SCOPE(PreDraw);
+        render_pass_interface->pre_draw(*this);
+    }
+
+    if (!render_pass_interface || render_pass_interface->should_render(*this))
+    {
+        record_begin_barriers(cmd, swapchain_image);
+        fill_command_buffer(cmd, 0);
+        record_end_barriers(cmd, swapchain_image);
+    }
+    write_end_timestamp(cmd, device_image);
+    cmd.end();
+
+    if (render_pass_interface)
+    {
+        PROFILER_SCOPE(PreSubmit);
+        render_pass_interface->pre_submit(*this);
+    }
+    submit(cmd, device_image);
 }
 }
\ No newline at end of file
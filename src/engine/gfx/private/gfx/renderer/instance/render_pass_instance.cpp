@@ -9,19 +9,33 @@
 #include "profiler.hpp"
 #include "gfx/vulkan/image.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <optional>
+
 namespace Eng::Gfx
 {
 FrameResources* RenderPassInstance::create_or_resize(const glm::uvec2& viewport, const glm::uvec2& parent, bool b_force)
 {
     if (auto* resources = RenderPassInstanceBase::create_or_resize(viewport, parent, b_force))
     {
-        for (uint8_t i = 0; i < get_image_count(); ++i)
-            resources->framebuffers.push_back(Framebuffer::create(device(), *this, i, *resources));
+        create_framebuffers(*resources);
         return resources;
     }
     return nullptr;
 }
 
+void RenderPassInstance::create_framebuffers(FrameResources& resources)
+{
+    for (uint8_t i = 0; i < get_image_count(); ++i)
+        resources.framebuffers.push_back(Framebuffer::create(device(), *this, i, resources));
+}
+
+bool RenderPassInstance::is_present_pass() const
+{
+    return render_pass_resource.lock()->get_key().b_present;
+}
+
 RenderPassInstance::RenderPassInstance(std::weak_ptr<Device> in_device, const Renderer& renderer, const RenderPassGenericId& name, bool b_is_present) : RenderPassInstanceBase(std::move(in_device), renderer, name)
 {
     render_pass_resource = device().lock()->declare_render_pass(get_definition().get_key(b_is_present), name);
@@ -39,7 +53,37 @@ void RenderPassInstance::render_internal(SwapchainImageId swapchain_image, Devic
     const auto* framebuffer = get_current_framebuffer(swapchain_image);
     if (!framebuffer)
         return;
-    CommandBuffer&             global_cmd = command_buffers->begin_primary(device_image);
+    CommandBuffer& global_cmd = command_buffers->begin_primary(device_image);
+    write_begin_timestamp(global_cmd, device_image);
+
+    if (render_pass_interface)
+    {
+        PROFILER_SCOPE(PreDraw);
+        render_pass_interface->pre_draw(*this);
+    }
+
+    // Skipped passes still submit an empty command buffer to signal their timeline semaphore
+    if (!render_pass_interface || render_pass_interface->should_render(*this))
+    {
+        record_begin_barriers(global_cmd, swapchain_image);
+        record_render_pass(global_cmd, *framebuffer, device_image);
+        record_end_barriers(global_cmd, swapchain_image);
+    }
+    write_end_timestamp(global_cmd, device_image);
+    global_cmd.end();
+
+    PROFILER_MARKER_NAMED(std::format("{} : {} draws, {} redundant commands skipped", get_definition().render_pass_ref, global_cmd.get_stats().draws, global_cmd.get_stats().skipped()));
+
+    if (render_pass_interface)
+    {
+        PROFILER_SCOPE(PreSubmit);
+        render_pass_interface->pre_submit(*this);
+    }
+    submit(global_cmd, device_image);
+}
+
+void RenderPassInstance::record_render_pass(CommandBuffer& global_cmd, const Framebuffer& framebuffer, DeviceImageId device_image)
+{
     global_cmd.begin_debug_marker("BeginRenderPass_" + get_definition().render_pass_ref.to_string(), {1, 0, 0, 1});
 
     // Begin draw pass
@@ -64,7 +108,7 @@ void RenderPassInstance::render_internal(SwapchainImageId swapchain_image, Devic
     const VkRenderPassBeginInfo begin_infos = {
         .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
         .renderPass = render_pass_resource.lock()->raw(),
-        .framebuffer = framebuffer->raw(),
+        .framebuffer = framebuffer.raw(),
         .renderArea =
         {
             .offset = {0, 0},
@@ -73,28 +117,41 @@ void RenderPassInstance::render_internal(SwapchainImageId swapchain_image, Devic
         .clearValueCount = static_cast<uint32_t>(clear_values.size()),
         .pClearValues = clear_values.data(),
     };
-    global_cmd.begin_render_pass(get_definition().render_pass_ref, begin_infos, enable_parallel_rendering());
+    // Few draws are recorded by a single job : each secondary command buffer has a fixed cost
+    const std::optional<size_t> draw_count = render_pass_interface ? render_pass_interface->get_draw_count(*this) : std::nullopt;
+    record_jobs                            = enable_parallel_rendering() ? record_job_estimator.get_job_count(draw_count, static_cast<uint32_t>(render_pass_interface->record_threads())) : 1;
+    PROFILER_COUNTER_NAMED(std::format("{} record jobs", get_definition().render_pass_ref), record_jobs);
+
+    // Passes with a content signature always record secondary command buffers to reuse them (except with imgui : its draws change every frame)
+    const uint64_t content_signature = render_pass_interface && !imgui_context ? render_pass_interface->get_content_signature(*this) : 0;
+    const bool     b_secondaries     = record_jobs > 1 || content_signature != 0;
+    if (device().lock()->use_dynamic_rendering())
+        begin_rendering(global_cmd, framebuffer, clear_values, b_secondaries);
+    else
+        global_cmd.begin_render_pass(get_definition().render_pass_ref, begin_infos, b_secondaries);
 
-    if (render_pass_interface)
+    std::atomic<int64_t> record_duration = 0; // Sum of the recording time of every job (ns)
+    if (b_secondaries && command_buffers->reuse_secondaries(device_image, framebuffer, content_signature, global_cmd))
     {
-        PROFILER_SCOPE(PreDraw);
-        render_pass_interface->pre_draw(*this);
+        // Nothing changed since this image was recorded
+        PROFILER_MARKER(ReuseSecondaryCommandBuffers);
     }
-
-    if (enable_parallel_rendering())
+    else if (b_secondaries)
     {
         PROFILER_SCOPE(BuildCommandBufferAsync);
         std::vector<JobHandle<CommandBuffer*>> handles;
         // Jobs for other threads
-        for (size_t i = 0; i < std::max(1ull, render_pass_interface->record_threads()); ++i)
+        for (size_t i = 0; i < record_jobs; ++i)
         {
             handles.emplace_back(JobSystem::get().schedule<CommandBuffer*>(
-                [this, &framebuffer, i, &global_cmd, device_image]
+                [this, &framebuffer, i, &global_cmd, device_image, &record_duration]
                 {
-                    auto& cmd = command_buffers->begin_secondary(device_image, *framebuffer, global_cmd);
+                    const auto start = std::chrono::steady_clock::now();
+                    auto&      cmd   = command_buffers->begin_secondary(device_image, framebuffer, global_cmd);
                     cmd.thread_lock();
                     fill_command_buffer(cmd, i);
                     cmd.thread_unlock();
+                    record_duration.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
                     return &cmd;
                 }));
         }
@@ -104,42 +161,61 @@ void RenderPassInstance::render_internal(SwapchainImageId swapchain_image, Devic
 
         for (const auto& handle : handles)
             handle.await()->end();
+        if (draw_count)
+            record_job_estimator.add_sample(*draw_count, std::chrono::nanoseconds(record_duration.load(std::memory_order_relaxed)));
     }
     else
     {
         PROFILER_SCOPE(BuildCommandBufferSync);
+        const auto start = std::chrono::steady_clock::now();
         fill_command_buffer(global_cmd, 0);
+        if (draw_count)
+            record_job_estimator.add_sample(*draw_count, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
     }
+    PROFILER_COUNTER_NAMED(std::format("{} draw record cost (ns)", get_definition().render_pass_ref), record_job_estimator.get_draw_cost().count());
 
     // End command current_thread
     global_cmd.end_render_pass();
     global_cmd.end_debug_marker();
-    global_cmd.end();
+}
 
-    if (render_pass_interface)
-    {
-        PROFILER_SCOPE(PreSubmit);
-        render_pass_interface->pre_submit(*this);
-    }
+void RenderPassInstance::begin_rendering(CommandBuffer& global_cmd, const Framebuffer& framebuffer, const std::vector<VkClearValue>& clear_values, bool b_secondaries) const
+{
+    // Same load and store operations as the render pass (see VkRendererPass), the layouts are planned by the render graph
+    const auto&                              attachments = render_pass_resource.lock()->get_key().attachments;
+    std::vector<VkRenderingAttachmentInfo>   color_attachments;
+    std::optional<VkRenderingAttachmentInfo> depth_attachment;
+    for (size_t i = 0; i < attachments.size(); ++i)
     {
-        PROFILER_SCOPE_NAMED(RenderPass_Draw, std::format("Submit command buffer for draw pass {}", get_definition().render_pass_ref));
-        // Submit current_thread (wait children completion using children_semaphores)
-        std::vector<VkSemaphore>          children_semaphores = get_semaphores_to_wait(device_image);
-        std::vector<VkPipelineStageFlags> wait_stage(children_semaphores.size(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
-        const auto                        command_buffer_ptr            = global_cmd.raw();
-        const auto                        render_finished_semaphore_ptr = get_render_finished_semaphore();
-        const VkSubmitInfo                submit_infos{
-            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .waitSemaphoreCount = static_cast<uint32_t>(children_semaphores.size()),
-            .pWaitSemaphores = children_semaphores.data(),
-            .pWaitDstStageMask = wait_stage.data(),
-            .commandBufferCount = 1,
-            .pCommandBuffers = &command_buffer_ptr,
-            .signalSemaphoreCount = 1,
-            .pSignalSemaphores = &render_finished_semaphore_ptr,
+        const bool                      b_depth = is_depth_format(attachments[i].color_format);
+        const VkRenderingAttachmentInfo attachment_infos{
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .imageView = framebuffer.get_views()[i],
+            .imageLayout = b_depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .loadOp = attachments[i].has_clear() ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .clearValue = clear_values[i],
         };
-        global_cmd.submit(submit_infos, get_render_finished_fence(device_image));
+        if (b_depth)
+            depth_attachment = attachment_infos;
+        else
+            color_attachments.emplace_back(attachment_infos);
     }
+
+    const VkRenderingInfo rendering_infos{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+        .flags = b_secondaries ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : static_cast<VkRenderingFlags>(0),
+        .renderArea =
+        {
+            .offset = {0, 0},
+            .extent = {resolution().x, resolution().y},
+        },
+        .layerCount = 1,
+        .colorAttachmentCount = static_cast<uint32_t>(color_attachments.size()),
+        .pColorAttachments = color_attachments.data(),
+        .pDepthAttachment = depth_attachment ? &*depth_attachment : nullptr,
+    };
+    global_cmd.begin_rendering(get_definition().render_pass_ref, rendering_infos);
 }
 
 void RenderPassInstance::fill_command_buffer(CommandBuffer& cmd, size_t group_index) const
@@ -12,18 +12,181 @@
 #include "gfx/vulkan/semaphore.hpp"
 #include "jobsys/job_sys.hpp"
 
+#include <algorithm>
+#include <array>
+
 namespace Eng::Gfx
 {
+// Incremented when a custom pass is added or removed, or when the attachments of a pass are created again
+static std::atomic<uint64_t> GRAPH_REVISION = 0;
 
-std::vector<VkSemaphore> RenderPassInstanceBase::get_semaphores_to_wait(DeviceImageId image) const
+// Pipeline stages, memory accesses and layout of an image used with the given accesses
+struct AccessInfos
 {
-    std::vector<VkSemaphore> children_semaphores;
-    for_each_dependency(
-        [&](const std::shared_ptr<RenderPassInstanceBase>& dep)
-        {
-            children_semaphores.emplace_back(dep->render_finished_semaphores[image]->raw());
+    VkPipelineStageFlags stages = 0;
+    VkAccessFlags        access = 0;
+    VkImageLayout        layout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+static AccessInfos get_access_infos(ResourceAccess access)
+{
+    AccessInfos infos;
+    if (access & RESOURCE_ACCESS_COLOR_ATTACHMENT)
+    {
+        infos.stages |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        infos.access |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        infos.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    }
+    if (access & RESOURCE_ACCESS_DEPTH_ATTACHMENT)
+    {
+        infos.stages |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        infos.access |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        infos.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    }
+    if (access & RESOURCE_ACCESS_FRAGMENT_READ)
+    {
+        infos.stages |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        infos.access |= VK_ACCESS_SHADER_READ_BIT;
+        infos.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    if (access & RESOURCE_ACCESS_COMPUTE_READ)
+    {
+        infos.stages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        infos.access |= VK_ACCESS_SHADER_READ_BIT;
+        infos.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    if (access & RESOURCE_ACCESS_COMPUTE_WRITE)
+    {
+        infos.stages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        infos.access |= VK_ACCESS_SHADER_WRITE_BIT;
+        infos.layout = VK_IMAGE_LAYOUT_GENERAL;
+    }
+    if (access & RESOURCE_ACCESS_PRESENT)
+    {
+        infos.stages |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        infos.layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    }
+    return infos;
+}
+
+static VkImageAspectFlags get_aspect(ColorFormat format)
+{
+    if (!is_depth_format(format))
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    if (format == ColorFormat::D16_UNORM_S8_UINT || format == ColorFormat::D24_UNORM_S8_UINT || format == ColorFormat::D32_SFLOAT_S8_UINT)
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    return VK_IMAGE_ASPECT_DEPTH_BIT;
+}
+
+// Stages that can be used on a queue without graphics capabilities
+static constexpr VkPipelineStageFlags COMPUTE_QUEUE_STAGES = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT |
+                                                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+void RenderPassInstanceBase::get_semaphores_to_wait(DeviceImageId, std::vector<VkSemaphoreSubmitInfo>& semaphores) const
+{
+    for (size_t i = 0; i < plan_waits.size(); ++i)
+        semaphores.emplace_back(VkSemaphoreSubmitInfo{
+            .sType     = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .semaphore = plan_waits[i]->timeline_semaphore->raw(),
+            .value     = plan_waits[i]->timeline_semaphore->get_submitted_value(),
+            .stageMask = plan_wait_stages[i],
         });
-    return children_semaphores;
+}
+
+void RenderPassInstanceBase::submit(CommandBuffer& cmd, DeviceImageId device_image)
+{
+    pending_submit.cmd = &cmd;
+    pending_submit.waits.clear();
+    get_semaphores_to_wait(device_image, pending_submit.waits);
+
+    // The consumers wait for the timeline value, the presentation engine only supports binary semaphores
+    pending_submit.signals[0] = VkSemaphoreSubmitInfo{
+        .sType     = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+        .semaphore = timeline_semaphore->raw(),
+        .value     = timeline_semaphore->next_value(),
+        .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+    };
+    pending_submit.signal_count = 1;
+    if (!render_finished_semaphores.empty())
+        pending_submit.signals[pending_submit.signal_count++] = VkSemaphoreSubmitInfo{
+            .sType     = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .semaphore = get_render_finished_semaphore(),
+            .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        };
+    pending_submit.fence = get_render_finished_fence(device_image);
+}
+
+void RenderPassInstanceBase::record_begin_barriers(const CommandBuffer& cmd, SwapchainImageId image)
+{
+    record_barriers(cmd, begin_barriers, image);
+}
+
+void RenderPassInstanceBase::record_end_barriers(const CommandBuffer& cmd, SwapchainImageId image)
+{
+    record_barriers(cmd, end_barriers, image);
+}
+
+void RenderPassInstanceBase::write_begin_timestamp(const CommandBuffer& cmd, DeviceImageId image)
+{
+    if (!Profiler::get().is_recording())
+    {
+        if (timestamp_queries)
+            timestamp_queries->discard();
+        return;
+    }
+
+    const auto device_ptr = device().lock();
+    if (!timestamp_queries)
+    {
+        // Some queues cannot write timestamps
+        const auto pass_queue = device_ptr->get_queues().get_queue(queue);
+        if (!pass_queue || pass_queue->timestamp_valid_bits() == 0)
+            return;
+        timestamp_queries = std::make_unique<TimestampQueries>(get_definition().render_pass_ref.to_string() + "_timestamps", device(), device_ptr->get_image_count());
+    }
+
+    uint64_t                              begin_ticks, end_ticks;
+    std::chrono::steady_clock::time_point recorded_time;
+    if (timestamp_queries->read(image, begin_ticks, end_ticks, recorded_time))
+    {
+        const auto start = device_ptr->gpu_to_cpu_time(begin_ticks, recorded_time);
+        const auto end   = device_ptr->gpu_to_cpu_time(end_ticks, recorded_time);
+        Profiler::get().add_gpu_event({get_definition().render_pass_ref.to_string(), start, end});
+    }
+    timestamp_queries->write_begin(cmd, image);
+}
+
+void RenderPassInstanceBase::write_end_timestamp(const CommandBuffer& cmd, DeviceImageId image)
+{
+    if (timestamp_queries)
+        timestamp_queries->write_end(cmd, image);
+}
+
+void RenderPassInstanceBase::record_barriers(const CommandBuffer& cmd, const PlannedBarriers& planned, SwapchainImageId image)
+{
+    if (planned.barriers.empty())
+        return;
+    image_barriers.clear();
+    for (const auto& barrier : planned.barriers)
+        image_barriers.emplace_back(VkImageMemoryBarrier{
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask       = barrier.src_access,
+            .dstAccessMask       = barrier.dst_access,
+            .oldLayout           = barrier.old_layout,
+            .newLayout           = barrier.new_layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = barrier.image->raw_image(image),
+            .subresourceRange =
+            {
+                .aspectMask     = barrier.aspect,
+                .baseMipLevel   = 0,
+                .levelCount     = VK_REMAINING_MIP_LEVELS,
+                .baseArrayLayer = 0,
+                .layerCount     = VK_REMAINING_ARRAY_LAYERS,
+            },
+        });
+    vkCmdPipelineBarrier(cmd.raw(), planned.src_stages, planned.dst_stages, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(image_barriers.size()), image_barriers.data());
 }
 
 void RenderPassInstanceBase::init()
@@ -36,12 +199,15 @@ void RenderPassInstanceBase::init()
     }
 }
 
-RenderPassInstanceBase::RenderPassInstanceBase(std::weak_ptr<Device> in_device, const Renderer& renderer, const RenderPassGenericId& id) : DeviceResource(id, std::move(in_device)), definition(renderer.get_node(id))
+RenderPassInstanceBase::RenderPassInstanceBase(std::weak_ptr<Device> in_device, const Renderer& renderer, const RenderPassGenericId& id) : DeviceResource(id, std::move(in_device)), submit_batch(device()), definition(renderer.get_node(id))
 {
     assert(renderer.compiled());
     custom_passes = renderer.get_custom_passes();
 
-    command_buffers = std::make_unique<PassCommandPool>(device(), get_definition().render_pass_ref.generic_id());
+    if (definition.b_is_compute_pass && device().lock()->get_queues().get_queue(QueueSpecialization::AsyncCompute))
+        queue = QueueSpecialization::AsyncCompute;
+    command_buffers    = std::make_unique<PassCommandPool>(device(), get_definition().render_pass_ref.generic_id(), queue);
+    timeline_semaphore = TimelineSemaphore::create(std::format("Render finished timeline : {}", definition.render_pass_ref), device());
 
     // Init draw pass tree
     for (const auto& dependency : definition.dependencies)
@@ -53,45 +219,315 @@ RenderPassInstanceBase::RenderPassInstanceBase(std::weak_ptr<Device> in_device,
 
 void RenderPassInstanceBase::render(SwapchainImageId swapchain_image, DeviceImageId device_image)
 {
-    // Ensure our pass is not called twice. Use reset_for_next_frame() before each frame
-    if (prepared)
-        return;
+    if (plan_revision != GRAPH_REVISION.load(std::memory_order_acquire))
+    {
+        compile_plan();
+        alias_attachments();
+        compile_barriers();
+    }
 
-    PROFILER_SCOPE_NAMED(RenderPass_Draw, std::format("Render pass {}", get_definition().render_pass_ref));
-    prepared                = true;
-    current_swapchain_image = swapchain_image;
+    for (uint32_t node = 1; node < plan.node_count(); ++node)
+        plan_pending[node].store(static_cast<uint32_t>(plan.get_waits(node).size()), std::memory_order_relaxed);
+
+    // Passes without dependencies are started right away (the first one on this thread), the others are started by the last dependency they wait
+    const auto leaves = plan.get_level_nodes(0);
+    plan_workers.store(static_cast<uint32_t>(std::ranges::count_if(leaves, [](uint32_t node) { return node != 0; })), std::memory_order_relaxed);
+    for (size_t i = 1; i < leaves.size(); ++i)
+        JobSystem::get().schedule<void>(
+            [this, node = leaves[i], device_image]
+            {
+                render_plan_node(node, device_image);
+            });
+    if (leaves.front() != 0)
+        render_plan_node(leaves.front(), device_image);
 
-    std::vector<std::pair<RenderPassGenericId, JobHandle<void>>> render_jobs;
+    {
+        // Every pass of the plan leads to the root : once the workers returned, its dependencies are rendered and nobody reads the plan anymore
+        PROFILER_SCOPE_NAMED(RenderPass_Draw, std::format("Wait child passes of '{}' submitted", get_definition().render_pass_ref));
+        for (uint32_t remaining = plan_workers.load(std::memory_order_acquire); remaining != 0; remaining = plan_workers.load(std::memory_order_acquire))
+            plan_workers.wait(remaining, std::memory_order_acquire);
+    }
 
-    std::vector<std::shared_ptr<RenderPassInstanceBase>> found_dependencies;
-    for_each_dependency(
-        [&](const std::shared_ptr<RenderPassInstanceBase>& dep)
+    {
+        PROFILER_SCOPE_NAMED(RenderPass_Draw, std::format("Render pass {}", get_definition().render_pass_ref));
+        current_swapchain_image = swapchain_image;
+        render_internal(swapchain_image, device_image);
+    }
+
+    // The plan order runs the dependencies first : every wait of a queue is signaled by a batch submitted before, or on another queue
+    PROFILER_SCOPE_NAMED(RenderGraph_Submit, std::format("Submit render graph {}", get_definition().render_pass_ref));
+    for (uint32_t node : plan.get_order())
+    {
+        PendingSubmit& pending = plan_passes[node]->pending_submit;
+        if (!pending.cmd)
+            continue;
+        submit_batch.add(*pending.cmd, pending.waits, std::span(pending.signals).first(pending.signal_count), pending.fence);
+        pending.cmd = nullptr;
+    }
+    [[maybe_unused]] const uint32_t submits = submit_batch.flush();
+    PROFILER_COUNTER(QueueSubmits, submits);
+}
+
+void RenderPassInstanceBase::render_plan_node(uint32_t node, DeviceImageId device_image)
+{
+    while (true)
+    {
         {
-            found_dependencies.emplace_back(dep);
-        });
+            RenderPassInstanceBase* pass = plan_passes[node];
+            PROFILER_SCOPE_NAMED(RenderPass_Draw, std::format("Render pass {}", pass->get_definition().render_pass_ref));
+            pass->current_swapchain_image = device_image;
+            pass->render_internal(device_image, device_image);
+        }
+
+        // Continue with the first consumer that is ready on this thread, start the other ones in new jobs
+        uint32_t next = UINT32_MAX;
+        for (uint32_t consumer : plan.get_consumers(node))
+        {
+            // The root is rendered by render() once the workers are joined
+            if (consumer == 0 || plan_pending[consumer].fetch_sub(1, std::memory_order_acq_rel) != 1)
+                continue;
+            if (next == UINT32_MAX)
+                next = consumer;
+            else
+            {
+                plan_workers.fetch_add(1, std::memory_order_relaxed);
+                JobSystem::get().schedule<void>(
+                    [this, consumer, device_image]
+                    {
+                        render_plan_node(consumer, device_image);
+                    });
+            }
+        }
+        if (next == UINT32_MAX)
+            break;
+        node = next;
+    }
+
+    // This thread does not read the plan anymore
+    if (plan_workers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        plan_workers.notify_all();
+}
 
-    if (found_dependencies.size() > 1)
+void RenderPassInstanceBase::compile_plan()
+{
+    PROFILER_SCOPE_NAMED(RenderPass_Draw, std::format("Compile render graph {}", get_definition().render_pass_ref));
+    plan_revision = GRAPH_REVISION.load(std::memory_order_acquire);
+    plan_passes.clear();
+    plan_references.clear();
+
+    // Index every pass once, even if it is required by multiple passes
+    ankerl::unordered_dense::map<const RenderPassInstanceBase*, uint32_t> indices;
+    std::vector<std::vector<uint32_t>>                                    dependencies;
+    const std::function<uint32_t(RenderPassInstanceBase*)>                visit = [&](RenderPassInstanceBase* pass) -> uint32_t
+    {
+        if (auto found = indices.find(pass); found != indices.end())
+            return found->second;
+        const auto index = static_cast<uint32_t>(plan_passes.size());
+        indices.emplace(pass, index);
+        plan_passes.emplace_back(pass);
+        dependencies.emplace_back();
+        pass->for_each_dependency(
+            [&](const std::shared_ptr<RenderPassInstanceBase>& dep)
+            {
+                plan_references.emplace_back(dep);
+                const uint32_t dep_index = visit(dep.get());
+                dependencies[index].emplace_back(dep_index);
+            });
+        return index;
+    };
+    visit(this);
+
+    if (!plan.build(dependencies))
+        LOG_FATAL("Render graph '{}' contains a circular dependency", get_definition().render_pass_ref);
+
+    for (uint32_t node = 0; node < plan.node_count(); ++node)
     {
-        for (const auto& dep : found_dependencies)
-            render_jobs.emplace_back(std::pair{dep->get_definition().render_pass_ref.generic_id(), JobSystem::get().schedule<void>(
-                                                   [dep, device_image]
-                                                   {
-                                                       dep->render(device_image, device_image);
-                                                   })});
+        plan_passes[node]->plan_waits.clear();
+        for (uint32_t wait : plan.get_waits(node))
+            plan_passes[node]->plan_waits.emplace_back(plan_passes[wait]);
+        plan_passes[node]->plan_wait_stages.assign(plan_passes[node]->plan_waits.size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    }
+    plan_pending = std::make_unique<std::atomic<uint32_t>[]>(plan.node_count());
+}
 
-        for (const auto& task : render_jobs)
+void RenderPassInstanceBase::alias_attachments()
+{
+    PROFILER_SCOPE_NAMED(RenderPass_Draw, std::format("Alias attachments of {}", get_definition().render_pass_ref));
+
+    // The root attachments are read after the graph (presentation, readback) : only the dependencies are aliased
+    struct AttachmentRef
+    {
+        RenderPassInstanceBase* pass;
+        const Attachment*       attachment;
+    };
+    std::vector<AttachmentRef>     refs;
+    std::vector<AliasedAttachment> attachments;
+    for (uint32_t node = 1; node < plan.node_count(); ++node)
+    {
+        RenderPassInstanceBase* pass = plan_passes[node];
+        if (!pass->frame_resources || pass->next_frame_resources)
+            continue;
+        for (const auto& attachment : pass->get_definition().attachments_sorted)
         {
-            PROFILER_SCOPE_NAMED(RenderPass_Draw, std::format("Wait child pass '{}' finished rendering", task.first));
-            task.second.await();
+            if (attachment.b_persistent)
+                continue;
+            const auto found = pass->frame_resources->images.find(attachment.name);
+            if (found == pass->frame_resources->images.end() || !found->second->get_base_image())
+                continue;
+            const VkMemoryRequirements requirements = found->second->get_base_image()->get_resource()[0]->get_memory_requirements();
+            refs.emplace_back(AttachmentRef{pass, &attachment});
+            attachments.emplace_back(AliasedAttachment{node, requirements.size, requirements.alignment, requirements.memoryTypeBits});
         }
     }
-    else
+    attachment_aliasing.build(plan, attachments);
+
+    // Attachments have one image per frame in flight (the root pass may have more)
+    const uint8_t image_count = device().lock()->get_image_count();
+    LOG_DEBUG("Render graph '{}' : {:.2f} MB of transient attachments, {:.2f} MB once aliased in {} blocks", get_definition().render_pass_ref,
+              static_cast<double>(attachment_aliasing.get_required_size()) * image_count / (1024.0 * 1024.0),
+              static_cast<double>(attachment_aliasing.get_aliased_size()) * image_count / (1024.0 * 1024.0), attachment_aliasing.get_slots().size());
+    if (attachment_aliasing.get_aliased_size() >= attachment_aliasing.get_required_size())
+        return;
+
+    // The previous attachments (and the previous aliased blocks when aliasing again) are released before allocating the new blocks. They are
+    // destroyed once the frames in flight using them are finished.
+    ankerl::unordered_dense::map<RenderPassInstanceBase*, std::shared_ptr<FrameResources>> new_resources;
+    for (const auto& ref : refs)
+    {
+        auto resources = new_resources.find(ref.pass);
+        if (resources == new_resources.end())
+        {
+            resources                  = new_resources.emplace(ref.pass, std::make_shared<FrameResources>(device())).first;
+            resources->second->images  = ref.pass->frame_resources->images;
+            resources->second->buffers = ref.pass->frame_resources->buffers;
+        }
+        resources->second->images.erase(ref.attachment->name);
+    }
+    for (const auto& [pass, resources] : new_resources)
+    {
+        device().lock()->drop_resource(pass->frame_resources);
+        pass->frame_resources = nullptr;
+    }
+
+    // One block per slot and per frame in flight, the attachments are created again inside
+    std::vector<std::vector<std::shared_ptr<AliasedMemory>>> slot_memory;
+    for (uint32_t slot = 0; slot < attachment_aliasing.get_slots().size(); ++slot)
     {
-        for (const auto& dep : found_dependencies)
-            dep->render(device_image, device_image);
+        const AliasingSlot&        slot_infos = attachment_aliasing.get_slots()[slot];
+        const VkMemoryRequirements requirements{.size = slot_infos.size, .alignment = slot_infos.alignment, .memoryTypeBits = slot_infos.memory_type_bits};
+        auto&                      memory = slot_memory.emplace_back();
+        for (uint8_t image = 0; image < image_count; ++image)
+            memory.emplace_back(AliasedMemory::create(std::format("{} aliased block #{}_{}", get_definition().render_pass_ref, slot, image), device(), requirements));
     }
 
-    render_internal(swapchain_image, device_image);
+    for (uint32_t i = 0; i < refs.size(); ++i)
+    {
+        RenderPassInstanceBase* pass = refs[i].pass;
+        const std::string&      name = refs[i].attachment->name;
+        new_resources[pass]->images.emplace(name, ImageView::create(name, Image::create(name, device(), pass->get_attachment_parameters(name), slot_memory[attachment_aliasing.get_slot(i)])));
+    }
+
+    for (const auto& [pass, resources] : new_resources)
+    {
+        pass->create_framebuffers(*resources);
+        pass->frame_resources = resources;
+    }
+
+    // The consumers bound the previous images
+    for (uint32_t node = 0; node < plan.node_count(); ++node)
+    {
+        const bool b_changed = new_resources.contains(plan_passes[node]) || std::ranges::any_of(plan.get_waits(node),
+                                                                                                 [&](uint32_t wait)
+                                                                                                 {
+                                                                                                     return new_resources.contains(plan_passes[wait]);
+                                                                                                 });
+        if (!b_changed)
+            continue;
+        plan_passes[node]->command_buffers->invalidate_secondaries();
+        if (plan_passes[node]->render_pass_interface)
+            plan_passes[node]->render_pass_interface->on_create_framebuffer(*plan_passes[node]);
+    }
+}
+
+void RenderPassInstanceBase::compile_barriers()
+{
+    PROFILER_SCOPE_NAMED(RenderPass_Draw, std::format("Compile barriers of {}", get_definition().render_pass_ref));
+
+    // Every attachment is read by the passes requiring its pass. The root attachments and the persistent ones are also read after the graph.
+    struct ResourceRef
+    {
+        std::shared_ptr<ImageView> image;
+        ColorFormat                format;
+    };
+    std::vector<ResourceRef>       refs;
+    std::vector<GraphResource>     resources;
+    std::vector<GraphResourceRead> reads;
+    std::vector<uint32_t>          node_resources(plan.node_count() + 1, 0);
+    for (uint32_t node = 0; node < plan.node_count(); ++node)
+    {
+        const RenderPassInstanceBase* pass = plan_passes[node];
+        if (pass->frame_resources)
+            for (const auto& attachment : pass->get_definition().attachments_sorted)
+            {
+                const auto found = pass->frame_resources->images.find(attachment.name);
+                if (found == pass->frame_resources->images.end())
+                    continue;
+                ResourceAccess final_access = attachment.b_persistent ? RESOURCE_ACCESS_FRAGMENT_READ : RESOURCE_ACCESS_NONE;
+                if (node == 0)
+                    final_access = pass->is_present_pass() ? RESOURCE_ACCESS_PRESENT : RESOURCE_ACCESS_FRAGMENT_READ;
+                ResourceAccess write_access = is_depth_format(attachment.color_format) ? RESOURCE_ACCESS_DEPTH_ATTACHMENT : RESOURCE_ACCESS_COLOR_ATTACHMENT;
+                if (pass->get_definition().b_is_compute_pass)
+                    write_access = RESOURCE_ACCESS_COMPUTE_WRITE;
+                resources.emplace_back(GraphResource{node, write_access, final_access});
+                refs.emplace_back(ResourceRef{found->second, attachment.color_format});
+            }
+        node_resources[node + 1] = static_cast<uint32_t>(resources.size());
+    }
+    for (uint32_t node = 0; node < plan.node_count(); ++node)
+    {
+        const ResourceAccess read_access = plan_passes[node]->get_definition().b_is_compute_pass ? RESOURCE_ACCESS_COMPUTE_READ : RESOURCE_ACCESS_FRAGMENT_READ;
+        for (uint32_t wait : plan.get_waits(node))
+            for (uint32_t resource = node_resources[wait]; resource < node_resources[wait + 1]; ++resource)
+                reads.emplace_back(GraphResourceRead{node, resource, read_access});
+    }
+    if (!graph_barriers.build(plan, resources, reads))
+        LOG_FATAL("Render graph '{}' reads an attachment of a pass it does not wait for", get_definition().render_pass_ref);
+
+    const auto plan_batch = [&](std::span<const ResourceBarrier> barriers, PlannedBarriers& planned, QueueSpecialization pass_queue)
+    {
+        planned.barriers.clear();
+        planned.src_stages = 0;
+        planned.dst_stages = 0;
+        for (const auto& barrier : barriers)
+        {
+            const AccessInfos src = get_access_infos(barrier.src_access);
+            AccessInfos       dst = get_access_infos(barrier.dst_access);
+            // Readers on another queue only get the layout transition, they wait for the semaphore
+            if (pass_queue != QueueSpecialization::Graphic && (dst.stages & ~COMPUTE_QUEUE_STAGES) != 0)
+            {
+                dst.stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+                dst.access = 0;
+            }
+            // A discarded content has nothing to make available, the previous users of the image (or of its memory) are waited by the semaphores on the destination stages
+            planned.src_stages |= barrier.src_access == RESOURCE_ACCESS_NONE ? dst.stages : src.stages;
+            planned.dst_stages |= dst.stages;
+            planned.barriers.emplace_back(PlannedBarriers::Barrier{refs[barrier.resource].image, get_aspect(refs[barrier.resource].format), src.layout, dst.layout, src.access, dst.access});
+        }
+    };
+    for (uint32_t node = 0; node < plan.node_count(); ++node)
+    {
+        RenderPassInstanceBase* pass = plan_passes[node];
+        plan_batch(graph_barriers.get_begin_barriers(node), pass->begin_barriers, pass->queue);
+        plan_batch(graph_barriers.get_end_barriers(node), pass->end_barriers, pass->queue);
+        pass->plan_wait_stages.clear();
+        for (ResourceAccess access : graph_barriers.get_wait_accesses(node))
+        {
+            VkPipelineStageFlags stages = get_access_infos(access).stages;
+            if (pass->queue != QueueSpecialization::Graphic)
+                stages &= COMPUTE_QUEUE_STAGES;
+            pass->plan_wait_stages.emplace_back(stages != 0 ? stages : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+        }
+    }
 }
 
 void RenderPassInstanceBase::for_each_dependency(const std::function<void(const std::shared_ptr<RenderPassInstanceBase>&)>& callback) const
@@ -164,18 +600,22 @@ VkSemaphore RenderPassInstanceBase::get_render_finished_semaphore() const
 }
 
 std::shared_ptr<ImageView> RenderPassInstanceBase::create_view_for_attachment(const std::string& attachment_name)
+{
+    return ImageView::create(attachment_name, Image::create(attachment_name, device(), get_attachment_parameters(attachment_name)));
+}
+
+ImageParameter RenderPassInstanceBase::get_attachment_parameters(const std::string& attachment_name) const
 {
     auto attachment = definition.find_attachment_by_name(attachment_name);
     if (!attachment)
         LOG_FATAL("Attachment {} not found", attachment_name);
-    return ImageView::create(attachment_name, Image::create(attachment_name, device(),
-                                                            ImageParameter{
-                                                                .format = attachment->color_format,
-                                                                .gpu_write_capabilities = ETextureGPUWriteCapabilities::Enabled,
-                                                                .buffer_type = EBufferType::IMMEDIATE,
-                                                                .width = resolution().x,
-                                                                .height = resolution().y,
-                                                            }));
+    return ImageParameter{
+        .format = attachment->color_format,
+        .gpu_write_capabilities = definition.b_is_compute_pass ? ETextureGPUWriteCapabilities::Storage : ETextureGPUWriteCapabilities::Enabled,
+        .buffer_type = EBufferType::IMMEDIATE,
+        .width = resolution().x,
+        .height = resolution().y,
+    };
 }
 
 uint8_t RenderPassInstanceBase::get_image_count() const
@@ -192,7 +632,7 @@ void RenderPassInstanceBase::fill_command_buffer(CommandBuffer& cmd, size_t grou
     }
 }
 
-PassCommandPool::PassCommandPool(std::weak_ptr<Device> in_device, const std::string& name) : DeviceResource(std::move(name), std::move(in_device))
+PassCommandPool::PassCommandPool(std::weak_ptr<Device> in_device, const std::string& name, QueueSpecialization in_queue) : DeviceResource(std::move(name), std::move(in_device)), queue(in_queue)
 {
 }
 
@@ -208,16 +648,43 @@ CommandBuffer& PassCommandPool::begin_secondary(DeviceImageId image, const Frame
     std::lock_guard lk(lock);
 
     auto& frame_data = per_frame_data[image];
-    if (auto found = frame_data.secondary_command_buffer.find(std::this_thread::get_id()); found != frame_data.secondary_command_buffer.end())
+    auto  found      = frame_data.secondary_command_buffer.find(std::this_thread::get_id());
+    if (found == frame_data.secondary_command_buffer.end())
+        found = frame_data.secondary_command_buffer.emplace(std::this_thread::get_id(), SecondaryCommandBuffer::create(name() + "_primary", device(), queue)).first;
+    // Jobs running on the same thread record in the same command buffer
+    if (std::ranges::find(frame_data.recorded_secondaries, found->second) == frame_data.recorded_secondaries.end())
+        frame_data.recorded_secondaries.emplace_back(found->second);
+    found->second->set_context(&framebuffer, &parent);
+    found->second->begin(false);
+    return *found->second;
+}
+
+bool PassCommandPool::reuse_secondaries(DeviceImageId image, const Framebuffer& framebuffer, uint64_t content_signature, CommandBuffer& parent)
+{
+    std::lock_guard lk(lock);
+
+    auto& frame_data = per_frame_data[image];
+    if (content_signature != 0 && content_signature == frame_data.recorded_signature && &framebuffer == frame_data.recorded_framebuffer)
     {
-        found->second->set_context(&framebuffer, &parent);
-        found->second->begin(false);
-        return *found->second;
+        for (const auto& secondary : frame_data.recorded_secondaries)
+            secondary->execute_again(parent);
+        return true;
+    }
+    frame_data.recorded_secondaries.clear();
+    frame_data.recorded_framebuffer = &framebuffer;
+    frame_data.recorded_signature   = content_signature;
+    return false;
+}
+
+void PassCommandPool::invalidate_secondaries()
+{
+    std::lock_guard lk(lock);
+    for (auto& frame_data : per_frame_data)
+    {
+        frame_data.recorded_secondaries.clear();
+        frame_data.recorded_framebuffer = nullptr;
+        frame_data.recorded_signature   = 0;
     }
-    auto& found = *frame_data.secondary_command_buffer.emplace(std::this_thread::get_id(), SecondaryCommandBuffer::create(name() + "_primary", device(), QueueSpecialization::Graphic)).first->second;
-    found.set_context(&framebuffer, &parent);
-    found.begin(false);
-    return found;
 }
 
 CommandBuffer& PassCommandPool::get_primary(DeviceImageId image)
@@ -229,7 +696,7 @@ CommandBuffer& PassCommandPool::get_primary(DeviceImageId image)
     auto& frame_data = per_frame_data[image];
     if (auto found = frame_data.primary_command_buffers.find(std::this_thread::get_id()); found != frame_data.primary_command_buffers.end())
         return *found->second;
-    return *frame_data.primary_command_buffers.emplace(std::this_thread::get_id(), CommandBuffer::create(name() + "_primary", device(), QueueSpecialization::Graphic)).first->second;
+    return *frame_data.primary_command_buffers.emplace(std::this_thread::get_id(), CommandBuffer::create(name() + "_primary", device(), queue)).first->second;
 }
 
 std::shared_ptr<RenderPassInstanceBase> RenderPassInstanceBase::create(std::weak_ptr<Device> device, const Renderer& renderer, const RenderPassGenericId& rp_ref)
@@ -247,8 +714,6 @@ std::shared_ptr<RenderPassInstanceBase> RenderPassInstanceBase::create(std::weak
 
 void RenderPassInstanceBase::reset_for_next_frame()
 {
-    prepared = false;
-
     for_each_dependency(
         [&](const std::shared_ptr<RenderPassInstanceBase>& dep)
         {
@@ -263,6 +728,8 @@ void RenderPassInstanceBase::reset_for_next_frame()
             device().lock()->drop_resource(frame_resources);
         frame_resources      = next_frame_resources;
         next_frame_resources = {};
+        ++GRAPH_REVISION;
+        command_buffers->invalidate_secondaries();
         if (render_pass_interface)
             render_pass_interface->on_create_framebuffer(*this);
     }
@@ -282,7 +749,7 @@ FrameResources* RenderPassInstanceBase::create_or_resize(const glm::uvec2& viewp
 
     PROFILER_SCOPE_NAMED(RenderPass_Draw, std::format("Resize draw pass {}", definition.render_pass_ref));
 
-    if (render_finished_semaphores.size() != get_image_count())
+    if (is_present_pass() && render_finished_semaphores.size() != get_image_count())
     {
         render_finished_semaphores.resize(get_image_count());
         for (auto& semaphore : render_finished_semaphores)
@@ -313,6 +780,7 @@ std::shared_ptr<RenderPassInstanceBase> CustomPassList::add_custom_pass(const st
     const RenderPassRef& ref    = new_rp->get_definition().render_pass_ref;
     for (const auto& target : targets)
         temporary_dependencies.emplace(target, ankerl::unordered_dense::map<RenderPassRef, std::shared_ptr<RenderPassInstanceBase>>{}).first->second.emplace(ref, new_rp);
+    ++GRAPH_REVISION;
     return new_rp;
 }
 
@@ -320,6 +788,7 @@ void CustomPassList::remove_custom_pass(const RenderPassRef& ref)
 {
     for (auto& dependencies : temporary_dependencies | std::views::values)
         dependencies.erase(ref);
+    ++GRAPH_REVISION;
 }
 
 void CustomPassList::for_each_dependency(const RenderPassGenericId& target_id, const std::function<void(const std::shared_ptr<RenderPassInstanceBase>&)>& callback) const
@@ -1,3 +1,4 @@
+#include <cstring>
 #include <utility>
 
 #include "gfx/vulkan/command_buffer.hpp"
@@ -20,6 +21,22 @@ namespace Eng::Gfx
 {
 class Fence;
 
+CommandBufferStats& CommandBufferStats::operator+=(const CommandBufferStats& other)
+{
+    draws                  += other.draws;
+    pipeline_binds         += other.pipeline_binds;
+    descriptor_binds       += other.descriptor_binds;
+    vertex_buffer_binds    += other.vertex_buffer_binds;
+    index_buffer_binds     += other.index_buffer_binds;
+    push_constants         += other.push_constants;
+    skipped_pipelines      += other.skipped_pipelines;
+    skipped_descriptors    += other.skipped_descriptors;
+    skipped_vertex_buffers += other.skipped_vertex_buffers;
+    skipped_index_buffers  += other.skipped_index_buffers;
+    skipped_push_constants += other.skipped_push_constants;
+    return *this;
+}
+
 CommandBuffer::CommandBuffer(std::string in_name, std::weak_ptr<Device> in_device, QueueSpecialization in_type, std::thread::id thread_id, bool secondary)
     : type(in_type), device(std::move(in_device)), thread_id(thread_id), name(std::move(in_name))
 {
@@ -99,6 +116,7 @@ void CommandBuffer::end_debug_marker()
 void CommandBuffer::draw_procedural(uint32_t vertex_count, uint32_t first_vertex, uint32_t instance_count, uint32_t first_instance) const
 {
     assert(std::this_thread::get_id() == thread_id);
+    ++stats.draws;
     vkCmdDraw(ptr, vertex_count, instance_count, first_vertex, first_instance);
 }
 
@@ -106,8 +124,12 @@ void CommandBuffer::bind_pipeline(const std::shared_ptr<Pipeline>& pipeline)
 {
     assert(std::this_thread::get_id() == thread_id);
     if (last_pipeline == pipeline)
+    {
+        ++stats.skipped_pipelines;
         return;
+    }
     last_pipeline = pipeline;
+    ++stats.pipeline_binds;
     if (pipeline->infos().options.line_width != 1.0f)
         vkCmdSetLineWidth(ptr, pipeline->infos().options.line_width);
     vkCmdBindPipeline(ptr, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->raw());
@@ -116,76 +138,110 @@ void CommandBuffer::bind_pipeline(const std::shared_ptr<Pipeline>& pipeline)
 void CommandBuffer::bind_descriptors(DescriptorSet& descriptors, const Pipeline& pipeline) const
 {
     assert(std::this_thread::get_id() == thread_id);
-    vkCmdBindDescriptorSets(ptr, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.get_layout()->raw(), 0, 1, &descriptors.raw_current(), 0, nullptr);
+    // Sets bound with another layout may not be compatible with this pipeline
+    const VkPipelineLayout layout = pipeline.get_layout()->raw();
+    const VkDescriptorSet  set    = descriptors.raw_current();
+    if (bound.descriptors_layout == layout && bound.descriptor_sets[0] == set)
+    {
+        ++stats.skipped_descriptors;
+        return;
+    }
+    if (bound.descriptors_layout != layout)
+        bound.descriptor_sets = {};
+    bound.descriptors_layout = layout;
+    bound.descriptor_sets[0] = set;
+    ++stats.descriptor_binds;
+    vkCmdBindDescriptorSets(ptr, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &set, 0, nullptr);
 }
 
-void CommandBuffer::draw_mesh(const Mesh& in_mesh, uint32_t instance_count, uint32_t first_instance) const
+void CommandBuffer::bind_mesh(const Mesh& in_mesh) const
 {
     assert(std::this_thread::get_id() == thread_id);
-    if (const auto& vertices = in_mesh.get_vertices())
+    const auto& vertices = in_mesh.get_vertices();
+    if (!vertices)
+        return;
+    bind_vertex_buffer_internal(0, vertices->raw_current(), 0);
+    if (const auto& indices = in_mesh.get_indices())
     {
-        constexpr VkDeviceSize offsets[]     = {0};
-        const auto             vertex_buffer = vertices->raw_current();
-        vkCmdBindVertexBuffers(ptr, 0, 1, &vertex_buffer, offsets);
-        if (const auto& indices = in_mesh.get_indices())
+        VkIndexType index_buffer_type;
+        switch (in_mesh.get_index_buffer_type())
         {
-            VkIndexType index_buffer_type;
-            switch (in_mesh.get_index_buffer_type())
-            {
-            case IndexBufferType::Uint8:
-                index_buffer_type = VK_INDEX_TYPE_UINT8_KHR;
-                break;
-            case IndexBufferType::Uint16:
-                index_buffer_type = VK_INDEX_TYPE_UINT16;
-                break;
-            case IndexBufferType::Uint32:
-                index_buffer_type = VK_INDEX_TYPE_UINT32;
-                break;
-            default:
-                LOG_FATAL("Unhandled index type")
-            }
-            vkCmdBindIndexBuffer(ptr, indices->raw_current(), 0, index_buffer_type);
-            vkCmdDrawIndexed(ptr, static_cast<uint32_t>(indices->get_element_count()), instance_count, 0, 0, first_instance);
+        case IndexBufferType::Uint8:
+            index_buffer_type = VK_INDEX_TYPE_UINT8_KHR;
+            break;
+        case IndexBufferType::Uint16:
+            index_buffer_type = VK_INDEX_TYPE_UINT16;
+            break;
+        case IndexBufferType::Uint32:
+            index_buffer_type = VK_INDEX_TYPE_UINT32;
+            break;
+        default:
+            LOG_FATAL("Unhandled index type")
         }
-        else
+        const VkBuffer index_buffer = indices->raw_current();
+        if (bound.index_buffer == index_buffer && bound.index_type == index_buffer_type)
         {
-            vkCmdDraw(ptr, static_cast<uint32_t>(vertices->get_element_count()), instance_count, 0, first_instance);
+            ++stats.skipped_index_buffers;
+            return;
         }
+        bound.index_buffer = index_buffer;
+        bound.index_type   = index_buffer_type;
+        ++stats.index_buffer_binds;
+        vkCmdBindIndexBuffer(ptr, index_buffer, 0, index_buffer_type);
     }
 }
 
-void CommandBuffer::draw_mesh(const Mesh& in_mesh, uint32_t first_index, uint32_t vertex_offset, uint32_t index_count, uint32_t instance_count, uint32_t first_instance) const
+void CommandBuffer::draw_bound_mesh(const Mesh& in_mesh, uint32_t instance_count, uint32_t first_instance) const
 {
     assert(std::this_thread::get_id() == thread_id);
     if (const auto& vertices = in_mesh.get_vertices())
     {
-        constexpr VkDeviceSize offsets[]     = {0};
-        const auto             vertex_buffer = vertices->raw_current();
-        vkCmdBindVertexBuffers(ptr, 0, 1, &vertex_buffer, offsets);
+        ++stats.draws;
         if (const auto& indices = in_mesh.get_indices())
+            vkCmdDrawIndexed(ptr, static_cast<uint32_t>(indices->get_element_count()), instance_count, 0, 0, first_instance);
+        else
+            vkCmdDraw(ptr, static_cast<uint32_t>(vertices->get_element_count()), instance_count, 0, first_instance);
+    }
+}
+
+void CommandBuffer::bind_vertex_buffer(uint32_t binding, Buffer& buffer, size_t byte_offset) const
+{
+    assert(std::this_thread::get_id() == thread_id);
+    bind_vertex_buffer_internal(binding, buffer.raw_current(), byte_offset);
+}
+
+void CommandBuffer::bind_vertex_buffer_internal(uint32_t binding, VkBuffer buffer, VkDeviceSize offset) const
+{
+    if (binding < MAX_VERTEX_BINDINGS)
+    {
+        if (bound.vertex_buffers[binding] == buffer && bound.vertex_offsets[binding] == offset)
         {
-            VkIndexType index_buffer_type;
-            switch (in_mesh.get_index_buffer_type())
-            {
-            case IndexBufferType::Uint8:
-                index_buffer_type = VK_INDEX_TYPE_UINT8_KHR;
-                break;
-            case IndexBufferType::Uint16:
-                index_buffer_type = VK_INDEX_TYPE_UINT16;
-                break;
-            case IndexBufferType::Uint32:
-                index_buffer_type = VK_INDEX_TYPE_UINT32;
-                break;
-            default:
-                LOG_FATAL("Unhandled index type")
-            }
-            vkCmdBindIndexBuffer(ptr, indices->raw_current(), 0, index_buffer_type);
-            vkCmdDrawIndexed(ptr, index_count, instance_count, first_index, static_cast<int32_t>(vertex_offset), first_instance);
+            ++stats.skipped_vertex_buffers;
+            return;
         }
+        bound.vertex_buffers[binding] = buffer;
+        bound.vertex_offsets[binding] = offset;
+    }
+    ++stats.vertex_buffer_binds;
+    vkCmdBindVertexBuffers(ptr, binding, 1, &buffer, &offset);
+}
+
+void CommandBuffer::draw_mesh(const Mesh& in_mesh, uint32_t instance_count, uint32_t first_instance) const
+{
+    bind_mesh(in_mesh);
+    draw_bound_mesh(in_mesh, instance_count, first_instance);
+}
+
+void CommandBuffer::draw_mesh(const Mesh& in_mesh, uint32_t first_index, uint32_t vertex_offset, uint32_t index_count, uint32_t instance_count, uint32_t first_instance) const
+{
+    bind_mesh(in_mesh);
+    if (const auto& vertices = in_mesh.get_vertices())
+    {
+        ++stats.draws;
+        if (in_mesh.get_indices())
+            vkCmdDrawIndexed(ptr, index_count, instance_count, first_index, static_cast<int32_t>(vertex_offset), first_instance);
         else
-        {
             vkCmdDraw(ptr, static_cast<uint32_t>(vertices->get_element_count()), instance_count, vertex_offset, first_instance);
-        }
     }
 }
 
@@ -224,7 +280,26 @@ void CommandBuffer::set_viewport(const Viewport& in_viewport) const
 void CommandBuffer::push_constant(EShaderStage stage, const Pipeline& pipeline, const BufferData& data) const
 {
     assert(std::this_thread::get_id() == thread_id);
-    vkCmdPushConstants(ptr, pipeline.get_layout()->raw(), static_cast<VkShaderStageFlags>(stage), 0, static_cast<uint32_t>(data.get_byte_size()), data.data());
+    const VkPipelineLayout   layout = pipeline.get_layout()->raw();
+    const VkShaderStageFlags stages = static_cast<VkShaderStageFlags>(stage);
+    const uint32_t           size   = static_cast<uint32_t>(data.get_byte_size());
+    if (size <= MAX_PUSH_CONSTANT_SIZE)
+    {
+        // Push constants stay valid across pipeline binds as long as the layout doesn't change
+        if (bound.push_layout == layout && bound.push_stages == stages && bound.push_size == size && std::memcmp(bound.push_data.data(), data.data(), size) == 0)
+        {
+            ++stats.skipped_push_constants;
+            return;
+        }
+        bound.push_layout = layout;
+        bound.push_stages = stages;
+        bound.push_size   = size;
+        std::memcpy(bound.push_data.data(), data.data(), size);
+    }
+    else
+        bound.push_layout = VK_NULL_HANDLE;
+    ++stats.push_constants;
+    vkCmdPushConstants(ptr, layout, stages, 0, size, data.data());
 }
 
 void CommandBuffer::begin_render_pass(const RenderPassRef& pass_name, const VkRenderPassBeginInfo& begin_infos, bool parallel_rendering)
@@ -235,6 +310,15 @@ void CommandBuffer::begin_render_pass(const RenderPassRef& pass_name, const VkRe
     thread_unlock();
 }
 
+void CommandBuffer::begin_rendering(const RenderPassRef& pass_name, const VkRenderingInfo& rendering_infos)
+{
+    thread_lock();
+    vkCmdBeginRendering(ptr, &rendering_infos);
+    render_pass_name    = pass_name;
+    b_dynamic_rendering = true;
+    thread_unlock();
+}
+
 void CommandBuffer::bind_compute_pipeline(const ComputePipeline& pipeline) const
 {
     vkCmdBindPipeline(ptr, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.raw());
@@ -262,15 +346,29 @@ void CommandBuffer::end_render_pass()
             p_command_buffers.emplace_back(sec->raw());
         vkCmdExecuteCommands(ptr, static_cast<uint32_t>(p_command_buffers.size()), p_command_buffers.data());
         secondary_command_buffers.clear();
+        // The state bound by the secondary command buffers is undefined after their execution
+        last_pipeline = nullptr;
+        reset_bound_state();
     }
-    vkCmdEndRenderPass(ptr);
-    render_pass_name = {};
+    if (b_dynamic_rendering)
+        vkCmdEndRendering(ptr);
+    else
+        vkCmdEndRenderPass(ptr);
+    render_pass_name    = {};
+    b_dynamic_rendering = false;
     thread_unlock();
 }
 
 void CommandBuffer::reset_stats()
 {
     last_pipeline = nullptr;
+    stats         = {};
+    reset_bound_state();
+}
+
+void CommandBuffer::reset_bound_state() const
+{
+    bound = {};
 }
 
 void SecondaryCommandBuffer::begin(bool one_time)
@@ -283,9 +381,19 @@ void SecondaryCommandBuffer::begin(bool one_time)
     assert(!is_recording);
     b_wait_submission = true;
     is_recording      = true;
+    // With dynamic rendering, only the formats of the attachments are inherited
+    const auto                                    render_pass = framebuffer->get_render_pass_resource().lock();
+    const VkCommandBufferInheritanceRenderingInfo rendering_infos{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+        .colorAttachmentCount = static_cast<uint32_t>(render_pass->get_color_formats().size()),
+        .pColorAttachmentFormats = render_pass->get_color_formats().data(),
+        .depthAttachmentFormat = render_pass->get_depth_format(),
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+    };
     VkCommandBufferInheritanceInfo inheritance{
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
-        .renderPass = framebuffer->get_render_pass_resource().lock()->raw(),
+        .pNext = parent->b_dynamic_rendering ? &rendering_infos : nullptr,
+        .renderPass = render_pass->raw(),
         .framebuffer = framebuffer->raw(),
     };
 
@@ -311,6 +419,16 @@ void SecondaryCommandBuffer::end()
     CommandBuffer::end();
     b_wait_submission = false;
     std::lock_guard lk(parent->secondary_vector_mtx);
+    parent->stats += get_stats();
+    parent->secondary_command_buffers.insert(shared_from_this());
+}
+
+void SecondaryCommandBuffer::execute_again(CommandBuffer& parent_command_buffer)
+{
+    assert(!is_recording);
+    parent = &parent_command_buffer;
+    std::lock_guard lk(parent->secondary_vector_mtx);
+    parent->stats += get_stats();
     parent->secondary_command_buffers.insert(shared_from_this());
 }
 
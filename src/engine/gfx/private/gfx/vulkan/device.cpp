@@ -1,6 +1,7 @@
 #include "gfx/vulkan/device.hpp"
 
 #define VMA_IMPLEMENTATION
+#include "frames_in_flight.hpp"
 #include "profiler.hpp"
 
 #include <vk_mem_alloc.h>
@@ -13,6 +14,7 @@
 #include "gfx/vulkan/vk_wrap.hpp"
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
 
 namespace Eng::Gfx
 {
@@ -22,6 +24,52 @@ void Device::next_frame()
 {
     glfwPollEvents();
     current_image = (current_image + 1) % image_count;
+    if (Profiler::get().is_recording())
+        calibrate_gpu_clock();
+}
+
+void Device::calibrate_gpu_clock()
+{
+    if (!get_calibrated_timestamps)
+        return;
+    const VkCalibratedTimestampInfoEXT info{.sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT, .timeDomain = VK_TIME_DOMAIN_DEVICE_EXT};
+    uint64_t                           ticks         = 0;
+    uint64_t                           max_deviation = 0;
+
+    // The cpu time is the middle of the call
+    const auto before = std::chrono::steady_clock::now();
+    if (get_calibrated_timestamps(ptr, 1, &info, &ticks, &max_deviation) != VK_SUCCESS)
+        return;
+    const auto      after = std::chrono::steady_clock::now();
+    std::lock_guard lk(gpu_clock_mutex);
+    gpu_clock.calibrate(ticks, before + (after - before) / 2);
+}
+
+std::chrono::steady_clock::time_point Device::gpu_to_cpu_time(uint64_t ticks, std::chrono::steady_clock::time_point recorded_time)
+{
+    std::lock_guard lk(gpu_clock_mutex);
+    gpu_clock.align_after(ticks, recorded_time);
+    return gpu_clock.to_cpu_time(ticks);
+}
+
+// Calibrated timestamps are optional : without them, the gpu time is aligned on the recording time of the commands
+static bool support_calibrated_timestamps(const Instance& instance, const PhysicalDevice& physical_device)
+{
+    uint32_t extension_count = 0;
+    vkEnumerateDeviceExtensionProperties(physical_device.raw(), nullptr, &extension_count, nullptr);
+    std::vector<VkExtensionProperties> extensions(extension_count);
+    vkEnumerateDeviceExtensionProperties(physical_device.raw(), nullptr, &extension_count, extensions.data());
+    if (std::ranges::none_of(extensions, [](const VkExtensionProperties& extension) { return std::string(extension.extensionName) == VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME; }))
+        return false;
+
+    const auto get_time_domains = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(vkGetInstanceProcAddr(instance.raw(), "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+    if (!get_time_domains)
+        return false;
+    uint32_t domain_count = 0;
+    get_time_domains(physical_device.raw(), &domain_count, nullptr);
+    std::vector<VkTimeDomainEXT> domains(domain_count);
+    get_time_domains(physical_device.raw(), &domain_count, domains.data());
+    return std::ranges::find(domains, VK_TIME_DOMAIN_DEVICE_EXT) != domains.end();
 }
 
 void Device::wait() const
@@ -34,15 +82,7 @@ void Device::wait() const
 void Device::flush_resources()
 {
     PROFILER_SCOPE(FlushResources);
-    while (!pending_kill_resources[current_image].empty())
-    {
-        std::vector<std::shared_ptr<DeviceResource>> resources_copy;
-        {
-            std::lock_guard lock(resource_mutex);
-            resources_copy = std::move(pending_kill_resources[current_image]);
-        }
-        resources_copy.clear();
-    }
+    pending_kill_resources.flush(current_image);
 
 #if _DEBUG
     DescriptorSet::reset_descriptors_debug();
@@ -52,6 +92,11 @@ void Device::flush_resources()
 Device::Device(const GfxConfig& in_config, const std::weak_ptr<Instance>& in_instance, const PhysicalDevice& physical_device, const Surface& surface)
     : queues(std::make_unique<Queues>(physical_device, surface)), physical_device(physical_device), instance(in_instance), config(in_config)
 {
+    if (config.frames_in_flight == 0)
+        LOG_WARNING("At least one frame in flight is required");
+    image_count = FramesInFlight::ring_size(config.frames_in_flight);
+    LOG_INFO("{} frames in flight", image_count);
+
     VkPhysicalDeviceMemoryProperties memProperties;
     vkGetPhysicalDeviceMemoryProperties(physical_device.raw(), &memProperties);
 
@@ -95,21 +140,40 @@ Device::Device(const GfxConfig& in_config, const std::weak_ptr<Instance>& in_ins
         .shaderInt16 = true,
     };
 
+    VkPhysicalDeviceVulkan13Features supported_features_13{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES};
+    VkPhysicalDeviceFeatures2        supported_features{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = &supported_features_13};
+    vkGetPhysicalDeviceFeatures2(physical_device.raw(), &supported_features);
+    b_dynamic_rendering = config.dynamic_rendering && supported_features_13.dynamicRendering;
+    LOG_INFO("Dynamic rendering : {}", b_dynamic_rendering ? "enabled" : "disabled, using render passes");
+
+    VkPhysicalDeviceVulkan13Features device_features_13{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+        .synchronization2 = true,
+        .dynamicRendering = b_dynamic_rendering,
+    };
+
     VkPhysicalDeviceVulkan12Features device_features_12{
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = &device_features_13,
         .shaderFloat16 = true,
         .descriptorBindingPartiallyBound = true,
         .descriptorBindingVariableDescriptorCount = true,
         .runtimeDescriptorArray = true,
+        .timelineSemaphore = true,
     };
 
+    std::vector<const char*> enabled_extensions      = device_extensions;
+    const bool               b_calibrated_timestamps = support_calibrated_timestamps(*instance.lock(), physical_device);
+    if (b_calibrated_timestamps)
+        enabled_extensions.emplace_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+
     VkDeviceCreateInfo createInfo{
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
         .pNext = &device_features_12,
         .queueCreateInfoCount = static_cast<uint32_t>(queues_info.size()),
         .pQueueCreateInfos = queues_info.data(),
-        .enabledExtensionCount = static_cast<uint32_t>(device_extensions.size()),
-        .ppEnabledExtensionNames = device_extensions.data(),
+        .enabledExtensionCount = static_cast<uint32_t>(enabled_extensions.size()),
+        .ppEnabledExtensionNames = enabled_extensions.data(),
         .pEnabledFeatures = &deviceFeatures,
     };
 
@@ -126,6 +190,19 @@ Device::Device(const GfxConfig& in_config, const std::weak_ptr<Instance>& in_ins
 
     VK_CHECK(vkCreateDevice(physical_device.raw(), &createInfo, nullptr, &ptr), "Failed to create device")
 
+    // Timestamps wrap around after the smallest valid bit count of the queues
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device.raw(), &properties);
+    timestamp_period        = properties.limits.timestampPeriod;
+    uint32_t timestamp_bits = 64;
+    for (const auto& queue : queues->all_families())
+        if (queue->timestamp_valid_bits() != 0)
+            timestamp_bits = std::min(timestamp_bits, queue->timestamp_valid_bits());
+    gpu_clock = GpuClock(timestamp_period, timestamp_bits);
+    if (b_calibrated_timestamps)
+        get_calibrated_timestamps = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(vkGetDeviceProcAddr(ptr, "vkGetCalibratedTimestampsEXT"));
+    LOG_INFO("Gpu timestamps : {} ns per tick, {} valid bits, {}", timestamp_period, timestamp_bits, get_calibrated_timestamps ? "calibrated" : "not calibrated");
+
     VmaAllocatorCreateInfo allocatorInfo = {
         .physicalDevice = physical_device.raw(),
         .device = ptr,
@@ -143,7 +220,6 @@ std::shared_ptr<Device> Device::create(const GfxConfig& config, const std::weak_
     for (const auto& queue : device->queues->all_families())
         queue->init_queue(device->weak_from_this());
 
-    device->pending_kill_resources.resize(device->image_count, {});
     device->descriptor_pool = DescriptorPool::create(device);
     return device;
 }
@@ -195,12 +271,12 @@ std::weak_ptr<VkRendererPass> Device::get_render_pass(const RenderPassGenericId&
 void Device::destroy_resources()
 {
     wait();
-    pending_kill_resources.clear();
+    pending_kill_resources.flush_all();
     render_passes.clear();
     render_passes_named.clear();
-    pending_kill_resources.clear();
+    pending_kill_resources.flush_all();
     queues = nullptr;
-    pending_kill_resources.clear();
+    pending_kill_resources.flush_all();
     descriptor_pool = nullptr;
 
     VmaTotalStatistics stats;
@@ -209,6 +285,6 @@ void Device::destroy_resources()
         LOG_ERROR("{} allocation were not destroyed", stats.total.statistics.allocationCount);
 
     vmaDestroyAllocator(allocator->allocator);
-    pending_kill_resources.clear();
+    pending_kill_resources.flush_all();
 }
 } // namespace Eng::Gfx
\ No newline at end of file
@@ -13,12 +13,15 @@ namespace Eng::Gfx
 Framebuffer::Framebuffer(std::weak_ptr<Device> in_device, const RenderPassInstance& render_pass, uint32_t in_image_index, const FrameResources& resources)
     : DeviceResource(render_pass.get_definition().render_pass_ref.to_string() , std::move(in_device)), image_index(in_image_index)
 {
-    std::vector<VkImageView> views;
     for (const auto& attachment : render_pass.get_definition().attachments_sorted)
         views.emplace_back(resources.images.find(attachment.name)->second->raw()[image_index]);
 
     assert(!views.empty());
 
+    render_pass_resource = render_pass.get_render_pass_resource();
+    if (device().lock()->use_dynamic_rendering())
+        return;
+
     VkFramebufferCreateInfo create_infos = {
         .sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
         .renderPass      = render_pass.get_render_pass_resource().lock()->raw(),
@@ -29,8 +32,6 @@ Framebuffer::Framebuffer(std::weak_ptr<Device> in_device, const RenderPassInstan
         .layers          = 1,
     };
 
-    render_pass_resource = render_pass.get_render_pass_resource();
-
     VK_CHECK(vkCreateFramebuffer(device().lock()->raw(), &create_infos, nullptr, &ptr), "Failed to create render pass")
     device().lock()->debug_set_object_name(name() + "_fb_#" + std::to_string(in_image_index), ptr);
 }
@@ -3,9 +3,11 @@
 #include "gfx/vulkan/command_buffer.hpp"
 #include "gfx/vulkan/device.hpp"
 #include "gfx/vulkan/fence.hpp"
+#include "gfx/vulkan/queue_family.hpp"
 #include "gfx/vulkan/vk_check.hpp"
 #include "gfx/vulkan/vk_wrap.hpp"
 
+#include <array>
 #include <vk_mem_alloc.h>
 
 namespace Eng::Gfx
@@ -20,6 +22,8 @@ VkImageUsageFlags vk_usage(const ImageParameter& texture_parameters)
 
     if (texture_parameters.gpu_write_capabilities == ETextureGPUWriteCapabilities::Enabled)
         usage_flags |= is_depth_format(texture_parameters.format) ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    else if (texture_parameters.gpu_write_capabilities == ETextureGPUWriteCapabilities::Storage)
+        usage_flags |= VK_IMAGE_USAGE_STORAGE_BIT;
 
     if (texture_parameters.gpu_read_capabilities == ETextureGPUReadCapabilities::Sampling)
         usage_flags |= VK_IMAGE_USAGE_SAMPLED_BIT;
@@ -32,19 +36,37 @@ uint32_t Image::get_mips_count() const
     return params.generate_mips.does_generates() ? params.generate_mips.desired_mip_count() == 0 ? static_cast<uint32_t>(std::floor(log2(std::max(params.width, params.height)))) + 1 : 0 : provided_mips;
 }
 
-Image::Image(std::string in_name, std::weak_ptr<Device> in_device, const ImageParameter& in_params, uint32_t base_mips) : params(in_params), device(std::move(in_device)), name(std::move(in_name))
+AliasedMemory::AliasedMemory(std::string in_name, std::weak_ptr<Device> in_device, const VkMemoryRequirements& requirements) : DeviceResource(std::move(in_name), std::move(in_device))
+{
+    constexpr VmaAllocationCreateInfo vma_allocation{
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+    };
+    VmaAllocationInfo infos;
+    VmaAllocation     vma_alloc;
+    VK_CHECK(vmaAllocateMemory(device().lock()->get_allocator().allocator, &requirements, &vma_allocation, &vma_alloc, &infos), "failed to allocate aliased memory")
+    allocation = std::make_unique<VmaAllocationWrap>(vma_alloc);
+    device().lock()->debug_set_object_name(name() + "_memory", infos.deviceMemory);
+}
+
+AliasedMemory::~AliasedMemory()
+{
+    vmaFreeMemory(device().lock()->get_allocator().allocator, allocation->allocation);
+}
+
+Image::Image(std::string in_name, std::weak_ptr<Device> in_device, const ImageParameter& in_params, uint32_t base_mips, const std::vector<std::shared_ptr<AliasedMemory>>& aliased_memory)
+    : params(in_params), device(std::move(in_device)), name(std::move(in_name))
 {
     provided_mips = base_mips;
     switch (params.buffer_type)
     {
     case EBufferType::STATIC:
     case EBufferType::IMMUTABLE:
-        images = {std::make_shared<ImageResource>(name, device, params, get_mips_count())};
+        images = {std::make_shared<ImageResource>(name, device, params, get_mips_count(), aliased_memory.empty() ? nullptr : aliased_memory[0])};
         break;
     case EBufferType::DYNAMIC:
     case EBufferType::IMMEDIATE:
         for (size_t i = 0; i < device.lock()->get_image_count(); ++i)
-            images.emplace_back(std::make_shared<ImageResource>(name + "_#" + std::to_string(i), device, params, get_mips_count()));
+            images.emplace_back(std::make_shared<ImageResource>(name + "_#" + std::to_string(i), device, params, get_mips_count(), i < aliased_memory.size() ? aliased_memory[i] : nullptr));
         break;
     }
 }
@@ -149,8 +171,8 @@ void Image::set_data(glm::uvec2 new_size, const std::vector<BufferData>& mips)
     }
 }
 
-Image::ImageResource::ImageResource(std::string in_name, std::weak_ptr<Device> in_device, ImageParameter params, uint32_t in_mip_count)
-    : DeviceResource(std::move(in_name), std::move(in_device)), format(static_cast<VkFormat>(params.format))
+Image::ImageResource::ImageResource(std::string in_name, std::weak_ptr<Device> in_device, ImageParameter params, uint32_t in_mip_count, std::shared_ptr<AliasedMemory> in_aliased_memory)
+    : DeviceResource(std::move(in_name), std::move(in_device)), aliased_memory(std::move(in_aliased_memory)), format(static_cast<VkFormat>(params.format))
 {
     layer_cout = params.image_type == EImageType::Cubemap ? 6u : 1u;
     is_depth   = is_depth_format(params.format);
@@ -179,6 +201,26 @@ Image::ImageResource::ImageResource(std::string in_name, std::weak_ptr<Device> i
         .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
     };
 
+    // Render targets can be written or read by the compute passes running on the async compute queue
+    const auto&             queues = device().lock()->get_queues();
+    std::array<uint32_t, 2> queue_families{};
+    if (params.gpu_write_capabilities != ETextureGPUWriteCapabilities::None && queues.get_queue(QueueSpecialization::AsyncCompute) &&
+        queues.get_queue(QueueSpecialization::AsyncCompute)->index() != queues.get_queue(QueueSpecialization::Graphic)->index())
+    {
+        queue_families                           = {queues.get_queue(QueueSpecialization::Graphic)->index(), queues.get_queue(QueueSpecialization::AsyncCompute)->index()};
+        image_create_infos.sharingMode           = VK_SHARING_MODE_CONCURRENT;
+        image_create_infos.queueFamilyIndexCount = static_cast<uint32_t>(queue_families.size());
+        image_create_infos.pQueueFamilyIndices   = queue_families.data();
+    }
+
+    if (aliased_memory)
+    {
+        VK_CHECK(vkCreateImage(device().lock()->raw(), &image_create_infos, nullptr, &ptr), "failed to create image")
+        VK_CHECK(vmaBindImageMemory(device().lock()->get_allocator().allocator, aliased_memory->allocation->allocation, ptr), "failed to bind aliased image memory")
+        device().lock()->debug_set_object_name(name(), ptr);
+        return;
+    }
+
     constexpr VmaAllocationCreateInfo vma_allocation{
         .usage = VMA_MEMORY_USAGE_GPU_ONLY,
     };
@@ -192,7 +234,17 @@ Image::ImageResource::ImageResource(std::string in_name, std::weak_ptr<Device> i
 
 Image::ImageResource::~ImageResource()
 {
-    vmaDestroyImage(device().lock()->get_allocator().allocator, ptr, allocation->allocation);
+    if (aliased_memory)
+        vkDestroyImage(device().lock()->raw(), ptr, nullptr);
+    else
+        vmaDestroyImage(device().lock()->get_allocator().allocator, ptr, allocation->allocation);
+}
+
+VkMemoryRequirements Image::ImageResource::get_memory_requirements() const
+{
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device().lock()->raw(), ptr, &requirements);
+    return requirements;
 }
 
 void Image::ImageResource::set_data(const std::vector<BufferData>& mips)
@@ -60,7 +60,7 @@ ImageView::Resource::Resource(std::string in_name, const std::weak_ptr<Device>&
     image_resource = resource;
 }
 
-ImageView::Resource::Resource(std::string in_name, const std::weak_ptr<Device>& device, VkImage image, CreateInfos create_infos) : DeviceResource(std::move(in_name), device)
+ImageView::Resource::Resource(std::string in_name, const std::weak_ptr<Device>& device, VkImage in_image, CreateInfos create_infos) : DeviceResource(std::move(in_name), device), image(in_image)
 {
     VkImageViewCreateInfo image_view_infos{.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
                                            .image = image,
@@ -77,7 +77,8 @@ Pipeline::Pipeline(std::string in_name, std::weak_ptr<Device> in_device, const s
 {
     std::vector<VkVertexInputAttributeDescription> vertex_attribute_description;
 
-    uint32_t vertex_input_size = 0;
+    uint32_t vertex_input_size   = 0;
+    uint32_t instance_input_size = 0;
 
     for (const auto& stage : shader_stage)
     {
@@ -93,25 +94,51 @@ Pipeline::Pipeline(std::string in_name, std::weak_ptr<Device> in_device, const s
                 if (used_inputs.contains(input_property.location))
                     vertex_attribute_description.emplace_back(VkVertexInputAttributeDescription{
                         .location = static_cast<uint32_t>(input_property.location),
+                        .binding = 0,
                         .format = static_cast<VkFormat>(input_property.format),
                         .offset = input_property.offset,
                     });
 
                 vertex_input_size += get_format_channel_count(input_property.format) * get_format_bytes_per_pixel(input_property.format);
             }
+
+            // Per instance stream (binding 1), only bound if the shader reads it
+            for (const auto& input_property : create_infos.instance_inputs)
+            {
+                if (used_inputs.contains(input_property.location))
+                {
+                    vertex_attribute_description.emplace_back(VkVertexInputAttributeDescription{
+                        .location = static_cast<uint32_t>(input_property.location),
+                        .binding = 1,
+                        .format = static_cast<VkFormat>(input_property.format),
+                        .offset = input_property.offset,
+                    });
+                    b_instance_stream = true;
+                }
+
+                instance_input_size += get_format_channel_count(input_property.format) * get_format_bytes_per_pixel(input_property.format);
+            }
         }
     }
 
-    const VkVertexInputBindingDescription bindingDescription{
-        .binding = 0,
-        .stride = vertex_input_size,
-        .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
-    };
+    std::vector<VkVertexInputBindingDescription> binding_descriptions;
+    if (vertex_input_size > 0)
+        binding_descriptions.emplace_back(VkVertexInputBindingDescription{
+            .binding = 0,
+            .stride = vertex_input_size,
+            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+        });
+    if (b_instance_stream)
+        binding_descriptions.emplace_back(VkVertexInputBindingDescription{
+            .binding = 1,
+            .stride = instance_input_size,
+            .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE,
+        });
 
     const VkPipelineVertexInputStateCreateInfo vertex_input_state{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescription.stride > 0 ? 1 : 0),
-        .pVertexBindingDescriptions = bindingDescription.stride > 0 ? &bindingDescription : nullptr,
+        .vertexBindingDescriptionCount = static_cast<uint32_t>(binding_descriptions.size()),
+        .pVertexBindingDescriptions = binding_descriptions.empty() ? nullptr : binding_descriptions.data(),
         .vertexAttributeDescriptionCount = static_cast<uint32_t>(vertex_attribute_description.size()),
         .pVertexAttributeDescriptions = vertex_attribute_description.data(),
     };
@@ -213,8 +240,18 @@ Pipeline::Pipeline(std::string in_name, std::weak_ptr<Device> in_device, const s
 
     layout = PipelineLayout::create(name(), device(), shader_stage);
 
+    // With dynamic rendering, the pipeline is compatible with any pass using the same attachment formats
+    const auto&                         color_formats = render_pass.lock()->get_color_formats();
+    const VkPipelineRenderingCreateInfo rendering_infos{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+        .colorAttachmentCount = static_cast<uint32_t>(color_formats.size()),
+        .pColorAttachmentFormats = color_formats.data(),
+        .depthAttachmentFormat = render_pass.lock()->get_depth_format(),
+    };
+
     VkGraphicsPipelineCreateInfo pipelineInfo{
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = device().lock()->use_dynamic_rendering() ? &rendering_infos : nullptr,
         .stageCount = static_cast<uint32_t>(shaderStages.size()),
         .pStages = shaderStages.data(),
         .pVertexInputState = &vertex_input_state,
@@ -28,7 +28,7 @@ Queues::Queues(const PhysicalDevice& physical_device, const Surface& surface)
     {
         VkBool32 presentSupport = false;
         vkGetPhysicalDeviceSurfaceSupportKHR(physical_device.raw(), i, surface.raw(), &presentSupport);
-        auto queue = std::make_shared<QueueFamily>(i, queueFamily.queueFlags, presentSupport, queue_global_lock);
+        auto queue = std::make_shared<QueueFamily>(i, queueFamily.queueFlags, presentSupport, queueFamily.timestampValidBits, queue_global_lock);
         all_queues.emplace_back(queue);
         i++;
     }
@@ -144,8 +144,8 @@ const char* get_queue_specialization_name(QueueSpecialization elem)
     return "Unhandled queue specialization generic_name";
 }
 
-QueueFamily::QueueFamily(uint32_t index, VkQueueFlags flags, bool support_present, std::shared_ptr<std::shared_mutex> in_queue_global_lock)
-    : queue_index(index), queue_flags(flags), queue_support_present(support_present), queue_global_lock(in_queue_global_lock)
+QueueFamily::QueueFamily(uint32_t index, VkQueueFlags flags, bool support_present, uint32_t timestamp_valid_bits, std::shared_ptr<std::shared_mutex> in_queue_global_lock)
+    : queue_index(index), queue_flags(flags), queue_support_present(support_present), queue_timestamp_valid_bits(timestamp_valid_bits), queue_global_lock(in_queue_global_lock)
 {
 }
 
@@ -192,6 +192,24 @@ VkResult QueueFamily::submit(const CommandBuffer& cmd, VkSubmitInfo submit_infos
     return result;
 }
 
+VkResult QueueFamily::submit(std::span<const VkSubmitInfo2> submits, const Fence* optional_fence)
+{
+    std::lock_guard lk(queue_mutex);
+    {
+        PROFILER_SCOPE(WaitQueueAvailable);
+        queue_global_lock->lock_shared();
+    }
+    if (optional_fence)
+    {
+        PROFILER_SCOPE(ResetFence);
+        optional_fence->reset();
+    }
+    PROFILER_SCOPE(SubmitQueue);
+    auto result = vkQueueSubmit2(ptr, static_cast<uint32_t>(submits.size()), submits.data(), optional_fence ? optional_fence->raw() : nullptr);
+    queue_global_lock->unlock_shared();
+    return result;
+}
+
 auto Queues::find_best_suited_queue_family(const ankerl::unordered_dense::map<uint32_t, std::shared_ptr<QueueFamily>>& available, VkQueueFlags required_flags, bool require_present,
                                            const std::vector<VkQueueFlags>& desired_queue_flags) -> std::shared_ptr<QueueFamily>
 {
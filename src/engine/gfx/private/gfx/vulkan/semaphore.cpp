@@ -15,4 +15,17 @@ Semaphore::~Semaphore()
 {
     vkDestroySemaphore(device.lock()->raw(), ptr, nullptr);
 }
+
+TimelineSemaphore::TimelineSemaphore(const std::string& name, std::weak_ptr<Device> in_device) : device(std::move(in_device))
+{
+    VkSemaphoreTypeCreateInfo type_infos{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO, .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE, .initialValue = 0};
+    VkSemaphoreCreateInfo     create_infos{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, .pNext = &type_infos};
+    VK_CHECK(vkCreateSemaphore(device.lock()->raw(), &create_infos, nullptr, &ptr), "Failed to create timeline semaphore")
+    device.lock()->debug_set_object_name(name, ptr);
+}
+
+TimelineSemaphore::~TimelineSemaphore()
+{
+    vkDestroySemaphore(device.lock()->raw(), ptr, nullptr);
+}
 } // namespace Eng::Gfx
@@ -0,0 +1,92 @@
+#include "gfx/vulkan/submit_batch.hpp"
+
+#include "logger.hpp"
+#include "gfx/vulkan/command_buffer.hpp"
+#include "gfx/vulkan/device.hpp"
+#include "gfx/vulkan/queue_family.hpp"
+#include "gfx/vulkan/vk_check.hpp"
+
+#include <algorithm>
+#include <deque>
+
+namespace Eng::Gfx
+{
+void SubmitBatch::add(CommandBuffer& cmd, std::span<const VkSemaphoreSubmitInfo> waits, std::span<const VkSemaphoreSubmitInfo> signals, const Fence* fence)
+{
+    // Specializations can share the same queue
+    const auto queue = device.lock()->get_queues().get_queue(cmd.get_specialization());
+    auto       batch = std::ranges::find(queues, queue, &QueueBatch::queue);
+    if (batch == queues.end())
+        batch = queues.insert(queues.end(), QueueBatch{.queue = queue});
+    if (fence)
+    {
+        if (batch->fence)
+            LOG_FATAL("Cannot signal two fences in the same batch of queue {}", get_queue_specialization_name(cmd.get_specialization()));
+        batch->fence = fence;
+    }
+
+    batch->submissions.emplace_back(Submission{
+        .cmd          = &cmd,
+        .first_wait   = static_cast<uint32_t>(semaphores.size()),
+        .wait_count   = static_cast<uint32_t>(waits.size()),
+        .first_signal = static_cast<uint32_t>(semaphores.size() + waits.size()),
+        .signal_count = static_cast<uint32_t>(signals.size()),
+    });
+    semaphores.insert(semaphores.end(), waits.begin(), waits.end());
+    semaphores.insert(semaphores.end(), signals.begin(), signals.end());
+}
+
+uint32_t SubmitBatch::flush()
+{
+    uint32_t submit_calls = 0;
+    for (auto& batch : queues)
+    {
+        if (batch.submissions.empty())
+            continue;
+
+        // Pointers to these elements are given to vulkan : no reallocation while filling them
+        command_buffers.clear();
+        command_buffers.reserve(batch.submissions.size());
+        submit_infos.clear();
+
+        // The pool of each command buffer is locked once, even if it allocated multiple of them
+        locked_pools.clear();
+        std::deque<PoolLockGuard> pool_locks;
+        for (const auto& submission : batch.submissions)
+        {
+            CommandPool::Mutex& pool = submission.cmd->get_pool_mutex();
+            if (std::ranges::none_of(locked_pools,
+                                     [&](const CommandPool::Mutex* locked)
+                                     {
+                                         return *locked == pool;
+                                     }))
+            {
+                locked_pools.emplace_back(&pool);
+                pool_locks.emplace_back(pool);
+            }
+            submission.cmd->mark_submitted();
+
+            command_buffers.emplace_back(VkCommandBufferSubmitInfo{
+                .sType         = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+                .commandBuffer = submission.cmd->raw(),
+            });
+            submit_infos.emplace_back(VkSubmitInfo2{
+                .sType                    = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+                .waitSemaphoreInfoCount   = submission.wait_count,
+                .pWaitSemaphoreInfos      = semaphores.data() + submission.first_wait,
+                .commandBufferInfoCount   = 1,
+                .pCommandBufferInfos      = &command_buffers.back(),
+                .signalSemaphoreInfoCount = submission.signal_count,
+                .pSignalSemaphoreInfos    = semaphores.data() + submission.first_signal,
+            });
+        }
+        VK_CHECK(batch.queue->submit(submit_infos, batch.fence), "Failed to submit queue")
+        ++submit_calls;
+
+        batch.submissions.clear();
+        batch.fence = nullptr;
+    }
+    semaphores.clear();
+    return submit_calls;
+}
+} // namespace Eng::Gfx
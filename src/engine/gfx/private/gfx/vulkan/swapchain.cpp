@@ -10,6 +10,7 @@
 #include "gfx/vulkan/semaphore.hpp"
 #include "gfx/vulkan/surface.hpp"
 #include "gfx/window.hpp"
+#include "frames_in_flight.hpp"
 #include "profiler.hpp"
 
 namespace Eng::Gfx
@@ -27,11 +28,15 @@ Swapchain::~Swapchain()
     swapChainImages.clear();
 }
 
-std::vector<VkSemaphore> Swapchain::get_semaphores_to_wait(DeviceImageId swapchain_image) const
+void Swapchain::get_semaphores_to_wait(DeviceImageId swapchain_image, std::vector<VkSemaphoreSubmitInfo>& semaphores) const
 {
-    auto semaphores = RenderPassInstance::get_semaphores_to_wait(swapchain_image);
-    semaphores.push_back(image_available_semaphores[swapchain_image].get()->raw());
-    return semaphores;
+    RenderPassInstance::get_semaphores_to_wait(swapchain_image, semaphores);
+    // The swapchain image is transitioned before being drawn
+    semaphores.emplace_back(VkSemaphoreSubmitInfo{
+        .sType     = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+        .semaphore = image_available_semaphores[swapchain_image].get()->raw(),
+        .stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+    });
 }
 
 ColorFormat Swapchain::get_swapchain_format(const std::weak_ptr<Device>& in_device, const std::weak_ptr<Surface>& surface)
@@ -98,12 +103,7 @@ void Swapchain::create_or_recreate()
     VkSurfaceFormatKHR surfaceFormat = choose_surface_format(swapchain_support.formats);
     swapchain_format                 = static_cast<ColorFormat>(surfaceFormat.format);
     extent                           = new_extent;
-    uint32_t imageCount              = get_image_count();
-
-    if (swapchain_support.capabilities.maxImageCount > 0 && imageCount > swapchain_support.capabilities.maxImageCount)
-    {
-        imageCount = swapchain_support.capabilities.maxImageCount;
-    }
+    uint32_t imageCount              = FramesInFlight::swapchain_image_count(device_ptr->get_image_count(), swapchain_support.capabilities.minImageCount, swapchain_support.capabilities.maxImageCount);
 
     VkSwapchainCreateInfoKHR createInfo{
         .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
@@ -146,7 +146,7 @@ void Swapchain::create_or_recreate()
     for (uint32_t i = 0; i < device_ptr->get_image_count(); ++i)
         image_available_semaphores.emplace_back(Semaphore::create(get_definition().render_pass_ref.to_string() + "_sem_#" + std::to_string(i), device()));
 
-    render_finished_fences.resize(get_image_count());
+    render_finished_fences.resize(device_ptr->get_image_count());
     for (auto& fence : render_finished_fences)
         fence = Fence::create(std::format("Render fence semaphore : {}", get_definition().render_pass_ref), device());
 
@@ -172,7 +172,10 @@ std::shared_ptr<ImageView> Swapchain::create_view_for_attachment(const std::stri
 
 uint8_t Swapchain::get_image_count() const
 {
-    return device().lock()->get_image_count() + 1;
+    // One image more than the frames in flight is requested, but the presentation engine can create more
+    if (!swapChainImages.empty())
+        return static_cast<uint8_t>(swapChainImages.size());
+    return static_cast<uint8_t>(FramesInFlight::swapchain_image_count(device().lock()->get_image_count(), 0, 0));
 }
 
 bool Swapchain::render_internal()
@@ -230,6 +233,7 @@ void Swapchain::destroy()
     device().lock()->wait();
     in_flight_fences.clear();
     image_view = nullptr;
+    swapChainImages.clear();
 
     if (ptr != VK_NULL_HANDLE)
     {
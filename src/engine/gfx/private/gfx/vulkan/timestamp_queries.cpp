@@ -0,0 +1,61 @@
+#include "gfx/vulkan/timestamp_queries.hpp"
+
+#include "gfx/vulkan/command_buffer.hpp"
+#include "gfx/vulkan/device.hpp"
+
+namespace Eng::Gfx
+{
+TimestampQueries::TimestampQueries(const std::string& name, std::weak_ptr<Device> in_device, uint8_t image_count) : DeviceResource(name, std::move(in_device)), images(image_count)
+{
+    const VkQueryPoolCreateInfo create_infos{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = image_count * 2u,
+    };
+    VK_CHECK(vkCreateQueryPool(device().lock()->raw(), &create_infos, nullptr, &ptr), "Failed to create query pool")
+    device().lock()->debug_set_object_name(name, ptr);
+}
+
+TimestampQueries::~TimestampQueries()
+{
+    vkDestroyQueryPool(device().lock()->raw(), ptr, nullptr);
+}
+
+void TimestampQueries::write_begin(const CommandBuffer& cmd, uint8_t image)
+{
+    vkCmdResetQueryPool(cmd.raw(), ptr, image * 2u, 2);
+    vkCmdWriteTimestamp(cmd.raw(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, ptr, image * 2u);
+    images[image].recorded_time = std::chrono::steady_clock::now();
+    images[image].b_written     = true;
+}
+
+void TimestampQueries::write_end(const CommandBuffer& cmd, uint8_t image)
+{
+    if (images[image].b_written)
+        vkCmdWriteTimestamp(cmd.raw(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, ptr, image * 2u + 1);
+}
+
+bool TimestampQueries::read(uint8_t image, uint64_t& begin, uint64_t& end, std::chrono::steady_clock::time_point& recorded_time)
+{
+    if (!images[image].b_written)
+        return false;
+    images[image].b_written = false;
+
+    // Value then availability of each query
+    uint64_t results[4] = {};
+    if (vkGetQueryPoolResults(device().lock()->raw(), ptr, image * 2u, 2, sizeof(results), results, sizeof(uint64_t) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT) < 0)
+        return false;
+    if (results[1] == 0 || results[3] == 0)
+        return false;
+    begin         = results[0];
+    end           = results[2];
+    recorded_time = images[image].recorded_time;
+    return true;
+}
+
+void TimestampQueries::discard()
+{
+    for (auto& image : images)
+        image.b_written = false;
+}
+} // namespace Eng::Gfx
@@ -12,6 +12,7 @@ class GfxConfig
     bool        enable_validation_layers = false;
     bool        allow_integrated_gpus    = false;
     bool        v_sync                   = true;
-    uint8_t     swapchain_image_count    = 2;
+    bool        dynamic_rendering        = true; // Begin the passes with vkCmdBeginRendering when the device supports it (render passes and framebuffers are created otherwise)
+    uint8_t     frames_in_flight         = 2; // Frames recorded by the cpu while the gpu renders the previous ones (the swapchain has one more image)
 };
 } // namespace Eng::Gfx
\ No newline at end of file
@@ -52,6 +52,14 @@ public:
         return *this;
     }
 
+    // The content is kept between frames (passes skipping their draws, images read outside the render graph). Other attachments only hold a valid
+    // content until the passes requiring this pass are done, their memory can then be reused by other attachments (see AttachmentAliasing).
+    Attachment& persistent(bool in_persistent)
+    {
+        b_persistent = in_persistent;
+        return *this;
+    }
+
     bool has_clear() const
     {
         return clear_color_value.has_value() || clear_depth_value.has_value();
@@ -61,6 +69,7 @@ public:
     ColorFormat              color_format      = ColorFormat::UNDEFINED;
     std::optional<glm::vec4> clear_color_value = {};
     std::optional<glm::vec2> clear_depth_value = {};
+    bool                     b_persistent      = false;
 
 private:
     Attachment(std::string in_name) : name(std::move(in_name))
@@ -75,6 +84,7 @@ public:
     {
     }
 
+    // Called when the attachments of this pass or of one of its dependencies were created again
     virtual void on_create_framebuffer(const RenderPassInstanceBase&)
     {
     }
@@ -83,6 +93,26 @@ public:
     {
     }
 
+    /**
+     * Called after pre_draw. Return false to skip the draws of this frame : the attachments keep the content of the last frame rendered in the same
+     * image (one per frame in flight, see RenderPassInstanceBase::get_current_swapchain_image() and ImageSignatures).
+     */
+    virtual bool should_render(const RenderPassInstanceBase&)
+    {
+        return true;
+    }
+
+    /**
+     * Called after should_render. Hash of everything the commands recorded by draw() depend on (visible objects, materials, matrices...), or 0 to
+     * record every frame. When it matches the signature of the last frame recorded in the same image, the previous secondary command buffers are
+     * executed again instead of calling draw(). They are also recorded again when the attachments are created again.
+     */
+    virtual uint64_t get_content_signature(const RenderPassInstanceBase&)
+    {
+        return 0;
+    }
+
+    // Record the draws of a group (lower than RenderPassInstanceBase::get_record_jobs())
     virtual void draw(const RenderPassInstanceBase&, CommandBuffer&, size_t)
     {
     }
@@ -91,11 +121,17 @@ public:
     {
     }
 
-    // Get the number of thread used by this renderer (if > 1, parallel rendering will be automatically enabled)
+    // Maximum number of jobs recording the draws of this renderer (if > 1, parallel rendering will be automatically enabled)
     virtual size_t record_threads()
     {
         return 0;
     }
+
+    // Number of draws expected this frame, called after pre_draw (nullopt if unknown). Used to choose how many of the record_threads() jobs are started.
+    virtual std::optional<size_t> get_draw_count(const RenderPassInstanceBase&)
+    {
+        return std::nullopt;
+    }
 };
 
 struct RenderPassKey
@@ -42,9 +42,16 @@ protected:
     RenderPassInstance(std::weak_ptr<Device> device, const Renderer& renderer, const RenderPassGenericId& rp_ref, bool b_is_present);
 
     void render_internal(SwapchainImageId swapchain_image, DeviceImageId device_image) override;
+    void create_framebuffers(FrameResources& resources) override;
+    bool is_present_pass() const override;
 
     virtual void fill_command_buffer(CommandBuffer& cmd, size_t group_index) const;
   private:
+    // Begin the render pass and record the draws of every record thread
+    void record_render_pass(CommandBuffer& global_cmd, const Framebuffer& framebuffer, DeviceImageId device_image);
+    // Begin the pass from the views of the framebuffer (Device::use_dynamic_rendering())
+    void begin_rendering(CommandBuffer& global_cmd, const Framebuffer& framebuffer, const std::vector<VkClearValue>& clear_values, bool b_secondaries) const;
+
     std::weak_ptr<VkRendererPass> render_pass_resource;
     std::unique_ptr<ImGuiWrapper> imgui_context;
 };
@@ -1,10 +1,20 @@
 #pragma once
 #include "gfx/renderer/definition/render_pass_id.hpp"
 #include "gfx/renderer/definition/renderer.hpp"
+#include "attachment_aliasing.hpp"
 #include "logger.hpp"
+#include "record_job_estimator.hpp"
+#include "render_graph_barriers.hpp"
+#include "render_graph_schedule.hpp"
 #include "gfx/vulkan/device.hpp"
 #include "gfx/vulkan/device_resource.hpp"
+#include "gfx/vulkan/image.hpp"
+#include "gfx/vulkan/queue_family.hpp"
+#include "gfx/vulkan/submit_batch.hpp"
+#include "gfx/vulkan/timestamp_queries.hpp"
 
+#include <array>
+#include <atomic>
 #include <ankerl/unordered_dense.h>
 #include <glm/vec2.hpp>
 #include <memory>
@@ -26,6 +36,7 @@ class VkRendererPass;
 class RenderPassInstance;
 class ImageView;
 class Semaphore;
+class TimelineSemaphore;
 class Fence;
 class Renderer;
 class Device;
@@ -49,21 +60,35 @@ public:
 class PassCommandPool : public DeviceResource
 {
 public:
-    PassCommandPool(std::weak_ptr<Device> in_device, const std::string& name);
+    PassCommandPool(std::weak_ptr<Device> in_device, const std::string& name, QueueSpecialization queue);
 
     CommandBuffer& begin_primary(DeviceImageId image);
     CommandBuffer& begin_secondary(DeviceImageId image, const Framebuffer& framebuffer, CommandBuffer& parent);
 
+    /**
+     * Execute again in parent the secondary command buffers last recorded for this image, if it was for the same framebuffer and content signature
+     * (0 is never reused). Otherwise, the secondary command buffers begun next are kept to be reused by the next frames.
+     */
+    bool reuse_secondaries(DeviceImageId image, const Framebuffer& framebuffer, uint64_t content_signature, CommandBuffer& parent);
+    // The recorded secondary command buffers are outdated (new attachments, rebound descriptors...)
+    void invalidate_secondaries();
+
 private:
     CommandBuffer& get_primary(DeviceImageId image);
     struct FrameCommands
     {
         ankerl::unordered_dense::map<std::thread::id, std::shared_ptr<CommandBuffer>>          primary_command_buffers;
         ankerl::unordered_dense::map<std::thread::id, std::shared_ptr<SecondaryCommandBuffer>> secondary_command_buffer;
+
+        // Secondary command buffers of the last recording
+        std::vector<std::shared_ptr<SecondaryCommandBuffer>> recorded_secondaries;
+        const Framebuffer*                                   recorded_framebuffer = nullptr;
+        uint64_t                                             recorded_signature   = 0;
     };
 
     std::mutex                 lock;
     std::vector<FrameCommands> per_frame_data;
+    QueueSpecialization        queue;
 };
 
 
@@ -82,7 +107,8 @@ public:
     // Should be called before each frame to reset max draw flags
     void                    reset_for_next_frame();
     virtual FrameResources* create_or_resize(const glm::uvec2& viewport, const glm::uvec2& parent, bool b_force = false);
-    void                    render(SwapchainImageId swapchain_image, DeviceImageId device_image);
+    // Render this pass and its dependencies following the execution plan (compiled again when a custom pass is added or removed)
+    void render(SwapchainImageId swapchain_image, DeviceImageId device_image);
 
     /**
      * The resolution of this current pass
@@ -156,8 +182,19 @@ public:
         return frame_resources->framebuffers[swapchain_image].get();
     }
 
-    // Retrieve a list of VkSemaphores to wait before submitting
-    virtual std::vector<VkSemaphore> get_semaphores_to_wait(DeviceImageId image) const;
+    // Number of jobs recording the draws of the current frame (chosen from the draw count and the recording cost of the last frames)
+    uint32_t get_record_jobs() const
+    {
+        return record_jobs;
+    }
+
+    RecordJobEstimator::Settings& record_job_settings()
+    {
+        return record_job_estimator.settings;
+    }
+
+    // Append the semaphores to wait before submitting, with the value to wait (ignored for binary semaphores) and the stages waiting for each of them
+    virtual void get_semaphores_to_wait(DeviceImageId image, std::vector<VkSemaphoreSubmitInfo>& semaphores) const;
 
     void init();
 
@@ -170,8 +207,19 @@ protected:
         return nullptr;
     }
 
+    // Binary semaphore waited by the presentation (only created for the present pass)
     VkSemaphore get_render_finished_semaphore() const;
 
+    // Submit the pass : wait for the dependencies, then signal the next value of the timeline semaphore.
+    // The command buffer is only given to the queue once the whole graph is recorded, with the other passes of the frame.
+    void submit(CommandBuffer& cmd, DeviceImageId device_image);
+
+    // Queue executing this pass. Compute passes use the async compute queue if the device has one.
+    QueueSpecialization get_queue() const
+    {
+        return queue;
+    }
+
     // Are drawcalls split in multiple jobs for this pass
     bool enable_parallel_rendering() const
     {
@@ -181,6 +229,27 @@ protected:
     // Create image and the image view for the given attachment
     virtual std::shared_ptr<ImageView> create_view_for_attachment(const std::string& attachment);
 
+    ImageParameter get_attachment_parameters(const std::string& attachment) const;
+
+    // Create the framebuffers using the given attachments
+    virtual void create_framebuffers(FrameResources&)
+    {
+    }
+
+    // Are the attachments of this pass presented once the graph is rendered
+    virtual bool is_present_pass() const
+    {
+        return false;
+    }
+
+    // Transition the attachments before writing them, then for their readers (planned by the root pass)
+    void record_begin_barriers(const CommandBuffer& cmd, SwapchainImageId image);
+    void record_end_barriers(const CommandBuffer& cmd, SwapchainImageId image);
+
+    // Gpu execution of the pass while the profiler records : the timestamps of the previous use of the image are sent to the profiler first
+    void write_begin_timestamp(const CommandBuffer& cmd, DeviceImageId image);
+    void write_end_timestamp(const CommandBuffer& cmd, DeviceImageId image);
+
     // Implement the mechanics to draw this render pass
     virtual void render_internal(SwapchainImageId swapchain_image, DeviceImageId device_image) = 0;
 
@@ -188,16 +257,78 @@ protected:
 
     virtual void fill_command_buffer(CommandBuffer& cmd, size_t group_index) const;
 
-    std::unique_ptr<PassCommandPool> command_buffers;
+    std::unique_ptr<PassCommandPool>  command_buffers;
+    std::unique_ptr<TimestampQueries> timestamp_queries; // Created the first time the profiler records
+
+    RecordJobEstimator record_job_estimator;
+    uint32_t           record_jobs = 1;
 
 private:
-    bool prepared  = false;
+    // Flatten the pass tree (with the custom passes) into the execution plan
+    void compile_plan();
+    // Render a pass of the plan, then the consumers it unlocked. The calling thread must be counted in plan_workers.
+    void render_plan_node(uint32_t node, DeviceImageId device_image);
+    // Create the transient attachments of the plan again in shared memory blocks
+    void alias_attachments();
+    // Plan the layout transitions of the attachments and the stages waiting for each dependency
+    void compile_barriers();
+
+    // Batch of image barriers recorded with a single vkCmdPipelineBarrier
+    struct PlannedBarriers
+    {
+        struct Barrier
+        {
+            std::shared_ptr<ImageView> image;
+            VkImageAspectFlags         aspect;
+            VkImageLayout              old_layout;
+            VkImageLayout              new_layout;
+            VkAccessFlags              src_access;
+            VkAccessFlags              dst_access;
+        };
+
+        std::vector<Barrier> barriers;
+        VkPipelineStageFlags src_stages = 0;
+        VkPipelineStageFlags dst_stages = 0;
+    };
+    void record_barriers(const CommandBuffer& cmd, const PlannedBarriers& planned, SwapchainImageId image);
+
     bool submitted = false;
 
+    // Execution plan, only used by the root pass. Node 0 is the root.
+    RenderGraphSchedule                                  plan;
+    std::vector<RenderPassInstanceBase*>                 plan_passes;
+    std::vector<std::shared_ptr<RenderPassInstanceBase>> plan_references;
+    std::unique_ptr<std::atomic<uint32_t>[]>             plan_pending;
+    std::atomic<uint32_t>                                plan_workers = 0; // Threads rendering passes of the plan, joined before rendering the root
+    uint64_t                                             plan_revision = UINT64_MAX;
+    AttachmentAliasing                                   attachment_aliasing;
+    RenderGraphBarriers                                  graph_barriers;
+
+    // Passes whose render finished semaphore is waited before submitting, with the stages waiting for them (set by the plan of the root pass)
+    std::vector<const RenderPassInstanceBase*> plan_waits;
+    std::vector<VkPipelineStageFlags>          plan_wait_stages;
+    PlannedBarriers                            begin_barriers;
+    PlannedBarriers                            end_barriers;
+    std::vector<VkImageMemoryBarrier>          image_barriers; // Reused by each record
+
+    // Submission of the current frame, flushed by the root pass in the order of the plan
+    struct PendingSubmit
+    {
+        CommandBuffer*                       cmd = nullptr;
+        std::vector<VkSemaphoreSubmitInfo>   waits;
+        std::array<VkSemaphoreSubmitInfo, 2> signals{};
+        uint32_t                             signal_count = 0;
+        const Fence*                         fence        = nullptr;
+    };
+    PendingSubmit pending_submit;
+    SubmitBatch   submit_batch; // Only used by the root pass
+
     std::shared_ptr<FrameResources> frame_resources;
     std::shared_ptr<FrameResources> next_frame_resources;
 
+    std::shared_ptr<TimelineSemaphore>      timeline_semaphore;
     std::vector<std::shared_ptr<Semaphore>> render_finished_semaphores;
+    QueueSpecialization                     queue = QueueSpecialization::Graphic;
 
     ankerl::unordered_dense::map<RenderPassRef, std::shared_ptr<RenderPassInstanceBase>> dependencies;
     std::shared_ptr<CustomPassList>                                                      custom_passes;
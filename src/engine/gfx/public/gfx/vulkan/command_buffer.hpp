@@ -1,6 +1,7 @@
 #pragma once
 #include "command_pool.hpp"
 
+#include <array>
 #include <memory>
 #include <utility>
 
@@ -34,6 +35,7 @@ namespace Eng::Gfx
 class DescriptorSet;
 class Pipeline;
 class BufferData;
+class Buffer;
 class Mesh;
 class Fence;
 class Device;
@@ -46,6 +48,29 @@ struct Scissor
     uint32_t height;
 };
 
+// Commands recorded since the last begin(). Redundant binds and push constants are filtered and counted as skipped.
+struct CommandBufferStats
+{
+    uint32_t draws                  = 0;
+    uint32_t pipeline_binds         = 0;
+    uint32_t descriptor_binds       = 0;
+    uint32_t vertex_buffer_binds    = 0;
+    uint32_t index_buffer_binds     = 0;
+    uint32_t push_constants         = 0;
+    uint32_t skipped_pipelines      = 0;
+    uint32_t skipped_descriptors    = 0;
+    uint32_t skipped_vertex_buffers = 0;
+    uint32_t skipped_index_buffers  = 0;
+    uint32_t skipped_push_constants = 0;
+
+    uint32_t skipped() const
+    {
+        return skipped_pipelines + skipped_descriptors + skipped_vertex_buffers + skipped_index_buffers + skipped_push_constants;
+    }
+
+    CommandBufferStats& operator+=(const CommandBufferStats& other);
+};
+
 struct Viewport
 {
     float x = 0;
@@ -76,6 +101,15 @@ public:
     virtual void begin(bool one_time);
     virtual void end();
     void         submit(VkSubmitInfo submit_infos, const Fence* optional_fence = nullptr);
+    // The command buffer was submitted by a SubmitBatch : the next begin() starts a new recording
+    void mark_submitted()
+    {
+        b_wait_submission = false;
+    }
+    CommandPool::Mutex& get_pool_mutex()
+    {
+        return pool_mtx;
+    }
 
     void begin_debug_marker(const std::string& name, const std::array<float, 4>& color);
     void end_debug_marker();
@@ -84,11 +118,18 @@ public:
     void bind_pipeline(const std::shared_ptr<Pipeline>& pipeline);
     void bind_descriptors(DescriptorSet& descriptors, const Pipeline& pipeline) const;
     void draw_mesh(const Mesh& in_buffer, uint32_t instance_count = 1, uint32_t first_instance = 0) const;
+    // Bind the vertex and index buffers of the mesh. draw_bound_mesh() can then draw it multiple times without rebinding.
+    void bind_mesh(const Mesh& in_buffer) const;
+    void draw_bound_mesh(const Mesh& in_buffer, uint32_t instance_count = 1, uint32_t first_instance = 0) const;
+    // Bind an additional vertex stream (ex : per instance data on binding 1)
+    void bind_vertex_buffer(uint32_t binding, Buffer& buffer, size_t byte_offset = 0) const;
     void draw_mesh(const Mesh& in_buffer, uint32_t first_index, uint32_t vertex_offset, uint32_t index_count, uint32_t instance_count = 1, uint32_t first_instance = 0) const;
     void set_scissor(const Scissor& scissors) const;
     void set_viewport(const Viewport& viewport) const;
     void push_constant(EShaderStage stage, const Pipeline& pipeline, const BufferData& data) const;
     void begin_render_pass(const RenderPassRef& pass_name, const VkRenderPassBeginInfo& begin_infos, bool parallel_rendering);
+    // Same as begin_render_pass() with dynamic rendering (the contents flag replaces parallel_rendering). Ended by end_render_pass().
+    void begin_rendering(const RenderPassRef& pass_name, const VkRenderingInfo& rendering_infos);
 
     void bind_compute_pipeline(const ComputePipeline& pipeline) const;
     void bind_descriptors(const DescriptorSet& descriptors, const ComputePipeline& pipeline) const;
@@ -116,14 +157,23 @@ public:
         return render_pass_name;
     }
 
+    // Include the stats of the secondary command buffers executed by this one
+    const CommandBufferStats& get_stats() const
+    {
+        return stats;
+    }
+
     void thread_lock();
 
     void thread_unlock();
 
   protected:
     RenderPassRef render_pass_name;
+    bool          b_dynamic_rendering = false;
     friend class SecondaryCommandBuffer;
     void                                                                  reset_stats();
+    // Forget the bound state (ex : after executing secondary command buffers)
+    void                                                                  reset_bound_state() const;
     std::mutex                                                            secondary_vector_mtx;
     ankerl::unordered_dense::set<std::shared_ptr<SecondaryCommandBuffer>> secondary_command_buffers;
     std::unique_ptr<PoolLockGuard>                                        pool_lock;
@@ -140,6 +190,30 @@ private:
     std::shared_ptr<Pipeline> last_pipeline;
     bool                      is_recording      = false;
     bool                      b_wait_submission = false;
+
+    static constexpr uint32_t MAX_VERTEX_BINDINGS    = 4;
+    static constexpr uint32_t MAX_PUSH_CONSTANT_SIZE = 128;
+    static constexpr uint32_t MAX_DESCRIPTOR_SETS    = 4;
+
+    // Currently bound graphic state, used to filter redundant commands
+    struct BoundState
+    {
+        VkPipelineLayout                                 descriptors_layout = VK_NULL_HANDLE;
+        std::array<VkDescriptorSet, MAX_DESCRIPTOR_SETS> descriptor_sets    = {};
+        std::array<VkBuffer, MAX_VERTEX_BINDINGS>        vertex_buffers     = {};
+        std::array<VkDeviceSize, MAX_VERTEX_BINDINGS>    vertex_offsets     = {};
+        VkBuffer                                         index_buffer       = VK_NULL_HANDLE;
+        VkIndexType                                      index_type         = VK_INDEX_TYPE_MAX_ENUM;
+        VkPipelineLayout                                 push_layout        = VK_NULL_HANDLE;
+        VkShaderStageFlags                               push_stages        = 0;
+        uint32_t                                         push_size          = 0;
+        std::array<uint8_t, MAX_PUSH_CONSTANT_SIZE>      push_data          = {};
+    };
+
+    void bind_vertex_buffer_internal(uint32_t binding, VkBuffer buffer, VkDeviceSize offset) const;
+
+    mutable BoundState         bound;
+    mutable CommandBufferStats stats;
 };
 
 class SecondaryCommandBuffer : public CommandBuffer, public std::enable_shared_from_this<SecondaryCommandBuffer>
@@ -159,6 +233,9 @@ public:
         parent      = parent_command_buffer;
     }
 
+    // Execute the recorded commands again in a new parent, without recording them (the framebuffer must be the same)
+    void execute_again(CommandBuffer& parent_command_buffer);
+
 private:
     const Framebuffer*           framebuffer = nullptr;
     CommandBuffer* parent;
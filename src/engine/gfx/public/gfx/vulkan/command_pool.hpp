@@ -27,6 +27,11 @@ class CommandPool
         {
         }
 
+        bool operator==(const Mutex& other) const
+        {
+            return pool_mtx == other.pool_mtx;
+        }
+
       private:
         std::thread::id                    pool_thread_id;
         std::shared_ptr<std::shared_mutex> pool_mtx;
@@ -4,8 +4,11 @@
 #include "gfx/gfx.hpp"
 #include "gfx/renderer/definition/render_pass_id.hpp"
 #include "gfx/renderer/definition/renderer.hpp"
+#include "deferred_release.hpp"
+#include "gpu_clock.hpp"
 
 #include <ankerl/unordered_dense.h>
+#include <chrono>
 
 namespace Eng::Gfx
 {
@@ -75,6 +78,7 @@ public:
 
     void destroy_resources();
 
+    // Frames in flight : every per-frame resource is duplicated this many times
     uint8_t get_image_count() const
     {
         return image_count;
@@ -89,22 +93,32 @@ public:
 
     void wait() const;
 
+    // Passes are begun from the views of their attachments : VkRenderPass and VkFramebuffer are not created
+    bool use_dynamic_rendering() const
+    {
+        return b_dynamic_rendering;
+    }
+
+    // Nanoseconds per timestamp tick
+    float get_timestamp_period() const
+    {
+        return timestamp_period;
+    }
+
+    // Cpu time of a timestamp written by the gpu after the command was recorded at recorded_time
+    std::chrono::steady_clock::time_point gpu_to_cpu_time(uint64_t ticks, std::chrono::steady_clock::time_point recorded_time);
+
     void flush_resources();
 
+    // Destroy the resource once the gpu finished the frames that can use it
     void drop_resource(const std::shared_ptr<DeviceResource>& resource)
     {
-        std::lock_guard lock(resource_mutex);
-        if (current_image >= pending_kill_resources.size())
-            pending_kill_resources.resize(current_image + 1);
-        pending_kill_resources[current_image].emplace_back(resource);
+        pending_kill_resources.release(resource, current_image);
     }
 
     void drop_resource(const std::shared_ptr<DeviceResource>& resource, size_t resource_image)
     {
-        std::lock_guard lock(resource_mutex);
-        if (resource_image >= pending_kill_resources.size())
-            pending_kill_resources.resize(resource_image + 1);
-        pending_kill_resources[resource_image].emplace_back(resource);
+        pending_kill_resources.release(resource, resource_image);
     }
 
     DescriptorPool& get_descriptor_pool() const
@@ -199,8 +213,12 @@ public:
     }
 
 private:
+    // Sample the gpu clock with the cpu clock (only if VK_EXT_calibrated_timestamps is available)
+    void calibrate_gpu_clock();
+
     std::mutex object_name_mutex;
     bool       b_enable_validation_layers = false;
+    bool       b_dynamic_rendering        = false;
     Device(const GfxConfig& config, const std::weak_ptr<Instance>& instance, const PhysicalDevice& physical_device, const Surface& surface);
     ankerl::unordered_dense::map<RenderPassKey, std::shared_ptr<VkRendererPass>>                   render_passes;
     ankerl::unordered_dense::map<RenderPassGenericId, std::weak_ptr<VkRendererPass>>               render_passes_named;
@@ -211,10 +229,13 @@ private:
     std::unique_ptr<VmaAllocatorWrap>                                                              allocator;
     uint8_t                                                                                        image_count   = 2;
     uint8_t                                                                                        current_image = 0;
-    std::mutex                                                                                     resource_mutex;
-    std::vector<std::vector<std::shared_ptr<DeviceResource>>>                                      pending_kill_resources;
+    DeferredRelease<std::shared_ptr<DeviceResource>>                                               pending_kill_resources;
     std::shared_ptr<DescriptorPool>                                                                descriptor_pool;
     std::weak_ptr<Instance>                                                                        instance;
     GfxConfig                                                                                      config;
+    float                                                                                          timestamp_period = 1;
+    PFN_vkGetCalibratedTimestampsEXT                                                               get_calibrated_timestamps = nullptr;
+    std::mutex                                                                                     gpu_clock_mutex;
+    GpuClock                                                                                       gpu_clock;
 };
 } // namespace Eng::Gfx
\ No newline at end of file
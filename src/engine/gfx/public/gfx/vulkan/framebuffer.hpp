@@ -3,6 +3,7 @@
 #include "device_resource.hpp"
 
 #include <memory>
+#include <vector>
 #include <ankerl/unordered_dense.h>
 #include <vulkan/vulkan_core.h>
 
@@ -18,6 +19,7 @@ class ImageView;
 class RenderPassInstance;
 class SecondaryCommandBuffer;
 
+// Attachments of a pass for one image. The VkFramebuffer is only created when the device does not use dynamic rendering.
 class Framebuffer : public DeviceResource
 {
   public:
@@ -42,10 +44,17 @@ class Framebuffer : public DeviceResource
         return image_index;
     }
 
+    // Views of the attachments, in the order of the render pass key
+    const std::vector<VkImageView>& get_views() const
+    {
+        return views;
+    }
+
   private:
     Framebuffer(std::weak_ptr<Device> device, const RenderPassInstance& render_pass, uint32_t image_index, const FrameResources& resources);
     uint32_t image_index = 0;
     VkFramebuffer                                                                          ptr = VK_NULL_HANDLE;
     std::weak_ptr<VkRendererPass>                                                          render_pass_resource;
+    std::vector<VkImageView>                                                               views;
 };
 } // namespace Eng::Gfx
\ No newline at end of file
@@ -35,6 +35,7 @@ enum class ETextureGPUWriteCapabilities
 {
     None,
     Enabled,
+    Storage, // Written by compute shaders
 };
 
 enum class ETextureGPUReadCapabilities
@@ -99,6 +100,25 @@ struct ImageParameter
     bool                         read_only              = true;
 };
 
+// Device memory shared by images that are never used at the same time (see AttachmentAliasing)
+class AliasedMemory : public DeviceResource
+{
+public:
+    static std::shared_ptr<AliasedMemory> create(std::string name, std::weak_ptr<Device> device, const VkMemoryRequirements& requirements)
+    {
+        return std::shared_ptr<AliasedMemory>(new AliasedMemory(std::move(name), std::move(device), requirements));
+    }
+
+    AliasedMemory(AliasedMemory&&) = delete;
+    AliasedMemory(AliasedMemory&)  = delete;
+    ~AliasedMemory();
+
+    std::unique_ptr<VmaAllocationWrap> allocation;
+
+private:
+    AliasedMemory(std::string name, std::weak_ptr<Device> device, const VkMemoryRequirements& requirements);
+};
+
 class Image
 {
     friend class ImageView;
@@ -107,17 +127,20 @@ public:
     class ImageResource : public DeviceResource, public std::enable_shared_from_this<ImageResource>
     {
     public:
-        ImageResource(std::string name, std::weak_ptr<Device> device, ImageParameter params, uint32_t mip_count);
+        // The image is bound to aliased_memory if provided, otherwise it gets its own allocation
+        ImageResource(std::string name, std::weak_ptr<Device> device, ImageParameter params, uint32_t mip_count, std::shared_ptr<AliasedMemory> aliased_memory = nullptr);
         ImageResource(ImageResource&&) = delete;
         ImageResource(ImageResource&)  = delete;
         ~ImageResource();
         void set_data(const std::vector<BufferData>& mips);
         void set_image_layout(const CommandBuffer& command_buffer, VkImageLayout new_layout);
         void generate_mipmaps(uint32_t mipLevels, const CommandBuffer& command_buffer) const;
+        VkMemoryRequirements get_memory_requirements() const;
 
         VkImage                            ptr          = VK_NULL_HANDLE;
         VkImageLayout                      image_layout = VK_IMAGE_LAYOUT_UNDEFINED;
         std::unique_ptr<VmaAllocationWrap> allocation;
+        std::shared_ptr<AliasedMemory>     aliased_memory;
         bool                               outdated      = false;
         uint32_t                           layer_cout    = 0;
         uint32_t                           mip_count     = 0;
@@ -141,6 +164,12 @@ public:
         return std::shared_ptr<Image>(new Image(name, std::move(device), params, desired_mip_count));
     }
 
+    // Image without its own memory : each resource is bound to the aliased memory of the same index
+    static std::shared_ptr<Image> create(const std::string& name, std::weak_ptr<Device> device, const ImageParameter& params, const std::vector<std::shared_ptr<AliasedMemory>>& aliased_memory)
+    {
+        return std::shared_ptr<Image>(new Image(name, std::move(device), params, 1, aliased_memory));
+    }
+
     Image(Image&&) = delete;
     Image(Image&)  = delete;
     ~Image();
@@ -174,7 +203,7 @@ public:
     uint32_t get_mips_count() const;
 
 private:
-    Image(std::string name, std::weak_ptr<Device> device, const ImageParameter& params, uint32_t base_mips);
+    Image(std::string name, std::weak_ptr<Device> device, const ImageParameter& params, uint32_t base_mips, const std::vector<std::shared_ptr<AliasedMemory>>& aliased_memory = {});
     glm::uvec2                                  extent;
     ImageParameter                              params;
     std::weak_ptr<Device>                       device;
@@ -38,6 +38,11 @@ class ImageView
 
     VkImageView              raw_current() const;
     std::vector<VkImageView> raw() const;
+    // Image viewed for the given frame
+    VkImage raw_image(size_t index) const
+    {
+        return views[views.size() == 1 ? 0 : index]->image;
+    }
 
     const VkDescriptorImageInfo& get_descriptor_infos_current() const;
 
@@ -58,7 +63,8 @@ class ImageView
         Resource(std::string name, const std::weak_ptr<Device>& device, const std::shared_ptr<Image::ImageResource>& resource, CreateInfos create_infos);
         Resource(std::string name, const std::weak_ptr<Device>& device, VkImage image, CreateInfos create_infos);
         ~Resource();
-        VkImageView                           ptr = VK_NULL_HANDLE;
+        VkImageView                           ptr   = VK_NULL_HANDLE;
+        VkImage                               image = VK_NULL_HANDLE;
         VkDescriptorImageInfo                 descriptor_infos;
         std::shared_ptr<Image::ImageResource> image_resource;
     };
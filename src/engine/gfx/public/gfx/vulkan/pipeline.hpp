@@ -48,6 +48,8 @@ public:
     {
         PipelineOptions                          options;
         std::vector<StageInputOutputDescription> vertex_inputs;
+        // Inputs read from a second vertex buffer with a per instance rate (binding 1)
+        std::vector<StageInputOutputDescription> instance_inputs;
     };
 
     static std::shared_ptr<Pipeline> create(std::string name, std::weak_ptr<Device> device, const std::weak_ptr<VkRendererPass>& render_pass, const std::vector<std::shared_ptr<ShaderModule>>& shader_stage,
@@ -75,10 +77,17 @@ public:
         return create_infos;
     }
 
+    // True if the vertex shader reads the per instance stream (binding 1)
+    bool uses_instance_stream() const
+    {
+        return b_instance_stream;
+    }
+
 private:
     Pipeline(std::string name, std::weak_ptr<Device> device, const std::weak_ptr<VkRendererPass>& render_pass, const std::vector<std::shared_ptr<ShaderModule>>& shader_stage, CreateInfos create_infos);
     CreateInfos                     create_infos;
     std::shared_ptr<PipelineLayout> layout;
-    VkPipeline                      ptr = VK_NULL_HANDLE;
+    VkPipeline                      ptr               = VK_NULL_HANDLE;
+    bool                            b_instance_stream = false;
 };
 } // namespace Eng::Gfx
\ No newline at end of file
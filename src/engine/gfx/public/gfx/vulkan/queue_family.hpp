@@ -1,6 +1,7 @@
 #pragma once
 #include <mutex>
 #include <shared_mutex>
+#include <span>
 #include <ankerl/unordered_dense.h>
 #include <vulkan/vulkan_core.h>
 
@@ -28,7 +29,7 @@ const char* get_queue_specialization_name(QueueSpecialization elem);
 class QueueFamily
 {
   public:
-    QueueFamily(uint32_t index, VkQueueFlags flags, bool support_present, std::shared_ptr<std::shared_mutex> queue_global_lock);
+    QueueFamily(uint32_t index, VkQueueFlags flags, bool support_present, uint32_t timestamp_valid_bits, std::shared_ptr<std::shared_mutex> queue_global_lock);
     QueueFamily(QueueFamily&)  = delete;
     QueueFamily(QueueFamily&&) = delete;
 
@@ -47,6 +48,12 @@ class QueueFamily
         return queue_index;
     }
 
+    // Significant bits of the timestamps written by this queue (0 if timestamps are not supported)
+    uint32_t timestamp_valid_bits() const
+    {
+        return queue_timestamp_valid_bits;
+    }
+
     void init_queue(const std::weak_ptr<Device>& device);
 
     CommandPool& get_command_pool() const
@@ -56,6 +63,8 @@ class QueueFamily
 
     VkResult present(const VkPresentInfoKHR& present_infos);
     VkResult submit(const CommandBuffer& cmd, VkSubmitInfo submit_infos = {}, const Fence* optional_fence = nullptr);
+    // Submit multiple batches at once (see SubmitBatch)
+    VkResult submit(std::span<const VkSubmitInfo2> submits, const Fence* optional_fence = nullptr);
 
     void set_name(const std::string& in_name)
     {
@@ -68,6 +77,7 @@ class QueueFamily
     uint32_t                           queue_index;
     VkQueueFlags                       queue_flags;
     bool                               queue_support_present;
+    uint32_t                           queue_timestamp_valid_bits;
     std::mutex                         queue_lock;
     VkQueue                            ptr = VK_NULL_HANDLE;
     std::shared_ptr<CommandPool>       command_pool;
@@ -28,4 +28,40 @@ class Semaphore
     VkSemaphore           ptr;
     std::weak_ptr<Device> device;
 };
+
+// Semaphore whose value increases with each submission signaling it : waiting for a given submission does not require one semaphore per frame
+class TimelineSemaphore
+{
+  public:
+    static std::shared_ptr<TimelineSemaphore> create(const std::string& name, std::weak_ptr<Device> device)
+    {
+        return std::shared_ptr<TimelineSemaphore>(new TimelineSemaphore(name, std::move(device)));
+    }
+    TimelineSemaphore(TimelineSemaphore&)  = delete;
+    TimelineSemaphore(TimelineSemaphore&&) = delete;
+    ~TimelineSemaphore();
+
+    VkSemaphore raw() const
+    {
+        return ptr;
+    }
+
+    // Value signaled by the last submission
+    uint64_t get_submitted_value() const
+    {
+        return submitted_value;
+    }
+
+    // Value the next submission should signal
+    uint64_t next_value()
+    {
+        return ++submitted_value;
+    }
+
+  private:
+    TimelineSemaphore(const std::string& name, std::weak_ptr<Device> device);
+    VkSemaphore           ptr;
+    std::weak_ptr<Device> device;
+    uint64_t              submitted_value = 0;
+};
 } // namespace Eng::Gfx
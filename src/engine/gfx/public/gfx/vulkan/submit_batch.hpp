@@ -0,0 +1,58 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "command_pool.hpp"
+
+namespace Eng::Gfx
+{
+class CommandBuffer;
+class Device;
+class Fence;
+class QueueFamily;
+
+/**
+ * Command buffers accumulated during a frame, then submitted with a single vkQueueSubmit2 per queue. They must be added in a valid execution
+ * order (dependencies first) : a queue starts its batches in order, and the timeline semaphores allow waiting for a value signaled by a batch
+ * of another queue that is submitted later.
+ */
+class SubmitBatch
+{
+  public:
+    SubmitBatch(std::weak_ptr<Device> in_device) : device(std::move(in_device))
+    {
+    }
+
+    // The fence is signaled once every command buffer of the queue is done
+    void add(CommandBuffer& cmd, std::span<const VkSemaphoreSubmitInfo> waits, std::span<const VkSemaphoreSubmitInfo> signals, const Fence* fence = nullptr);
+
+    // Submit the command buffers added since the last flush. Return the number of vkQueueSubmit2 calls.
+    uint32_t flush();
+
+  private:
+    struct Submission
+    {
+        CommandBuffer* cmd;
+        uint32_t       first_wait;
+        uint32_t       wait_count;
+        uint32_t       first_signal;
+        uint32_t       signal_count;
+    };
+
+    struct QueueBatch
+    {
+        std::shared_ptr<QueueFamily> queue;
+        std::vector<Submission>      submissions;
+        const Fence*                 fence = nullptr;
+    };
+
+    std::weak_ptr<Device>                  device;
+    std::vector<QueueBatch>                queues;
+    std::vector<VkSemaphoreSubmitInfo>     semaphores;
+    std::vector<VkCommandBufferSubmitInfo> command_buffers;
+    std::vector<VkSubmitInfo2>             submit_infos;
+    std::vector<CommandPool::Mutex*>       locked_pools;
+};
+} // namespace Eng::Gfx
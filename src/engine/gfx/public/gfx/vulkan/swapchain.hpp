@@ -68,7 +68,7 @@ class Swapchain final : public RenderPassInstance
     }
 
 protected:
-    std::vector<VkSemaphore> get_semaphores_to_wait(DeviceImageId swapchain_image) const override;
+    void get_semaphores_to_wait(DeviceImageId swapchain_image, std::vector<VkSemaphoreSubmitInfo>& semaphores) const override;
 
     const Fence* get_render_finished_fence(DeviceImageId device_image) const override
     {
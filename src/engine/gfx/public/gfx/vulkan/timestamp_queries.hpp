@@ -0,0 +1,45 @@
+#pragma once
+#include "device_resource.hpp"
+
+#include <chrono>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace Eng::Gfx
+{
+class CommandBuffer;
+
+/**
+ * Timestamps written by the gpu at the beginning and the end of a command buffer, for each device image. They are read back when the image is
+ * recorded again : its previous frame is finished, so reading never waits for the gpu.
+ */
+class TimestampQueries : public DeviceResource
+{
+public:
+    TimestampQueries(const std::string& name, std::weak_ptr<Device> device, uint8_t image_count);
+    TimestampQueries(TimestampQueries&)  = delete;
+    TimestampQueries(TimestampQueries&&) = delete;
+    ~TimestampQueries() override;
+
+    // Reset the queries of the image, then write the begin timestamp before the next commands
+    void write_begin(const CommandBuffer& cmd, uint8_t image);
+    // Write the end timestamp once the previous commands are done (ignored if the begin timestamp was not written)
+    void write_end(const CommandBuffer& cmd, uint8_t image);
+
+    // Read the timestamps last written for the image, with the cpu time of their recording. Each result is only read once.
+    bool read(uint8_t image, uint64_t& begin, uint64_t& end, std::chrono::steady_clock::time_point& recorded_time);
+
+    // Forget the pending results (they were written while nobody was interested in them)
+    void discard();
+
+private:
+    struct ImageQueries
+    {
+        std::chrono::steady_clock::time_point recorded_time;
+        bool                                  b_written = false;
+    };
+
+    VkQueryPool               ptr = VK_NULL_HANDLE;
+    std::vector<ImageQueries> images;
+};
+} // namespace Eng::Gfx
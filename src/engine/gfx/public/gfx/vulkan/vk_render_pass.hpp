@@ -4,12 +4,14 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 #include <vulkan/vulkan.h>
 
 namespace Eng::Gfx
 {
 class Device;
 
+// Description of the attachments of a pass. The VkRenderPass is only created when the device does not use dynamic rendering.
 class VkRendererPass
 {
   public:
@@ -42,11 +44,24 @@ class VkRendererPass
         return name;
     }
 
+    // Formats of the attachments, for the pipelines and the secondary command buffers of dynamic rendering
+    const std::vector<VkFormat>& get_color_formats() const
+    {
+        return color_formats;
+    }
+
+    VkFormat get_depth_format() const
+    {
+        return depth_format;
+    }
+
   private:
     VkRendererPass(const std::string& name, const std::weak_ptr<Device>& device, RenderPassKey key);
     std::string           name;
     RenderPassKey         key;
     std::weak_ptr<Device> device;
     VkRenderPass          ptr = VK_NULL_HANDLE;
+    std::vector<VkFormat> color_formats;
+    VkFormat              depth_format = VK_FORMAT_UNDEFINED;
 };
 } // namespace Eng::Gfx
\ No newline at end of file
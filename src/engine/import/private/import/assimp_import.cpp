@@ -5,6 +5,7 @@
 #include "assets/material_instance_asset.hpp"
 #include "engine.hpp"
 #include "gfx/vulkan/buffer.hpp"
+#include "occlusion_buffer.hpp"
 #include "profiler.hpp"
 
 #include <assimp/Importer.hpp>
@@ -54,13 +55,30 @@ void AssimpImporter::SceneLoader::decompose_node(aiNode* node, TObjectRef<SceneC
     TObjectRef<SceneComponent> this_component;
     if (node->mNumMeshes > 0)
     {
-        auto new_mesh = Engine::get().asset_registry().create<MeshAsset>(node->mName.C_Str());
+        auto                                      new_mesh = Engine::get().asset_registry().create<MeshAsset>(node->mName.C_Str());
+        std::vector<std::shared_ptr<MeshSection>> occluder_sections;
+        size_t                                    occluder_triangles = 0;
         for (size_t i = 0; i < node->mNumMeshes; ++i)
         {
             auto section = find_or_load_mesh(node->mMeshes[i]);
             if (!section)
                 continue;
             new_mesh->add_section(section->name, section->vertices, *section->indices, section->mat);
+            if (section->b_opaque && !section->vertices.empty())
+            {
+                occluder_triangles += section->indices->get_element_count() / 3;
+                occluder_sections.emplace_back(section);
+            }
+        }
+        // Imported meshes are the static geometry of the scene : the opaque sections of the large and simple ones (walls, floors...) are used as occluders
+        if (!occluder_sections.empty())
+        {
+            Bounds occluder_bounds(occluder_sections.front()->vertices.front().pos, occluder_sections.front()->vertices.front().pos);
+            for (const auto& section : occluder_sections)
+                for (const auto& vertex : section->vertices)
+                    occluder_bounds.add_point(vertex.pos);
+            if (OcclusionBuffer::is_occluder_candidate(occluder_bounds, occluder_triangles))
+                set_occluder(*new_mesh, occluder_sections);
         }
         if (parent)
         {
@@ -87,6 +105,23 @@ void AssimpImporter::SceneLoader::decompose_node(aiNode* node, TObjectRef<SceneC
         decompose_node(node->mChildren[i], this_component, output_scene);
 }
 
+void AssimpImporter::SceneLoader::set_occluder(MeshAsset& mesh, const std::vector<std::shared_ptr<MeshSection>>& sections)
+{
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t>  indices;
+    for (const auto& section : sections)
+    {
+        const uint32_t first_vertex = static_cast<uint32_t>(vertices.size());
+        for (const auto& vertex : section->vertices)
+            vertices.emplace_back(vertex.pos);
+        // Sections with less than 65536 vertices use 16 bits indices
+        for (size_t i = 0; i < section->indices->get_element_count(); ++i)
+            indices.emplace_back(first_vertex + (section->indices->get_stride() == sizeof(uint16_t) ? static_cast<const uint16_t*>(section->indices->data())[i]
+                                                                                                    : static_cast<const uint32_t*>(section->indices->data())[i]));
+    }
+    mesh.set_occluder(std::move(vertices), std::move(indices));
+}
+
 TObjectRef<TextureAsset> AssimpImporter::SceneLoader::find_or_load_texture(const std::string& path)
 {
     if (auto found = textures.find(path); found != textures.end())
@@ -226,6 +261,28 @@ TObjectRef<MaterialInstanceAsset> AssimpImporter::SceneLoader::find_or_load_mate
     return materials.emplace(id, new_mat).first->second;
 }
 
+bool AssimpImporter::SceneLoader::is_opaque_material(int id)
+{
+    const aiMaterial* mat = scene->mMaterials[id];
+
+    // Translucent
+    float opacity = 1;
+    if (mat->Get(AI_MATKEY_OPACITY, opacity) == aiReturn_SUCCESS && opacity < 1)
+        return false;
+    if (mat->GetTextureCount(aiTextureType_OPACITY) > 0)
+        return false;
+
+    // default_mesh discards the texels with a low alpha (the default texture is fully transparent)
+    if (mat->GetTextureCount(aiTextureType_DIFFUSE) > 0)
+    {
+        aiString path;
+        mat->GetTexture(aiTextureType_DIFFUSE, 0, &path);
+        const auto diffuse = find_or_load_texture(path.C_Str());
+        return diffuse && !diffuse->has_transparency();
+    }
+    return true;
+}
+
 TObjectRef<MaterialAsset> AssimpImporter::SceneLoader::find_or_load_material(MaterialType type)
 {
     if (auto found = materials_base.find(type); found != materials_base.end())
@@ -259,6 +316,13 @@ TObjectRef<MaterialAsset> AssimpImporter::SceneLoader::find_or_load_material(Mat
                              StageInputOutputDescription{3, 32, Gfx::ColorFormat::R32G32B32_SFLOAT},
                              StageInputOutputDescription{4, 44, Gfx::ColorFormat::R32G32B32_SFLOAT},
                              StageInputOutputDescription{5, 56, Gfx::ColorFormat::R32G32B32A32_SFLOAT},
+                         },
+                         // Model matrix columns (see SceneView::draw)
+                         std::vector{
+                             StageInputOutputDescription{6, 0, Gfx::ColorFormat::R32G32B32A32_SFLOAT},
+                             StageInputOutputDescription{7, 16, Gfx::ColorFormat::R32G32B32A32_SFLOAT},
+                             StageInputOutputDescription{8, 32, Gfx::ColorFormat::R32G32B32A32_SFLOAT},
+                             StageInputOutputDescription{9, 48, Gfx::ColorFormat::R32G32B32A32_SFLOAT},
                          });
 
     return materials_base.emplace(type, mat).first->second;
@@ -326,7 +390,8 @@ std::shared_ptr<AssimpImporter::SceneLoader::MeshSection> AssimpImporter::SceneL
         }
 
         auto base_buffer = Gfx::BufferData(triangles.data(), 2, triangles.size());
-        auto new_section = std::make_shared<MeshSection>(std::string(mesh->mName.C_Str()) + "_" + std::to_string(id), find_or_load_material_instance(mesh->mMaterialIndex), vertices, base_buffer.copy());
+        auto new_section = std::make_shared<MeshSection>(std::string(mesh->mName.C_Str()) + "_" + std::to_string(id), find_or_load_material_instance(mesh->mMaterialIndex), vertices, base_buffer.copy(),
+                                                         is_opaque_material(mesh->mMaterialIndex));
         meshes.emplace(id, new_section);
         return new_section;
     }
@@ -343,7 +408,7 @@ std::shared_ptr<AssimpImporter::SceneLoader::MeshSection> AssimpImporter::SceneL
             triangles[i * 3 + 2] = face.mIndices[2];
         }
         auto new_section = std::make_shared<MeshSection>(std::string(mesh->mName.C_Str()) + "_" + std::to_string(id), find_or_load_material_instance(mesh->mMaterialIndex), vertices,
-                                                         Gfx::BufferData(triangles.data(), 4, triangles.size()).copy());
+                                                         Gfx::BufferData(triangles.data(), 4, triangles.size()).copy(), is_opaque_material(mesh->mMaterialIndex));
         meshes.emplace(id, new_section);
         return new_section;
     }
@@ -78,7 +78,8 @@ TObjectRef<TextureAsset> ImageImport::load_raw(const std::string& file_name, con
                 .height = image.height,
                 .depth = image.depth,
                 .format = static_cast<Gfx::ColorFormat>(dds::getVulkanFormat(image.format, image.supportsAlpha)),
-                .array_size = image.arraySize
+                .array_size = image.arraySize,
+                .b_transparent = image.supportsAlpha
             });
 
         return text;
@@ -110,11 +111,18 @@ TObjectRef<TextureAsset> ImageImport::load_raw(const std::string& file_name, con
         uint32_t x = FreeImage_GetWidth(converted);
         uint32_t y = FreeImage_GetHeight(converted);
 
+        // Cutout or translucent texels
+        const BYTE* pixels        = FreeImage_GetBits(converted);
+        bool        b_transparent = false;
+        for (size_t i = 0; i < static_cast<size_t>(x) * y && !b_transparent; ++i)
+            b_transparent = pixels[i * 4 + FI_RGBA_ALPHA] != 255;
+
         const auto text = Engine::get().asset_registry().create<TextureAsset>(file_name, std::vector{Gfx::BufferData(FreeImage_GetBits(converted), 1, x * y * 4)},
                                                                               TextureAsset::CreateInfos{
                                                                                   .width = x,
                                                                                   .height = y,
-                                                                                  .format = Gfx::ColorFormat::R8G8B8A8_UNORM
+                                                                                  .format = Gfx::ColorFormat::R8G8B8A8_UNORM,
+                                                                                  .b_transparent = b_transparent
                                                                               });
 
         FreeImage_Unload(converted);
@@ -62,12 +62,15 @@ class AssimpImporter
             TObjectRef<MaterialInstanceAsset> mat;
             std::vector<MeshAsset::Vertex>    vertices;
             std::shared_ptr<Gfx::BufferData>  indices;
+            bool                              b_opaque = true; // Alpha tested and translucent sections do not hide what is behind them
         };
 
         TObjectRef<TextureAsset>          find_or_load_texture(const std::string& path);
         TObjectRef<MaterialInstanceAsset> find_or_load_material_instance(int id);
+        bool                              is_opaque_material(int id);
         TObjectRef<MaterialAsset>         find_or_load_material(MaterialType type);
         std::shared_ptr<MeshSection>      find_or_load_mesh(int id);
+        static void                       set_occluder(MeshAsset& mesh, const std::vector<std::shared_ptr<MeshSection>>& sections);
         TObjectRef<SamplerAsset>          get_sampler();
 
         ankerl::unordered_dense::map<std::string, TObjectRef<TextureAsset>>   textures;
@@ -0,0 +1,95 @@
+#include "attachment_aliasing.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace Eng
+{
+void AttachmentAliasing::build(const RenderGraphSchedule& schedule, std::span<const AliasedAttachment> attachments)
+{
+    const size_t node_count = schedule.node_count();
+    const size_t words      = (node_count + 63) / 64;
+
+    // Nodes each node waits for, directly or not
+    std::vector<uint64_t> reach(node_count * words, 0);
+    std::vector<uint32_t> position(node_count);
+    for (uint32_t i = 0; i < schedule.get_order().size(); ++i)
+    {
+        const uint32_t node = schedule.get_order()[i];
+        position[node]      = i;
+        for (uint32_t wait : schedule.get_waits(node))
+        {
+            for (size_t w = 0; w < words; ++w)
+                reach[node * words + w] |= reach[wait * words + w];
+            reach[node * words + wait / 64] |= 1ull << (wait % 64);
+        }
+    }
+    const auto waits_for = [&](uint32_t node, uint32_t other)
+    {
+        return (reach[node * words + other / 64] >> (other % 64) & 1) != 0;
+    };
+
+    // The last node using an attachment waits every other use of it
+    const auto released_before = [&](const AliasedAttachment& previous, uint32_t node)
+    {
+        if (!waits_for(node, previous.node))
+            return false;
+        for (uint32_t consumer : schedule.get_consumers(previous.node))
+            if (!waits_for(node, consumer))
+                return false;
+        return true;
+    };
+
+    std::vector<uint32_t> sorted(attachments.size());
+    std::iota(sorted.begin(), sorted.end(), 0);
+    std::ranges::stable_sort(sorted,
+                             [&](uint32_t a, uint32_t b)
+                             {
+                                 return position[attachments[a].node] < position[attachments[b].node];
+                             });
+
+    attachment_slots.assign(attachments.size(), UINT32_MAX);
+    slots.clear();
+    std::vector<uint32_t> slot_last;
+    required_size = 0;
+    for (uint32_t index : sorted)
+    {
+        const AliasedAttachment& attachment = attachments[index];
+        required_size += attachment.size;
+
+        // Pick the compatible slot that grows the least, then the smallest one
+        uint32_t best = UINT32_MAX;
+        for (uint32_t slot = 0; slot < slots.size(); ++slot)
+        {
+            if ((slots[slot].memory_type_bits & attachment.memory_type_bits) == 0 || !released_before(attachments[slot_last[slot]], attachment.node))
+                continue;
+            if (best == UINT32_MAX)
+            {
+                best = slot;
+                continue;
+            }
+            const uint64_t growth      = attachment.size > slots[slot].size ? attachment.size - slots[slot].size : 0;
+            const uint64_t best_growth = attachment.size > slots[best].size ? attachment.size - slots[best].size : 0;
+            if (growth < best_growth || (growth == best_growth && slots[slot].size < slots[best].size))
+                best = slot;
+        }
+        if (best == UINT32_MAX)
+        {
+            best = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+            slot_last.emplace_back();
+        }
+
+        AliasingSlot& slot     = slots[best];
+        slot.size              = std::max(slot.size, attachment.size);
+        slot.alignment         = std::max(slot.alignment, attachment.alignment);
+        slot.memory_type_bits &= attachment.memory_type_bits;
+        slot_last[best]         = index;
+        attachment_slots[index] = best;
+    }
+
+    aliased_size = 0;
+    for (const auto& slot : slots)
+        aliased_size += slot.size;
+}
+} // namespace Eng
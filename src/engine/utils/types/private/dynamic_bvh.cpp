@@ -0,0 +1,819 @@
+#include "dynamic_bvh.hpp"
+
+#include "frustum_culling.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace Eng
+{
+static float surface_area(const glm::vec3& min, const glm::vec3& max)
+{
+    const glm::vec3 d = max - min;
+    return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+static bool contains(const glm::vec3& outer_min, const glm::vec3& outer_max, const glm::vec3& inner_min, const glm::vec3& inner_max)
+{
+    return outer_min.x <= inner_min.x && outer_min.y <= inner_min.y && outer_min.z <= inner_min.z && outer_max.x >= inner_max.x && outer_max.y >= inner_max.y && outer_max.z >= inner_max.z;
+}
+
+static bool overlaps(const glm::vec3& a_min, const glm::vec3& a_max, const glm::vec3& b_min, const glm::vec3& b_max)
+{
+    return a_min.x <= b_max.x && a_min.y <= b_max.y && a_min.z <= b_max.z && a_max.x >= b_min.x && a_max.y >= b_min.y && a_max.z >= b_min.z;
+}
+
+static float point_box_distance_squared(const glm::vec3& point, const glm::vec3& min, const glm::vec3& max)
+{
+    float distance = 0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float delta = std::max({min[axis] - point[axis], 0.f, point[axis] - max[axis]});
+        distance += delta * delta;
+    }
+    return distance;
+}
+
+// Distance along the ray to the box, or a negative value if the box is missed
+static float ray_box_distance(const glm::vec3& origin, const glm::vec3& inv_direction, const glm::vec3& min, const glm::vec3& max, float max_distance)
+{
+    float t_min = 0;
+    float t_max = max_distance;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float t1 = (min[axis] - origin[axis]) * inv_direction[axis];
+        float t2 = (max[axis] - origin[axis]) * inv_direction[axis];
+        if (t1 > t2)
+            std::swap(t1, t2);
+        // NaN (0 * inf) means the ray is parallel and on the slab border : keep the previous range
+        if (t1 > t_min)
+            t_min = t1;
+        if (t2 < t_max)
+            t_max = t2;
+        if (t_min > t_max)
+            return -1;
+    }
+    return t_min;
+}
+
+uint32_t DynamicBvh::insert(const Bounds& bounds, uint32_t user_data)
+{
+    uint32_t proxy;
+    if (free_proxies.empty())
+    {
+        proxy = static_cast<uint32_t>(proxy_nodes.size());
+        proxy_nodes.emplace_back(NULL_NODE);
+    }
+    else
+    {
+        proxy = free_proxies.back();
+        free_proxies.pop_back();
+    }
+
+    const uint32_t leaf = allocate_node();
+    Node&          node = nodes[leaf];
+    const auto     fat  = bounds.extent() * margin;
+    node.tight_min      = bounds.min();
+    node.tight_max      = bounds.max();
+    node.min            = bounds.min() - fat;
+    node.max            = bounds.max() + fat;
+    node.user_data      = user_data;
+    node.proxy          = proxy;
+    node.height         = 0;
+    proxy_nodes[proxy]  = leaf;
+    insert_leaf(leaf);
+    ++leaf_count;
+    return proxy;
+}
+
+void DynamicBvh::remove(uint32_t proxy)
+{
+    assert(proxy < proxy_nodes.size() && proxy_nodes[proxy] != NULL_NODE);
+    const uint32_t leaf = proxy_nodes[proxy];
+    remove_leaf(leaf);
+    free_node(leaf);
+    proxy_nodes[proxy] = NULL_NODE;
+    free_proxies.emplace_back(proxy);
+    --leaf_count;
+}
+
+bool DynamicBvh::update(uint32_t proxy, const Bounds& bounds)
+{
+    assert(proxy < proxy_nodes.size() && proxy_nodes[proxy] != NULL_NODE);
+    const uint32_t leaf = proxy_nodes[proxy];
+    Node&          node = nodes[leaf];
+    node.tight_min      = bounds.min();
+    node.tight_max      = bounds.max();
+
+    if (contains(node.min, node.max, bounds.min(), bounds.max()))
+        return false;
+
+    remove_leaf(leaf);
+    const auto fat  = bounds.extent() * margin;
+    nodes[leaf].min = bounds.min() - fat;
+    nodes[leaf].max = bounds.max() + fat;
+    insert_leaf(leaf);
+    return true;
+}
+
+void DynamicBvh::clear()
+{
+    nodes.clear();
+    proxy_nodes.clear();
+    free_proxies.clear();
+    root       = NULL_NODE;
+    free_list  = NULL_NODE;
+    leaf_count = 0;
+}
+
+void DynamicBvh::rebuild()
+{
+    std::vector<Node> leaves;
+    leaves.reserve(leaf_count);
+    for (const auto& node : nodes)
+        if (node.height == 0)
+            leaves.emplace_back(node);
+
+    nodes.clear();
+    free_list = NULL_NODE;
+    root      = NULL_NODE;
+    if (leaves.empty())
+        return;
+    nodes.reserve(leaves.size() * 2 - 1);
+    root = build_recursive(leaves, 0, leaves.size(), NULL_NODE);
+}
+
+uint32_t DynamicBvh::build_recursive(std::vector<Node>& leaves, size_t first, size_t last, uint32_t parent)
+{
+    const uint32_t index = static_cast<uint32_t>(nodes.size());
+    if (last - first == 1)
+    {
+        nodes.emplace_back(leaves[first]).parent = parent;
+        proxy_nodes[leaves[first].proxy]         = index;
+        return index;
+    }
+
+    nodes.emplace_back().parent = parent;
+
+    glm::vec3 centroid_min = (leaves[first].min + leaves[first].max) * 0.5f;
+    glm::vec3 centroid_max = centroid_min;
+    for (size_t i = first + 1; i < last; ++i)
+    {
+        const glm::vec3 centroid = (leaves[i].min + leaves[i].max) * 0.5f;
+        centroid_min             = min(centroid_min, centroid);
+        centroid_max             = max(centroid_max, centroid);
+    }
+    const glm::vec3 centroid_extent = centroid_max - centroid_min;
+    const int       axis            = centroid_extent.x > centroid_extent.y ? (centroid_extent.x > centroid_extent.z ? 0 : 2) : (centroid_extent.y > centroid_extent.z ? 1 : 2);
+
+    size_t middle = first;
+    if (centroid_extent[axis] > 0)
+    {
+        // Binned surface area heuristic along the largest axis
+        constexpr int BIN_COUNT = 16;
+        struct Bin
+        {
+            glm::vec3 min   = glm::vec3(FLT_MAX);
+            glm::vec3 max   = glm::vec3(-FLT_MAX);
+            size_t    count = 0;
+        };
+        Bin         bins[BIN_COUNT];
+        const float bin_scale = BIN_COUNT / centroid_extent[axis];
+        const auto  bin_of    = [&](const Node& leaf)
+        {
+            const int bin = static_cast<int>(((leaf.min[axis] + leaf.max[axis]) * 0.5f - centroid_min[axis]) * bin_scale);
+            return std::min(bin, BIN_COUNT - 1);
+        };
+        for (size_t i = first; i < last; ++i)
+        {
+            Bin& bin = bins[bin_of(leaves[i])];
+            bin.min  = min(bin.min, leaves[i].min);
+            bin.max  = max(bin.max, leaves[i].max);
+            ++bin.count;
+        }
+
+        float right_area[BIN_COUNT];
+        {
+            Bin accumulated;
+            for (int i = BIN_COUNT - 1; i > 0; --i)
+            {
+                accumulated.min = min(accumulated.min, bins[i].min);
+                accumulated.max = max(accumulated.max, bins[i].max);
+                accumulated.count += bins[i].count;
+                right_area[i] = accumulated.count ? surface_area(accumulated.min, accumulated.max) * static_cast<float>(accumulated.count) : 0;
+            }
+        }
+
+        Bin   accumulated;
+        float best_cost  = FLT_MAX;
+        int   best_split = 0;
+        for (int i = 0; i < BIN_COUNT - 1; ++i)
+        {
+            accumulated.min = min(accumulated.min, bins[i].min);
+            accumulated.max = max(accumulated.max, bins[i].max);
+            accumulated.count += bins[i].count;
+            const float cost = (accumulated.count ? surface_area(accumulated.min, accumulated.max) * static_cast<float>(accumulated.count) : 0) + right_area[i + 1];
+            if (cost < best_cost)
+            {
+                best_cost  = cost;
+                best_split = i;
+            }
+        }
+
+        middle = static_cast<size_t>(std::partition(leaves.begin() + first, leaves.begin() + last,
+                                                    [&](const Node& leaf)
+                                                    {
+                                                        return bin_of(leaf) <= best_split;
+                                                    }) -
+                                     leaves.begin());
+    }
+
+    // Every centroid in the same bin : fallback to a median split
+    if (middle == first || middle == last)
+    {
+        middle = (first + last) / 2;
+        std::nth_element(leaves.begin() + first, leaves.begin() + middle, leaves.begin() + last,
+                         [axis](const Node& a, const Node& b)
+                         {
+                             return a.min[axis] + a.max[axis] < b.min[axis] + b.max[axis];
+                         });
+    }
+
+    const uint32_t left  = build_recursive(leaves, first, middle, index);
+    const uint32_t right = build_recursive(leaves, middle, last, index);
+    Node&          node  = nodes[index];
+    node.left            = left;
+    node.right           = right;
+    node.min             = min(nodes[left].min, nodes[right].min);
+    node.max             = max(nodes[left].max, nodes[right].max);
+    node.height          = 1 + std::max(nodes[left].height, nodes[right].height);
+    return index;
+}
+
+void DynamicBvh::query_frustum(const CullingPlanes& planes, std::vector<uint32_t>& out_user_data) const
+{
+    std::vector<uint32_t>* out = &out_user_data;
+    query_frustums({&planes, 1}, {&out, 1});
+}
+
+void DynamicBvh::query_frustums(std::span<const CullingPlanes> views, std::span<std::vector<uint32_t>* const> out_user_data) const
+{
+    assert(views.size() == out_user_data.size());
+    if (views.size() > MAX_QUERY_VIEWS)
+    {
+        query_frustums(views.subspan(0, MAX_QUERY_VIEWS), out_user_data.subspan(0, MAX_QUERY_VIEWS));
+        query_frustums(views.subspan(MAX_QUERY_VIEWS), out_user_data.subspan(MAX_QUERY_VIEWS));
+        return;
+    }
+    if (root == NULL_NODE || views.empty())
+        return;
+
+    const uint32_t view_count = static_cast<uint32_t>(views.size());
+
+    // Leaves still crossing a plane are tested together at the end
+    thread_local CullingBounds         leaf_bounds[MAX_QUERY_VIEWS];
+    thread_local std::vector<uint32_t> leaf_user_data[MAX_QUERY_VIEWS];
+    thread_local std::vector<uint32_t> visible_leaves;
+    for (uint32_t v = 0; v < view_count; ++v)
+    {
+        leaf_bounds[v].clear();
+        leaf_user_data[v].clear();
+    }
+
+    struct StackItem
+    {
+        uint32_t node;
+        uint32_t active_views;                // Views that did not cull this node yet
+        uint8_t  plane_masks[MAX_QUERY_VIEWS]; // Per view planes still crossing this node
+    };
+    thread_local std::vector<StackItem> stack;
+    stack.clear();
+    StackItem& root_item = stack.emplace_back(StackItem{root, (1u << view_count) - 1, {}});
+    for (uint32_t v = 0; v < view_count; ++v)
+        root_item.plane_masks[v] = static_cast<uint8_t>((1u << views[v].count) - 1);
+
+    while (!stack.empty())
+    {
+        StackItem item = stack.back();
+        stack.pop_back();
+        const Node& node = nodes[item.node];
+
+        if (node.is_leaf())
+        {
+            for (uint32_t v = 0; v < view_count; ++v)
+            {
+                if (!(item.active_views & (1u << v)))
+                    continue;
+                if (item.plane_masks[v] == 0)
+                    out_user_data[v]->emplace_back(node.user_data);
+                else
+                {
+                    leaf_bounds[v].push((node.tight_min + node.tight_max) * 0.5f, (node.tight_max - node.tight_min) * 0.5f);
+                    leaf_user_data[v].emplace_back(node.user_data);
+                }
+            }
+            continue;
+        }
+
+        const glm::vec3 center       = (node.min + node.max) * 0.5f;
+        const glm::vec3 half_extent  = (node.max - node.min) * 0.5f;
+        bool            b_all_inside = true;
+        for (uint32_t v = 0; v < view_count; ++v)
+        {
+            if (!(item.active_views & (1u << v)) || item.plane_masks[v] == 0)
+                continue;
+            const CullingPlanes& planes = views[v];
+            for (uint32_t p = 0; p < planes.count; ++p)
+            {
+                if (!(item.plane_masks[v] & (1u << p)))
+                    continue;
+                const glm::vec4& plane    = planes.planes[p];
+                const float      distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+                const float      radius   = std::abs(plane.x) * half_extent.x + std::abs(plane.y) * half_extent.y + std::abs(plane.z) * half_extent.z;
+                if (distance + radius < 0)
+                {
+                    item.active_views &= ~(1u << v);
+                    break;
+                }
+                // Fully on the inner side of this plane : children don't need to test it again
+                if (distance - radius >= 0)
+                    item.plane_masks[v] &= ~(1u << p);
+            }
+            if ((item.active_views & (1u << v)) && item.plane_masks[v] != 0)
+                b_all_inside = false;
+        }
+        if (item.active_views == 0)
+            continue;
+
+        if (b_all_inside)
+        {
+            for (uint32_t v = 0; v < view_count; ++v)
+                if (item.active_views & (1u << v))
+                    collect_leaves(item.node, *out_user_data[v]);
+        }
+        else
+        {
+            item.node = node.left;
+            stack.emplace_back(item);
+            item.node = node.right;
+            stack.emplace_back(item);
+        }
+    }
+
+    for (uint32_t v = 0; v < view_count; ++v)
+    {
+        if (leaf_bounds[v].size() == 0)
+            continue;
+        visible_leaves.clear();
+        Culling::frustum_indices(views[v], leaf_bounds[v], visible_leaves);
+        for (const auto& index : visible_leaves)
+            out_user_data[v]->emplace_back(leaf_user_data[v][index]);
+    }
+}
+
+void DynamicBvh::query_overlap(const Bounds& bounds, std::vector<uint32_t>& out_user_data) const
+{
+    if (root == NULL_NODE)
+        return;
+
+    thread_local std::vector<uint32_t> stack;
+    stack.clear();
+    stack.emplace_back(root);
+    while (!stack.empty())
+    {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+        if (node.is_leaf())
+        {
+            if (overlaps(node.tight_min, node.tight_max, bounds.min(), bounds.max()))
+                out_user_data.emplace_back(node.user_data);
+        }
+        else if (overlaps(node.min, node.max, bounds.min(), bounds.max()))
+        {
+            stack.emplace_back(node.left);
+            stack.emplace_back(node.right);
+        }
+    }
+}
+
+void DynamicBvh::query_sphere(const glm::vec3& center, float radius, std::vector<uint32_t>& out_user_data) const
+{
+    if (root == NULL_NODE)
+        return;
+
+    const float                        radius_squared = radius * radius;
+    thread_local std::vector<uint32_t> stack;
+    stack.clear();
+    stack.emplace_back(root);
+    while (!stack.empty())
+    {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+        if (node.is_leaf())
+        {
+            if (point_box_distance_squared(center, node.tight_min, node.tight_max) <= radius_squared)
+                out_user_data.emplace_back(node.user_data);
+        }
+        else if (point_box_distance_squared(center, node.min, node.max) <= radius_squared)
+        {
+            stack.emplace_back(node.left);
+            stack.emplace_back(node.right);
+        }
+    }
+}
+
+bool DynamicBvh::nearest(const glm::vec3& position, float max_distance, BvhRayHit& out_hit, const std::function<float(uint32_t, float)>& filter) const
+{
+    if (root == NULL_NODE)
+        return false;
+
+    float best_distance_squared = max_distance * max_distance;
+    bool  b_hit                 = false;
+
+    struct StackItem
+    {
+        uint32_t node;
+        float    distance_squared;
+    };
+    thread_local std::vector<StackItem> stack;
+    stack.clear();
+
+    const float root_distance = point_box_distance_squared(position, nodes[root].min, nodes[root].max);
+    if (root_distance > best_distance_squared)
+        return false;
+    stack.emplace_back(StackItem{root, root_distance});
+
+    while (!stack.empty())
+    {
+        const StackItem item = stack.back();
+        stack.pop_back();
+        // A closer leaf was found since this node was pushed
+        if (item.distance_squared > best_distance_squared)
+            continue;
+
+        const Node& node = nodes[item.node];
+        if (node.is_leaf())
+        {
+            const float distance_squared = point_box_distance_squared(position, node.tight_min, node.tight_max);
+            if (distance_squared > best_distance_squared)
+                continue;
+            float distance = std::sqrt(distance_squared);
+            if (filter)
+            {
+                distance = filter(node.user_data, distance);
+                if (distance < 0 || distance * distance > best_distance_squared)
+                    continue;
+            }
+            best_distance_squared = distance * distance;
+            out_hit               = {.user_data = node.user_data, .distance = distance};
+            b_hit                 = true;
+            continue;
+        }
+
+        const float left_distance  = point_box_distance_squared(position, nodes[node.left].min, nodes[node.left].max);
+        const float right_distance = point_box_distance_squared(position, nodes[node.right].min, nodes[node.right].max);
+
+        // Push the farthest child first to visit the closest one first
+        const bool b_left  = left_distance <= best_distance_squared;
+        const bool b_right = right_distance <= best_distance_squared;
+        if (b_left && b_right)
+        {
+            if (left_distance < right_distance)
+            {
+                stack.emplace_back(StackItem{node.right, right_distance});
+                stack.emplace_back(StackItem{node.left, left_distance});
+            }
+            else
+            {
+                stack.emplace_back(StackItem{node.left, left_distance});
+                stack.emplace_back(StackItem{node.right, right_distance});
+            }
+        }
+        else if (b_left)
+            stack.emplace_back(StackItem{node.left, left_distance});
+        else if (b_right)
+            stack.emplace_back(StackItem{node.right, right_distance});
+    }
+    return b_hit;
+}
+
+bool DynamicBvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, BvhRayHit& out_hit, const std::function<float(uint32_t, float)>& filter) const
+{
+    if (root == NULL_NODE)
+        return false;
+
+    const glm::vec3 inv_direction = glm::vec3(1.f) / direction;
+    float           best_distance = max_distance;
+    bool            b_hit         = false;
+
+    struct StackItem
+    {
+        uint32_t node;
+        float    distance;
+    };
+    thread_local std::vector<StackItem> stack;
+    stack.clear();
+
+    const float root_distance = ray_box_distance(origin, inv_direction, nodes[root].min, nodes[root].max, best_distance);
+    if (root_distance < 0)
+        return false;
+    stack.emplace_back(StackItem{root, root_distance});
+
+    while (!stack.empty())
+    {
+        const StackItem item = stack.back();
+        stack.pop_back();
+        // A closer hit was found since this node was pushed
+        if (item.distance > best_distance)
+            continue;
+
+        const Node& node = nodes[item.node];
+        if (node.is_leaf())
+        {
+            float distance = ray_box_distance(origin, inv_direction, node.tight_min, node.tight_max, best_distance);
+            if (distance < 0)
+                continue;
+            if (filter)
+            {
+                distance = filter(node.user_data, distance);
+                if (distance < 0 || distance > best_distance)
+                    continue;
+            }
+            best_distance = distance;
+            out_hit       = {.user_data = node.user_data, .distance = distance};
+            b_hit         = true;
+            continue;
+        }
+
+        const float left_distance  = ray_box_distance(origin, inv_direction, nodes[node.left].min, nodes[node.left].max, best_distance);
+        const float right_distance = ray_box_distance(origin, inv_direction, nodes[node.right].min, nodes[node.right].max, best_distance);
+
+        // Push the farthest child first to visit the closest one first
+        if (left_distance >= 0 && right_distance >= 0)
+        {
+            if (left_distance < right_distance)
+            {
+                stack.emplace_back(StackItem{node.right, right_distance});
+                stack.emplace_back(StackItem{node.left, left_distance});
+            }
+            else
+            {
+                stack.emplace_back(StackItem{node.left, left_distance});
+                stack.emplace_back(StackItem{node.right, right_distance});
+            }
+        }
+        else if (left_distance >= 0)
+            stack.emplace_back(StackItem{node.left, left_distance});
+        else if (right_distance >= 0)
+            stack.emplace_back(StackItem{node.right, right_distance});
+    }
+    return b_hit;
+}
+
+bool DynamicBvh::validate() const
+{
+    if (root == NULL_NODE)
+        return leaf_count == 0;
+    size_t free_count = 0;
+    for (uint32_t node = free_list; node != NULL_NODE; node = nodes[node].parent)
+        ++free_count;
+    size_t used_count = 0;
+    size_t leaves     = 0;
+    for (const auto& node : nodes)
+    {
+        if (node.height >= 0)
+            ++used_count;
+        if (node.height == 0)
+            ++leaves;
+    }
+    for (uint32_t proxy = 0; proxy < proxy_nodes.size(); ++proxy)
+        if (proxy_nodes[proxy] != NULL_NODE && (nodes[proxy_nodes[proxy]].height != 0 || nodes[proxy_nodes[proxy]].proxy != proxy))
+            return false;
+    return nodes[root].parent == NULL_NODE && free_count + used_count == nodes.size() && leaves == leaf_count && proxy_nodes.size() - free_proxies.size() == leaf_count && validate_node(root, NULL_NODE);
+}
+
+uint32_t DynamicBvh::allocate_node()
+{
+    if (free_list == NULL_NODE)
+    {
+        nodes.emplace_back();
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+    const uint32_t node = free_list;
+    free_list           = nodes[node].parent;
+    nodes[node]         = Node{};
+    return node;
+}
+
+void DynamicBvh::free_node(uint32_t node)
+{
+    nodes[node].parent = free_list;
+    nodes[node].height = -1;
+    free_list          = node;
+}
+
+void DynamicBvh::insert_leaf(uint32_t leaf)
+{
+    if (root == NULL_NODE)
+    {
+        root               = leaf;
+        nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // Find the best sibling using the surface area heuristic
+    const glm::vec3 leaf_min = nodes[leaf].min;
+    const glm::vec3 leaf_max = nodes[leaf].max;
+    uint32_t        index    = root;
+    while (!nodes[index].is_leaf())
+    {
+        const Node& node          = nodes[index];
+        const float area          = surface_area(node.min, node.max);
+        const float combined_area = surface_area(min(node.min, leaf_min), max(node.max, leaf_max));
+        const float cost          = 2.f * combined_area;
+        const float inherit_cost  = 2.f * (combined_area - area);
+        const auto  child_cost    = [&](uint32_t child)
+        {
+            const Node& c          = nodes[child];
+            const float child_area = surface_area(min(c.min, leaf_min), max(c.max, leaf_max));
+            return c.is_leaf() ? child_area + inherit_cost : child_area - surface_area(c.min, c.max) + inherit_cost;
+        };
+        const float cost_left  = child_cost(node.left);
+        const float cost_right = child_cost(node.right);
+
+        if (cost < cost_left && cost < cost_right)
+            break;
+        index = cost_left < cost_right ? node.left : node.right;
+    }
+
+    const uint32_t sibling    = index;
+    const uint32_t old_parent = nodes[sibling].parent;
+    const uint32_t new_parent = allocate_node();
+    // nodes may have been reallocated
+    Node& parent_node  = nodes[new_parent];
+    parent_node.parent = old_parent;
+    parent_node.min    = min(nodes[sibling].min, leaf_min);
+    parent_node.max    = max(nodes[sibling].max, leaf_max);
+    parent_node.height = nodes[sibling].height + 1;
+    parent_node.left   = sibling;
+    parent_node.right  = leaf;
+
+    if (old_parent != NULL_NODE)
+    {
+        if (nodes[old_parent].left == sibling)
+            nodes[old_parent].left = new_parent;
+        else
+            nodes[old_parent].right = new_parent;
+    }
+    else
+        root = new_parent;
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent    = new_parent;
+
+    refit_ancestors(new_parent);
+}
+
+void DynamicBvh::remove_leaf(uint32_t leaf)
+{
+    if (leaf == root)
+    {
+        root = NULL_NODE;
+        return;
+    }
+
+    const uint32_t parent       = nodes[leaf].parent;
+    const uint32_t grand_parent = nodes[parent].parent;
+    const uint32_t sibling      = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+    if (grand_parent != NULL_NODE)
+    {
+        if (nodes[grand_parent].left == parent)
+            nodes[grand_parent].left = sibling;
+        else
+            nodes[grand_parent].right = sibling;
+        nodes[sibling].parent = grand_parent;
+        free_node(parent);
+        refit_ancestors(grand_parent);
+    }
+    else
+    {
+        root                  = sibling;
+        nodes[sibling].parent = NULL_NODE;
+        free_node(parent);
+    }
+}
+
+void DynamicBvh::refit_ancestors(uint32_t node)
+{
+    while (node != NULL_NODE)
+    {
+        node = balance(node);
+
+        Node&       current = nodes[node];
+        const Node& left    = nodes[current.left];
+        const Node& right   = nodes[current.right];
+        current.height      = 1 + std::max(left.height, right.height);
+        current.min         = min(left.min, right.min);
+        current.max         = max(left.max, right.max);
+
+        node = current.parent;
+    }
+}
+
+// Rotate the node if its children heights differ by more than one. Returns the new root of this subtree.
+uint32_t DynamicBvh::balance(uint32_t a)
+{
+    Node& node_a = nodes[a];
+    if (node_a.is_leaf() || node_a.height < 2)
+        return a;
+
+    const uint32_t b       = node_a.left;
+    const uint32_t c       = node_a.right;
+    const int32_t  balance = nodes[c].height - nodes[b].height;
+
+    const auto rotate = [&](uint32_t low, uint32_t high, bool b_high_is_right) -> uint32_t
+    {
+        // Promote "high" above "a"
+        Node&          node_high = nodes[high];
+        const uint32_t f         = node_high.left;
+        const uint32_t g         = node_high.right;
+
+        node_high.left   = a;
+        node_high.parent = node_a.parent;
+        node_a.parent    = high;
+
+        if (node_high.parent != NULL_NODE)
+        {
+            if (nodes[node_high.parent].left == a)
+                nodes[node_high.parent].left = high;
+            else
+                nodes[node_high.parent].right = high;
+        }
+        else
+            root = high;
+
+        const bool     b_keep_f = nodes[f].height > nodes[g].height;
+        const uint32_t kept     = b_keep_f ? f : g;
+        const uint32_t moved    = b_keep_f ? g : f;
+
+        node_high.right = kept;
+        if (b_high_is_right)
+            node_a.right = moved;
+        else
+            node_a.left = moved;
+        nodes[moved].parent = a;
+
+        node_a.min       = min(nodes[low].min, nodes[moved].min);
+        node_a.max       = max(nodes[low].max, nodes[moved].max);
+        node_a.height    = 1 + std::max(nodes[low].height, nodes[moved].height);
+        node_high.min    = min(node_a.min, nodes[kept].min);
+        node_high.max    = max(node_a.max, nodes[kept].max);
+        node_high.height = 1 + std::max(node_a.height, nodes[kept].height);
+        return high;
+    };
+
+    if (balance > 1)
+        return rotate(b, c, true);
+    if (balance < -1)
+        return rotate(c, b, false);
+    return a;
+}
+
+void DynamicBvh::collect_leaves(uint32_t node, std::vector<uint32_t>& out_user_data) const
+{
+    thread_local std::vector<uint32_t> stack;
+    stack.clear();
+    stack.emplace_back(node);
+    while (!stack.empty())
+    {
+        const Node& current = nodes[stack.back()];
+        stack.pop_back();
+        if (current.is_leaf())
+            out_user_data.emplace_back(current.user_data);
+        else
+        {
+            stack.emplace_back(current.left);
+            stack.emplace_back(current.right);
+        }
+    }
+}
+
+bool DynamicBvh::validate_node(uint32_t index, uint32_t parent) const
+{
+    const Node& node = nodes[index];
+    if (node.parent != parent)
+        return false;
+    if (node.is_leaf())
+        return node.height == 0 && node.right == NULL_NODE && contains(node.min, node.max, node.tight_min, node.tight_max);
+
+    const Node& left  = nodes[node.left];
+    const Node& right = nodes[node.right];
+    if (node.height != 1 + std::max(left.height, right.height))
+        return false;
+    if (!contains(node.min, node.max, left.min, left.max) || !contains(node.min, node.max, right.min, right.max))
+        return false;
+    return validate_node(node.left, index) && validate_node(node.right, index);
+}
+} // namespace Eng
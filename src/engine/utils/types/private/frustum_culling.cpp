@@ -0,0 +1,311 @@
+#include "frustum_culling.hpp"
+
+#include "simplemacros.hpp"
+
+#include <bit>
+#include <cassert>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CULLING_X64 1
+#include <immintrin.h>
+#if CXX_MSVC
+#include <intrin.h>
+#define CULLING_TARGET_SSE4
+#define CULLING_TARGET_AVX2
+#else
+#define CULLING_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define CULLING_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace Eng
+{
+CullingPlanes CullingPlanes::from_view_proj(const glm::mat4& view_proj, bool b_far_plane)
+{
+    const glm::mat4 t = transpose(view_proj);
+    CullingPlanes   result;
+    result.add_plane(t[3] + t[0]); // Left
+    result.add_plane(t[3] - t[0]); // Right
+    result.add_plane(t[3] + t[1]); // Bottom
+    result.add_plane(t[3] - t[1]); // Top
+    result.add_plane(t[3] + t[2]); // Near
+    if (b_far_plane)
+        result.add_plane(t[3] - t[2]);
+    return result;
+}
+
+bool CullingPlanes::test(const glm::vec3& center, const glm::vec3& half_extent) const
+{
+    for (uint32_t p = 0; p < count; ++p)
+    {
+        const glm::vec4& plane = planes[p];
+        // Same operation order than the SIMD kernels to get bit-exact results
+        float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        float radius   = std::abs(plane.x) * half_extent.x + std::abs(plane.y) * half_extent.y + std::abs(plane.z) * half_extent.z;
+        if (!(distance + radius >= 0.f))
+            return false;
+    }
+    return true;
+}
+
+void CullingBounds::reserve(size_t box_count)
+{
+    const size_t padded = (box_count + PADDING - 1) / PADDING * PADDING;
+    center_x.reserve(padded);
+    center_y.reserve(padded);
+    center_z.reserve(padded);
+    half_extent_x.reserve(padded);
+    half_extent_y.reserve(padded);
+    half_extent_z.reserve(padded);
+}
+
+void CullingBounds::clear()
+{
+    count = 0;
+    center_x.clear();
+    center_y.clear();
+    center_z.clear();
+    half_extent_x.clear();
+    half_extent_y.clear();
+    half_extent_z.clear();
+}
+
+size_t CullingBounds::push(const Bounds& bounds)
+{
+    return push(bounds.center(), bounds.extent() * 0.5f);
+}
+
+size_t CullingBounds::push(const glm::vec3& center, const glm::vec3& half_extent)
+{
+    const size_t index = count;
+    if (count + 1 > padded_size())
+        resize_padded(count + 1);
+    ++count;
+    set(index, center, half_extent);
+    return index;
+}
+
+void CullingBounds::set(size_t index, const glm::vec3& center, const glm::vec3& half_extent)
+{
+    assert(index < count);
+    center_x[index]      = center.x;
+    center_y[index]      = center.y;
+    center_z[index]      = center.z;
+    half_extent_x[index] = half_extent.x;
+    half_extent_y[index] = half_extent.y;
+    half_extent_z[index] = half_extent.z;
+}
+
+void CullingBounds::resize_padded(size_t box_count)
+{
+    const size_t padded = (box_count + PADDING - 1) / PADDING * PADDING;
+    center_x.resize(padded, 0.f);
+    center_y.resize(padded, 0.f);
+    center_z.resize(padded, 0.f);
+    half_extent_x.resize(padded, 0.f);
+    half_extent_y.resize(padded, 0.f);
+    half_extent_z.resize(padded, 0.f);
+}
+
+namespace Culling
+{
+static ECullingSimd detect_simd_level()
+{
+#if CULLING_X64
+#if CXX_MSVC
+    int info[4];
+    __cpuid(info, 0);
+    const int max_leaf = info[0];
+    __cpuid(info, 1);
+    const bool sse41   = (info[2] & (1 << 19)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx     = (info[2] & (1 << 28)) != 0;
+    bool       avx2    = false;
+    if (max_leaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    const bool sse41 = __builtin_cpu_supports("sse4.1");
+    const bool avx2  = __builtin_cpu_supports("avx2");
+#endif
+    if (avx2)
+        return ECullingSimd::Avx2;
+    if (sse41)
+        return ECullingSimd::Sse4;
+#endif
+    return ECullingSimd::Scalar;
+}
+
+ECullingSimd best_simd_level()
+{
+    static const ECullingSimd level = detect_simd_level();
+    return level;
+}
+
+// Test boxes [first, first + count) and return their visibility bits (count <= 64)
+static uint64_t cull_word_scalar(const CullingPlanes& planes, const CullingBounds& bounds, size_t first, size_t count)
+{
+    uint64_t word = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const size_t b = first + i;
+        if (planes.test({bounds.center_x[b], bounds.center_y[b], bounds.center_z[b]}, {bounds.half_extent_x[b], bounds.half_extent_y[b], bounds.half_extent_z[b]}))
+            word |= 1ull << i;
+    }
+    return word;
+}
+
+#if CULLING_X64
+CULLING_TARGET_SSE4 static uint64_t cull_word_sse4(const CullingPlanes& planes, const CullingBounds& bounds, size_t first, size_t count)
+{
+    const __m128 sign_mask = _mm_set1_ps(-0.f);
+    const __m128 zero      = _mm_setzero_ps();
+
+    uint64_t word = 0;
+    // Boxes are padded to a multiple of 8, so we can always process full groups of 4
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const size_t b  = first + i;
+        const __m128 cx = _mm_loadu_ps(&bounds.center_x[b]);
+        const __m128 cy = _mm_loadu_ps(&bounds.center_y[b]);
+        const __m128 cz = _mm_loadu_ps(&bounds.center_z[b]);
+        const __m128 ex = _mm_loadu_ps(&bounds.half_extent_x[b]);
+        const __m128 ey = _mm_loadu_ps(&bounds.half_extent_y[b]);
+        const __m128 ez = _mm_loadu_ps(&bounds.half_extent_z[b]);
+
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (uint32_t p = 0; p < planes.count; ++p)
+        {
+            const glm::vec4& plane = planes.planes[p];
+            const __m128     nx    = _mm_set1_ps(plane.x);
+            const __m128     ny    = _mm_set1_ps(plane.y);
+            const __m128     nz    = _mm_set1_ps(plane.z);
+            const __m128     ax    = _mm_andnot_ps(sign_mask, nx);
+            const __m128     ay    = _mm_andnot_ps(sign_mask, ny);
+            const __m128     az    = _mm_andnot_ps(sign_mask, nz);
+
+            const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_mul_ps(nz, cz)), _mm_set1_ps(plane.w));
+            const __m128 radius   = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, ex), _mm_mul_ps(ay, ey)), _mm_mul_ps(az, ez));
+            visible               = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+
+            // Every box of this group is already outside
+            if (_mm_testz_si128(_mm_castps_si128(visible), _mm_castps_si128(visible)))
+                break;
+        }
+        word |= static_cast<uint64_t>(_mm_movemask_ps(visible)) << i;
+    }
+    return word;
+}
+
+CULLING_TARGET_AVX2 static uint64_t cull_word_avx2(const CullingPlanes& planes, const CullingBounds& bounds, size_t first, size_t count)
+{
+    const __m256 sign_mask = _mm256_set1_ps(-0.f);
+    const __m256 zero      = _mm256_setzero_ps();
+
+    uint64_t word = 0;
+    for (size_t i = 0; i < count; i += 8)
+    {
+        const size_t b  = first + i;
+        const __m256 cx = _mm256_loadu_ps(&bounds.center_x[b]);
+        const __m256 cy = _mm256_loadu_ps(&bounds.center_y[b]);
+        const __m256 cz = _mm256_loadu_ps(&bounds.center_z[b]);
+        const __m256 ex = _mm256_loadu_ps(&bounds.half_extent_x[b]);
+        const __m256 ey = _mm256_loadu_ps(&bounds.half_extent_y[b]);
+        const __m256 ez = _mm256_loadu_ps(&bounds.half_extent_z[b]);
+
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (uint32_t p = 0; p < planes.count; ++p)
+        {
+            const glm::vec4& plane = planes.planes[p];
+            const __m256     nx    = _mm256_set1_ps(plane.x);
+            const __m256     ny    = _mm256_set1_ps(plane.y);
+            const __m256     nz    = _mm256_set1_ps(plane.z);
+            const __m256     ax    = _mm256_andnot_ps(sign_mask, nx);
+            const __m256     ay    = _mm256_andnot_ps(sign_mask, ny);
+            const __m256     az    = _mm256_andnot_ps(sign_mask, nz);
+
+            // No FMA here : results have to stay bit-exact with the scalar reference
+            const __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)), _mm256_mul_ps(nz, cz)), _mm256_set1_ps(plane.w));
+            const __m256 radius   = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, ex), _mm256_mul_ps(ay, ey)), _mm256_mul_ps(az, ez));
+            visible               = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_GE_OQ));
+
+            if (_mm256_testz_ps(visible, visible))
+                break;
+        }
+        word |= static_cast<uint64_t>(_mm256_movemask_ps(visible)) << i;
+    }
+    return word;
+}
+#endif
+
+static void cull_words(const CullingPlanes& planes, const CullingBounds& bounds, size_t first_word, std::span<uint64_t> out_words, ECullingSimd simd)
+{
+    for (size_t w = 0; w < out_words.size(); ++w)
+    {
+        const size_t first     = (first_word + w) * 64;
+        const size_t remaining = bounds.size() - first;
+        const size_t count     = remaining < 64 ? remaining : 64;
+
+        uint64_t word;
+        switch (simd)
+        {
+#if CULLING_X64
+        case ECullingSimd::Avx2:
+            word = cull_word_avx2(planes, bounds, first, count);
+            break;
+        case ECullingSimd::Sse4:
+            word = cull_word_sse4(planes, bounds, first, count);
+            break;
+#endif
+        default:
+            word = cull_word_scalar(planes, bounds, first, count);
+            break;
+        }
+
+        // Discard padding boxes
+        if (count < 64)
+            word &= (1ull << count) - 1;
+        out_words[w] = word;
+    }
+}
+
+void frustum_mask(const CullingPlanes& planes, const CullingBounds& bounds, std::span<uint64_t> out_mask, ECullingSimd simd)
+{
+    const size_t word_count = mask_word_count(bounds.size());
+    assert(out_mask.size() >= word_count);
+    cull_words(planes, bounds, 0, out_mask.subspan(0, word_count), simd > best_simd_level() ? best_simd_level() : simd);
+}
+
+size_t frustum_indices(const CullingPlanes& planes, const CullingBounds& bounds, std::vector<uint32_t>& out_indices, ECullingSimd simd)
+{
+    if (simd > best_simd_level())
+        simd = best_simd_level();
+
+    // Work on small batches to keep the mask on the stack
+    constexpr size_t BATCH_WORDS = 16;
+    uint64_t         mask[BATCH_WORDS];
+
+    const size_t base_size  = out_indices.size();
+    const size_t word_count = mask_word_count(bounds.size());
+    for (size_t batch = 0; batch < word_count; batch += BATCH_WORDS)
+    {
+        const size_t words = word_count - batch < BATCH_WORDS ? word_count - batch : BATCH_WORDS;
+        cull_words(planes, bounds, batch, std::span(mask, words), simd);
+        for (size_t w = 0; w < words; ++w)
+        {
+            uint64_t word = mask[w];
+            while (word)
+            {
+                out_indices.emplace_back(static_cast<uint32_t>((batch + w) * 64 + std::countr_zero(word)));
+                word &= word - 1;
+            }
+        }
+    }
+    return out_indices.size() - base_size;
+}
+} // namespace Culling
+} // namespace Eng
@@ -0,0 +1,38 @@
+#include "gpu_clock.hpp"
+
+#include <cmath>
+
+namespace Eng
+{
+GpuClock::GpuClock(double in_tick_period, uint32_t valid_bits) : tick_period(in_tick_period), mask(valid_bits >= 64 ? UINT64_MAX : (1ull << valid_bits) - 1)
+{
+}
+
+void GpuClock::calibrate(uint64_t ticks, std::chrono::steady_clock::time_point time)
+{
+    reference_ticks = ticks & mask;
+    reference_time  = time;
+    b_has_reference = true;
+    b_calibrated    = true;
+}
+
+void GpuClock::align_after(uint64_t ticks, std::chrono::steady_clock::time_point time)
+{
+    if (b_calibrated)
+        return;
+    if (b_has_reference && to_cpu_time(ticks) >= time)
+        return;
+    reference_ticks = ticks & mask;
+    reference_time  = time;
+    b_has_reference = true;
+}
+
+std::chrono::steady_clock::time_point GpuClock::to_cpu_time(uint64_t ticks) const
+{
+    // Difference with the reference in the range of the valid bits, either before or after it
+    int64_t delta = static_cast<int64_t>((ticks - reference_ticks) & mask);
+    if (mask != UINT64_MAX && static_cast<uint64_t>(delta) > mask / 2)
+        delta -= static_cast<int64_t>(mask) + 1;
+    return reference_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(std::llround(static_cast<double>(delta) * tick_period)));
+}
+} // namespace Eng
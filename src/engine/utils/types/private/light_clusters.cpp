@@ -0,0 +1,122 @@
+#include "light_clusters.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <glm/geometric.hpp>
+
+namespace Eng
+{
+LightClusters::LightClusters(uint32_t in_tiles_x, uint32_t in_tiles_y, uint32_t in_slices) : tiles_x(std::max(1u, in_tiles_x)), tiles_y(std::max(1u, in_tiles_y)), slices(std::max(1u, in_slices))
+{
+    slice_clusters.resize(slices);
+    for (auto& clusters : slice_clusters)
+        clusters.resize(tiles_x * tiles_y);
+}
+
+void LightClusters::begin(const LightClusterView& in_view, std::span<const ClusterLight> in_lights)
+{
+    assert(in_view.z_near > 0 && in_view.z_far > in_view.z_near);
+    view   = in_view;
+    lights = in_lights;
+}
+
+float LightClusters::get_slice_start(uint32_t slice) const
+{
+    if (slice == 0)
+        return 0;
+    return view.z_near * std::pow(view.z_far / view.z_near, static_cast<float>(slice) / static_cast<float>(slices));
+}
+
+void LightClusters::assign_slice(uint32_t slice)
+{
+    auto& clusters = slice_clusters[slice];
+    for (auto& cluster : clusters)
+        cluster.clear();
+
+    const float min_z = get_slice_start(slice);
+    const float max_z = slice + 1 < slices ? get_slice_start(slice + 1) : FLT_MAX;
+
+    // View space bounds of the columns and rows of this slice (the tiles widen with the depth)
+    thread_local std::vector<float> column_bounds, row_bounds;
+    const auto                      compute_bounds = [&](std::vector<float>& bounds, uint32_t tiles, float tan_half)
+    {
+        bounds.resize(tiles + 1);
+        for (uint32_t i = 0; i <= tiles; ++i)
+            bounds[i] = (2.f * static_cast<float>(i) / static_cast<float>(tiles) - 1.f) * tan_half;
+    };
+    compute_bounds(column_bounds, tiles_x, view.tan_half_width);
+    compute_bounds(row_bounds, tiles_y, view.tan_half_height);
+
+    // Squared distance from the light to each column and row of the slice
+    thread_local std::vector<float> column_distances, row_distances;
+    const auto                      compute_distances = [&](std::vector<float>& distances, const std::vector<float>& bounds, uint32_t tiles, float position)
+    {
+        distances.resize(tiles);
+        for (uint32_t i = 0; i < tiles; ++i)
+        {
+            const float low      = std::min(bounds[i] * min_z, bounds[i] * max_z);
+            const float high     = std::max(bounds[i + 1] * min_z, bounds[i + 1] * max_z);
+            const float distance = std::max({low - position, 0.f, position - high});
+            distances[i]         = distance * distance;
+        }
+    };
+
+    for (uint32_t light_index = 0; light_index < lights.size(); ++light_index)
+    {
+        const ClusterLight& light          = lights[light_index];
+        const glm::vec3     relative       = light.position - view.position;
+        const float         z              = glm::dot(relative, view.forward);
+        const float         dz             = std::max({min_z - z, 0.f, z - max_z});
+        const float         radius_squared = light.radius * light.radius;
+        if (dz * dz > radius_squared)
+            continue;
+
+        compute_distances(column_distances, column_bounds, tiles_x, glm::dot(relative, view.right));
+        compute_distances(row_distances, row_bounds, tiles_y, glm::dot(relative, view.up));
+        for (uint32_t y = 0; y < tiles_y; ++y)
+        {
+            const float row_distance = dz * dz + row_distances[y];
+            if (row_distance > radius_squared)
+                continue;
+            for (uint32_t x = 0; x < tiles_x; ++x)
+                if (row_distance + column_distances[x] <= radius_squared)
+                    clusters[y * tiles_x + x].emplace_back(light_index);
+        }
+    }
+}
+
+void LightClusters::assign()
+{
+    for (uint32_t slice = 0; slice < slices; ++slice)
+        assign_slice(slice);
+}
+
+void LightClusters::finalize()
+{
+    ranges.resize(cluster_count());
+    light_indices.clear();
+    for (uint32_t slice = 0; slice < slices; ++slice)
+        for (uint32_t tile = 0; tile < tiles_x * tiles_y; ++tile)
+        {
+            const auto& cluster_lights                 = slice_clusters[slice][tile];
+            ranges[slice * tiles_x * tiles_y + tile] = {static_cast<uint32_t>(light_indices.size()), static_cast<uint32_t>(cluster_lights.size())};
+            light_indices.insert(light_indices.end(), cluster_lights.begin(), cluster_lights.end());
+        }
+    lights = {};
+}
+
+uint32_t LightClusters::find_cluster(const glm::vec3& world_position) const
+{
+    const glm::vec3 relative = world_position - view.position;
+    const float     z        = std::max(glm::dot(relative, view.forward), FLT_MIN);
+
+    const float slice = std::floor(std::log(z / view.z_near) / std::log(view.z_far / view.z_near) * static_cast<float>(slices));
+    const float x     = std::floor((glm::dot(relative, view.right) / (z * view.tan_half_width) * 0.5f + 0.5f) * static_cast<float>(tiles_x));
+    const float y     = std::floor((glm::dot(relative, view.up) / (z * view.tan_half_height) * 0.5f + 0.5f) * static_cast<float>(tiles_y));
+
+    return get_cluster_index(static_cast<uint32_t>(std::clamp(x, 0.f, static_cast<float>(tiles_x - 1))), static_cast<uint32_t>(std::clamp(y, 0.f, static_cast<float>(tiles_y - 1))),
+                             static_cast<uint32_t>(std::clamp(slice, 0.f, static_cast<float>(slices - 1))));
+}
+} // namespace Eng
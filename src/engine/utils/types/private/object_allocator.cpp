@@ -156,6 +156,42 @@ void ContiguousObjectAllocator::free(const Reflection::Class* component_class, v
         LOG_FATAL("No object {} was allocated using this allocator", component_class->name())
 }
 
+bool ContiguousObjectAllocator::release(ObjectAllocation* allocation)
+{
+    if (!b_deferred_release)
+        return false;
+    std::lock_guard lk(released_mtx);
+    released.emplace_back(allocation);
+    return true;
+}
+
+size_t ContiguousObjectAllocator::flush_released()
+{
+    size_t destroyed = 0;
+    while (true)
+    {
+        std::vector<ObjectAllocation*> objects;
+        {
+            std::lock_guard lk(released_mtx);
+            objects.swap(released);
+        }
+        if (objects.empty())
+            return destroyed;
+
+        for (ObjectAllocation* allocation : objects)
+        {
+            // Same as dropping the last TObjectPtr : the allocation is deleted if no TObjectRef uses it anymore
+            IObject object;
+            object.allocation = allocation;
+            object.destroy();
+            if (--allocation->ptr_count == 0 && allocation->ref_count == 0)
+                object.free();
+            object.allocation = nullptr;
+            ++destroyed;
+        }
+    }
+}
+
 void ContiguousObjectAllocator::merge_with(ContiguousObjectAllocator& other)
 {
     for (const auto& pool : other.pools)
@@ -17,4 +17,8 @@ void IObject::destroy()
         if (allocation->ptr_count == 0 && allocation->ref_count == 0)
             free();
     }
-}
\ No newline at end of file
+}
+bool IObject::release_to_allocator() const
+{
+    return allocation->allocator && allocation->object_class && allocation->allocator->release(allocation);
+}
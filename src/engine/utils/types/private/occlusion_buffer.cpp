@@ -0,0 +1,294 @@
+#include "occlusion_buffer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__)
+// SSE2 is always available on x64
+#define OCCLUSION_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace Eng
+{
+void OcclusionBuffer::begin(const glm::mat4& view_proj, const glm::uvec2& in_resolution, bool b_reversed_z)
+{
+    view_projection = view_proj;
+    resolution      = {(in_resolution.x + 3) / 4 * 4, in_resolution.y};
+    b_reversed      = b_reversed_z;
+    depth.assign(static_cast<size_t>(resolution.x) * resolution.y, 1.f);
+    polygons.clear();
+    bands.resize(band_count());
+    for (auto& band : bands)
+        band.clear();
+}
+
+bool OcclusionBuffer::project(const glm::vec3& world_position, glm::vec3& out_pixel) const
+{
+    const glm::vec4 clip = view_projection * glm::vec4(world_position, 1);
+    if (clip.w <= 0)
+        return false;
+    const float z = clip.z / clip.w;
+    if (z < 0 || z > 1)
+        return false;
+    out_pixel.x = (clip.x / clip.w * 0.5f + 0.5f) * static_cast<float>(resolution.x);
+    out_pixel.y = (clip.y / clip.w * 0.5f + 0.5f) * static_cast<float>(resolution.y);
+    out_pixel.z = b_reversed ? 1.f - z : z;
+    return true;
+}
+
+// Twice the signed area of the triangle in pixel space (> 0 if counter clockwise)
+static float signed_area(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+{
+    return (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+}
+
+void OcclusionBuffer::add_occluder(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices, const glm::mat4& model)
+{
+    assert(indices.size() % 3 == 0);
+
+    thread_local std::vector<glm::vec3> pixels;
+    thread_local std::vector<uint8_t>   valid;
+    pixels.resize(vertices.size());
+    valid.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+        valid[i] = project(glm::vec3(model * glm::vec4(vertices[i], 1)), pixels[i]);
+
+    // Occluders are two sided : make every triangle counter clockwise
+    thread_local std::vector<std::array<uint32_t, 3>> faces;
+    faces.clear();
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const uint32_t i0 = indices[i], i1 = indices[i + 1], i2 = indices[i + 2];
+        if (!valid[i0] || !valid[i1] || !valid[i2])
+            continue;
+        const float area = signed_area(pixels[i0], pixels[i1], pixels[i2]);
+        if (std::abs(area) < 1e-6f)
+            continue;
+        faces.emplace_back(area > 0 ? std::array{i0, i1, i2} : std::array{i0, i2, i1});
+    }
+
+    // Edges sorted by vertex pair (face * 3 + edge index)
+    thread_local std::vector<std::pair<uint64_t, uint32_t>> edges;
+    edges.clear();
+    for (uint32_t face = 0; face < faces.size(); ++face)
+        for (uint32_t edge = 0; edge < 3; ++edge)
+        {
+            const uint32_t from = faces[face][edge], to = faces[face][(edge + 1) % 3];
+            edges.emplace_back(static_cast<uint64_t>(std::min(from, to)) << 32 | std::max(from, to), face * 3 + edge);
+        }
+    std::ranges::sort(edges);
+
+    // Two triangles sharing an edge are merged when they form a convex and planar quad
+    thread_local std::vector<uint8_t> merged;
+    merged.assign(faces.size(), false);
+    for (size_t i = 0; i + 1 < edges.size(); ++i)
+    {
+        if (edges[i].first != edges[i + 1].first)
+            continue;
+        const uint32_t face_a = edges[i].second / 3, edge_a = edges[i].second % 3;
+        const uint32_t face_b = edges[i + 1].second / 3, edge_b = edges[i + 1].second % 3;
+        if (face_a == face_b || merged[face_a] || merged[face_b])
+            continue;
+
+        // The third vertex of the other triangle is inserted in the shared edge
+        const auto&     a      = faces[face_a];
+        const glm::vec3 quad[] = {pixels[a[edge_a]], pixels[faces[face_b][(edge_b + 2) % 3]], pixels[a[(edge_a + 1) % 3]], pixels[a[(edge_a + 2) % 3]]};
+        if (add_polygon(quad))
+        {
+            merged[face_a] = true;
+            merged[face_b] = true;
+            ++i;
+        }
+    }
+
+    for (size_t face = 0; face < faces.size(); ++face)
+        if (!merged[face])
+        {
+            const glm::vec3 triangle[] = {pixels[faces[face][0]], pixels[faces[face][1]], pixels[faces[face][2]]};
+            add_polygon(triangle);
+        }
+}
+
+bool OcclusionBuffer::add_polygon(std::span<const glm::vec3> vertices)
+{
+    assert(vertices.size() == 3 || vertices.size() == 4);
+    const size_t count = vertices.size();
+    for (size_t i = 0; i < count; ++i)
+        if (signed_area(vertices[i], vertices[(i + 1) % count], vertices[(i + 2) % count]) < 1e-6f)
+            return false;
+
+    const glm::vec3& p0   = vertices[0];
+    const glm::vec3& p1   = vertices[1];
+    const glm::vec3& p2   = vertices[2];
+    const float      area = signed_area(p0, p1, p2);
+
+    Polygon polygon;
+    polygon.dz_dx = ((p1.z - p0.z) * (p2.y - p0.y) - (p2.z - p0.z) * (p1.y - p0.y)) / area;
+    polygon.dz_dy = ((p2.z - p0.z) * (p1.x - p0.x) - (p1.z - p0.z) * (p2.x - p0.x)) / area;
+    polygon.z0    = p0.z - polygon.dz_dx * p0.x - polygon.dz_dy * p0.y;
+
+    // The fourth vertex of a quad should be on the plane of the three others, the remaining error is added to the depth
+    float plane_error = 0;
+    if (count == 4)
+    {
+        plane_error = std::abs(polygon.dz_dx * vertices[3].x + polygon.dz_dy * vertices[3].y + polygon.z0 - vertices[3].z);
+        if (plane_error > COPLANAR_TOLERANCE)
+            return false;
+    }
+    // Farthest depth of the plane in the pixel
+    polygon.z0 += 0.5f * (std::abs(polygon.dz_dx) + std::abs(polygon.dz_dy)) + plane_error;
+
+    for (size_t e = 0; e < 4; ++e)
+    {
+        if (e >= count)
+        {
+            polygon.a[e] = polygon.b[e] = polygon.c[e] = 0;
+            continue;
+        }
+        const glm::vec3& from = vertices[e];
+        const glm::vec3& to   = vertices[(e + 1) % count];
+        polygon.a[e]          = -(to.y - from.y);
+        polygon.b[e]          = to.x - from.x;
+        // The whole pixel is inside when its center is half a pixel inside the edge
+        polygon.c[e] = (to.y - from.y) * from.x - (to.x - from.x) * from.y - 0.5f * (std::abs(polygon.a[e]) + std::abs(polygon.b[e]));
+    }
+
+    float min_x = FLT_MAX, max_x = -FLT_MAX, min_y = FLT_MAX, max_y = -FLT_MAX;
+    for (const auto& vertex : vertices)
+    {
+        min_x = std::min(min_x, vertex.x);
+        max_x = std::max(max_x, vertex.x);
+        min_y = std::min(min_y, vertex.y);
+        max_y = std::max(max_y, vertex.y);
+    }
+    polygon.min_x = std::max(0, static_cast<int32_t>(std::floor(min_x)));
+    polygon.max_x = std::min(static_cast<int32_t>(resolution.x) - 1, static_cast<int32_t>(std::ceil(max_x)));
+    polygon.min_y = std::max(0, static_cast<int32_t>(std::floor(min_y)));
+    polygon.max_y = std::min(static_cast<int32_t>(resolution.y) - 1, static_cast<int32_t>(std::ceil(max_y)));
+    if (polygon.min_x > polygon.max_x || polygon.min_y > polygon.max_y)
+        return true;
+
+    const uint32_t index = static_cast<uint32_t>(polygons.size());
+    polygons.emplace_back(polygon);
+    for (int32_t band = polygon.min_y / static_cast<int32_t>(BAND_HEIGHT); band <= polygon.max_y / static_cast<int32_t>(BAND_HEIGHT); ++band)
+        bands[band].emplace_back(index);
+    return true;
+}
+
+void OcclusionBuffer::rasterize_band(uint32_t band)
+{
+    const int32_t band_min_y = static_cast<int32_t>(band * BAND_HEIGHT);
+    const int32_t band_max_y = std::min(static_cast<int32_t>((band + 1) * BAND_HEIGHT), static_cast<int32_t>(resolution.y)) - 1;
+
+    for (const auto& polygon_index : bands[band])
+    {
+        const Polygon& poly = polygons[polygon_index];
+
+        const int32_t min_y   = std::max(poly.min_y, band_min_y);
+        const int32_t max_y   = std::min(poly.max_y, band_max_y);
+        const int32_t start_x = poly.min_x & ~3;
+
+        for (int32_t y = min_y; y <= max_y; ++y)
+        {
+            // Edge functions : e = a * x + (b * y + c), >= 0 if the pixel is fully inside
+            const float py    = static_cast<float>(y) + 0.5f;
+            const float row_0 = poly.b[0] * py + poly.c[0];
+            const float row_1 = poly.b[1] * py + poly.c[1];
+            const float row_2 = poly.b[2] * py + poly.c[2];
+            const float row_3 = poly.b[3] * py + poly.c[3];
+            const float row_z = poly.dz_dy * py + poly.z0;
+            float*      row   = depth.data() + static_cast<size_t>(y) * resolution.x;
+
+#if OCCLUSION_SSE
+            const __m128 lane_offset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            const __m128 zero        = _mm_setzero_ps();
+            for (int32_t x = start_x; x <= poly.max_x; x += 4)
+            {
+                const __m128 px     = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane_offset);
+                const __m128 e0     = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(poly.a[0]), px), _mm_set1_ps(row_0));
+                const __m128 e1     = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(poly.a[1]), px), _mm_set1_ps(row_1));
+                const __m128 e2     = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(poly.a[2]), px), _mm_set1_ps(row_2));
+                const __m128 e3     = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(poly.a[3]), px), _mm_set1_ps(row_3));
+                const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_and_ps(_mm_cmpge_ps(e2, zero), _mm_cmpge_ps(e3, zero)));
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+                const __m128 z       = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(poly.dz_dx), px), _mm_set1_ps(row_z));
+                const __m128 old     = _mm_loadu_ps(row + x);
+                const __m128 closest = _mm_min_ps(old, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closest), _mm_andnot_ps(inside, old)));
+            }
+#else
+            for (int32_t x = start_x; x <= poly.max_x; ++x)
+            {
+                const float px = static_cast<float>(x) + 0.5f;
+                if (poly.a[0] * px + row_0 >= 0 && poly.a[1] * px + row_1 >= 0 && poly.a[2] * px + row_2 >= 0 && poly.a[3] * px + row_3 >= 0)
+                {
+                    const float z = poly.dz_dx * px + row_z;
+                    if (z < row[x])
+                        row[x] = z;
+                }
+            }
+#endif
+        }
+    }
+}
+
+void OcclusionBuffer::rasterize()
+{
+    for (uint32_t band = 0; band < band_count(); ++band)
+        rasterize_band(band);
+}
+
+bool OcclusionBuffer::is_occluder_candidate(const Bounds& local_bounds, size_t triangle_count)
+{
+    if (triangle_count == 0 || triangle_count > OCCLUDER_MAX_TRIANGLES)
+        return false;
+    // The second largest side : poles and small props hide almost nothing
+    const glm::vec3 extent = local_bounds.extent();
+    const float     median = std::max(std::min(extent.x, extent.y), std::min(std::max(extent.x, extent.y), extent.z));
+    return median >= OCCLUDER_MIN_SIZE;
+}
+
+bool OcclusionBuffer::test(const Bounds& bounds) const
+{
+    if (depth.empty())
+        return true;
+
+    glm::vec2 min_pixel{FLT_MAX, FLT_MAX};
+    glm::vec2 max_pixel{-FLT_MAX, -FLT_MAX};
+    float     nearest = 1;
+    for (int i = 0; i < 8; ++i)
+    {
+        const glm::vec3 corner{i & 1 ? bounds.max().x : bounds.min().x, i & 2 ? bounds.max().y : bounds.min().y, i & 4 ? bounds.max().z : bounds.min().z};
+        glm::vec3       pixel;
+        // Crossing the near or far plane : cannot tell
+        if (!project(corner, pixel))
+            return true;
+        min_pixel = {std::min(min_pixel.x, pixel.x), std::min(min_pixel.y, pixel.y)};
+        max_pixel = {std::max(max_pixel.x, pixel.x), std::max(max_pixel.y, pixel.y)};
+        nearest   = std::min(nearest, pixel.z);
+    }
+
+    const int32_t min_x = std::max(0, static_cast<int32_t>(std::floor(min_pixel.x)));
+    const int32_t max_x = std::min(static_cast<int32_t>(resolution.x) - 1, static_cast<int32_t>(std::floor(max_pixel.x)));
+    const int32_t min_y = std::max(0, static_cast<int32_t>(std::floor(min_pixel.y)));
+    const int32_t max_y = std::min(static_cast<int32_t>(resolution.y) - 1, static_cast<int32_t>(std::floor(max_pixel.y)));
+    // Outside of the screen, this is the job of the frustum culling
+    if (min_x > max_x || min_y > max_y)
+        return true;
+
+    // Visible as soon as one covered pixel is farther than the nearest point of the box
+    for (int32_t y = min_y; y <= max_y; ++y)
+    {
+        const float* row = depth.data() + static_cast<size_t>(y) * resolution.x;
+        for (int32_t x = min_x; x <= max_x; ++x)
+            if (row[x] >= nearest)
+                return true;
+    }
+    return false;
+}
+} // namespace Eng
@@ -24,13 +24,17 @@ void Profiler::set_record(bool enabled)
         return;
     b_record = enabled;
     if (b_record)
+    {
         record_start = std::chrono::steady_clock::now();
+        gpu_events.clear();
+    }
 }
 
 void Profiler::clear()
 {
     std::lock_guard lk(global_lock);
     recorded_frames.clear();
+    gpu_events.clear();
 }
 
 
@@ -50,23 +54,38 @@ void Profiler::next_frame()
         std::lock_guard             lk_thread(thread->data_mutex);
         std::shared_ptr<ThreadData> new_thread_data = nullptr;
 
-        if (!thread->thread_data->markers.empty() || !thread->thread_data->events.empty())
+        if (!thread->thread_data->markers.empty() || !thread->thread_data->events.empty() || !thread->thread_data->counters.empty())
         {
             new_thread_data = std::make_shared<ThreadData>();
             new_thread_data->markers.reserve(thread->thread_data->markers.size());
             new_thread_data->events.reserve(thread->thread_data->events.size());
+            new_thread_data->counters.reserve(thread->thread_data->counters.size());
         }
 
         recorded_frame->thread_data.emplace(thread->this_thread, thread->thread_data);
-        recorded_frame->start = record_start;
-        recorded_frame->end   = end_time;
-        thread->thread_data   = new_thread_data ? new_thread_data : std::make_shared<ThreadData>();
+        thread->thread_data = new_thread_data ? new_thread_data : std::make_shared<ThreadData>();
     }
 
+    recorded_frame->start      = record_start;
+    recorded_frame->end        = end_time;
+    recorded_frame->gpu_events = std::move(gpu_events);
+    gpu_events.clear();
     recorded_frames.emplace_back(recorded_frame);
     record_start = end_time;
 }
 
+void Profiler::add_gpu_event(const ProfilerEvent& event)
+{
+    std::lock_guard lk(global_lock);
+    if (!b_record)
+        return;
+    if (event.start >= record_start)
+        return gpu_events.push_back(event);
+    for (auto it = recorded_frames.rbegin(); it != recorded_frames.rend(); ++it)
+        if ((*it)->start <= event.start)
+            return (*it)->gpu_events.push_back(event);
+}
+
 Profiler& Profiler::get()
 {
     return profiler;
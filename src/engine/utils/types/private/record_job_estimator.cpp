@@ -0,0 +1,28 @@
+#include "record_job_estimator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Eng
+{
+uint32_t RecordJobEstimator::get_job_count(std::optional<size_t> draw_count, uint32_t max_jobs) const
+{
+    max_jobs = std::max(max_jobs, 1u);
+    if (!draw_count)
+        return max_jobs;
+
+    size_t jobs = *draw_count / std::max(settings.min_draws_per_job, 1u);
+    // Without measurement yet, only the minimum number of draws per job is used
+    if (draw_cost > 0 && settings.target_job_duration.count() > 0)
+        jobs = std::min(jobs, static_cast<size_t>(std::ceil(static_cast<double>(*draw_count) * draw_cost / static_cast<double>(settings.target_job_duration.count()))));
+    return static_cast<uint32_t>(std::clamp<size_t>(jobs, 1, max_jobs));
+}
+
+void RecordJobEstimator::add_sample(size_t draw_count, std::chrono::nanoseconds record_duration)
+{
+    if (draw_count == 0)
+        return;
+    const double cost = static_cast<double>(record_duration.count()) / static_cast<double>(draw_count);
+    draw_cost         = draw_cost > 0 ? std::lerp(draw_cost, cost, static_cast<double>(settings.smoothing)) : cost;
+}
+} // namespace Eng
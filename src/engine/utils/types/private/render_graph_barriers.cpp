@@ -0,0 +1,67 @@
+#include "render_graph_barriers.hpp"
+
+#include <algorithm>
+
+namespace Eng
+{
+bool RenderGraphBarriers::build(const RenderGraphSchedule& schedule, std::span<const GraphResource> resources, std::span<const GraphResourceRead> reads)
+{
+    const uint32_t node_count = static_cast<uint32_t>(schedule.node_count());
+
+    // Every reader of a resource is combined in a single transition
+    std::vector<ResourceAccess> written(node_count, RESOURCE_ACCESS_NONE);
+    std::vector<ResourceAccess> read_access(resources.size(), RESOURCE_ACCESS_NONE);
+    for (const auto& resource : resources)
+        written[resource.node] |= resource.write_access;
+
+    // Waits start with the own attachments of the node
+    wait_offsets.assign(1, 0);
+    wait_accesses.clear();
+    for (uint32_t node = 0; node < node_count; ++node)
+    {
+        wait_accesses.insert(wait_accesses.end(), schedule.get_waits(node).size(), written[node]);
+        wait_offsets.emplace_back(static_cast<uint32_t>(wait_accesses.size()));
+    }
+
+    for (const auto& read : reads)
+    {
+        const auto waits = schedule.get_waits(read.node);
+        const auto found = std::ranges::lower_bound(waits, resources[read.resource].node);
+        if (found == waits.end() || *found != resources[read.resource].node)
+            return false;
+        read_access[read.resource] |= read.access;
+        wait_accesses[wait_offsets[read.node] + (found - waits.begin())] |= read.access;
+    }
+
+    // Resources are bucketed by node, keeping their order
+    begin_offsets.assign(node_count + 1, 0);
+    end_offsets.assign(node_count + 1, 0);
+    for (uint32_t i = 0; i < resources.size(); ++i)
+    {
+        ++begin_offsets[resources[i].node + 1];
+        const ResourceAccess after = read_access[i] | resources[i].final_access;
+        if (after != RESOURCE_ACCESS_NONE && after != resources[i].write_access)
+            ++end_offsets[resources[i].node + 1];
+    }
+    for (uint32_t node = 0; node < node_count; ++node)
+    {
+        begin_offsets[node + 1] += begin_offsets[node];
+        end_offsets[node + 1] += end_offsets[node];
+    }
+
+    begin_barriers.resize(begin_offsets.back());
+    end_barriers.resize(end_offsets.back());
+    std::vector<uint32_t> begin_cursor(begin_offsets.begin(), begin_offsets.end() - 1);
+    std::vector<uint32_t> end_cursor(end_offsets.begin(), end_offsets.end() - 1);
+    for (uint32_t i = 0; i < resources.size(); ++i)
+    {
+        const GraphResource& resource = resources[i];
+        begin_barriers[begin_cursor[resource.node]++] = ResourceBarrier{i, RESOURCE_ACCESS_NONE, resource.write_access};
+
+        const ResourceAccess after = read_access[i] | resource.final_access;
+        if (after != RESOURCE_ACCESS_NONE && after != resource.write_access)
+            end_barriers[end_cursor[resource.node]++] = ResourceBarrier{i, resource.write_access, after};
+    }
+    return true;
+}
+} // namespace Eng
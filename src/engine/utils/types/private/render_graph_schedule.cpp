@@ -0,0 +1,63 @@
+#include "render_graph_schedule.hpp"
+
+#include <algorithm>
+
+namespace Eng
+{
+bool RenderGraphSchedule::build(std::span<const std::vector<uint32_t>> dependencies)
+{
+    const uint32_t count = static_cast<uint32_t>(dependencies.size());
+
+    // Deduplicated wait lists
+    waits.clear();
+    wait_offsets.assign(1, 0);
+    for (const auto& node_dependencies : dependencies)
+    {
+        const size_t begin = waits.size();
+        waits.insert(waits.end(), node_dependencies.begin(), node_dependencies.end());
+        std::sort(waits.begin() + begin, waits.end());
+        waits.erase(std::unique(waits.begin() + begin, waits.end()), waits.end());
+        wait_offsets.emplace_back(static_cast<uint32_t>(waits.size()));
+    }
+
+    // Reversed edges
+    consumer_offsets.assign(count + 1, 0);
+    for (uint32_t wait : waits)
+        ++consumer_offsets[wait + 1];
+    for (uint32_t node = 0; node < count; ++node)
+        consumer_offsets[node + 1] += consumer_offsets[node];
+    consumers.resize(waits.size());
+    std::vector<uint32_t> cursor(consumer_offsets.begin(), consumer_offsets.end() - 1);
+    for (uint32_t node = 0; node < count; ++node)
+        for (uint32_t wait : get_waits(node))
+            consumers[cursor[wait]++] = node;
+
+    // Kahn's algorithm, one level at a time
+    std::vector<uint32_t> pending(count);
+    order.clear();
+    levels.assign(count, 0);
+    level_offsets.assign(1, 0);
+    for (uint32_t node = 0; node < count; ++node)
+    {
+        pending[node] = wait_offsets[node + 1] - wait_offsets[node];
+        if (pending[node] == 0)
+            order.emplace_back(node);
+    }
+    for (size_t level_begin = 0; level_begin < order.size();)
+    {
+        const size_t level_end = order.size();
+        level_offsets.emplace_back(static_cast<uint32_t>(level_end));
+        for (size_t i = level_begin; i < level_end; ++i)
+            for (uint32_t consumer : get_consumers(order[i]))
+                if (--pending[consumer] == 0)
+                {
+                    levels[consumer] = static_cast<uint32_t>(level_offsets.size() - 1);
+                    order.emplace_back(consumer);
+                }
+        std::sort(order.begin() + level_end, order.end());
+        level_begin = level_end;
+    }
+
+    return order.size() == count;
+}
+} // namespace Eng
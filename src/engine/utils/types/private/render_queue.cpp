@@ -0,0 +1,48 @@
+#include "render_queue.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace Eng
+{
+void RenderQueue::sort()
+{
+    constexpr size_t RADIX_THRESHOLD = 256;
+
+    if (queue.size() < RADIX_THRESHOLD)
+    {
+        std::ranges::sort(queue,
+                          [](const RenderQueueItem& a, const RenderQueueItem& b)
+                          {
+                              return a.key < b.key;
+                          });
+        return;
+    }
+
+    // Histogram of every byte in a single pass
+    std::array<std::array<uint32_t, 256>, 8> histograms{};
+    for (const auto& item : queue)
+        for (size_t byte = 0; byte < 8; ++byte)
+            ++histograms[byte][item.key >> byte * 8 & 0xFF];
+
+    scratch.resize(queue.size());
+    for (size_t byte = 0; byte < 8; ++byte)
+    {
+        auto& histogram = histograms[byte];
+        // Every key has the same value for this byte
+        if (histogram[queue.front().key >> byte * 8 & 0xFF] == queue.size())
+            continue;
+
+        uint32_t offset = 0;
+        for (auto& count : histogram)
+        {
+            const uint32_t bucket_size = count;
+            count                      = offset;
+            offset                    += bucket_size;
+        }
+        for (const auto& item : queue)
+            scratch[histogram[item.key >> byte * 8 & 0xFF]++] = item;
+        queue.swap(scratch);
+    }
+}
+} // namespace Eng
@@ -0,0 +1,113 @@
+#include "shadow_atlas.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numeric>
+#include <glm/geometric.hpp>
+
+namespace Eng
+{
+// Keep the even bits of a Z order index
+static uint32_t compact_bits(uint64_t value)
+{
+    value &= 0x5555555555555555ull;
+    value = (value | value >> 1) & 0x3333333333333333ull;
+    value = (value | value >> 2) & 0x0f0f0f0f0f0f0f0full;
+    value = (value | value >> 4) & 0x00ff00ff00ff00ffull;
+    value = (value | value >> 8) & 0x0000ffff0000ffffull;
+    value = (value | value >> 16) & 0x00000000ffffffffull;
+    return static_cast<uint32_t>(value);
+}
+
+ShadowAtlas::ShadowAtlas(uint32_t in_size, uint32_t in_min_tile_size) : size(std::bit_floor(std::max(1u, in_size))), min_tile_size(std::min(size, std::bit_floor(std::max(1u, in_min_tile_size))))
+{
+}
+
+uint32_t ShadowAtlas::get_tile_size(float importance, uint32_t max_size) const
+{
+    const float    wanted     = std::clamp(importance, 0.f, 1.f) * static_cast<float>(size);
+    const uint32_t max_tile   = std::max(min_tile_size, std::bit_floor(std::min(std::max(1u, max_size), size)));
+    const uint32_t tile_size  = std::bit_floor(std::max(1u, static_cast<uint32_t>(wanted)));
+    return std::clamp(tile_size, min_tile_size, max_tile);
+}
+
+float ShadowAtlas::screen_importance(const glm::vec3& center, float radius, const glm::vec3& view_position, float tan_half_fov)
+{
+    const float distance = glm::length(center - view_position);
+    if (distance <= radius)
+        return 1;
+    return std::clamp(radius / (distance * tan_half_fov), 0.f, 1.f);
+}
+
+void ShadowAtlas::allocate(std::span<const ShadowAtlasRequest> requests, std::vector<ShadowAtlasTile>& out_tiles) const
+{
+    out_tiles.assign(requests.size(), {});
+
+    // Sizes are counted in min tiles cells
+    const auto cells = [this](uint32_t tile_size) -> uint64_t
+    {
+        const uint64_t side = tile_size / min_tile_size;
+        return side * side;
+    };
+    const uint64_t capacity = cells(size);
+
+    uint64_t used = 0;
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        out_tiles[i].size  = get_tile_size(requests[i].importance, requests[i].max_size);
+        used              += cells(out_tiles[i].size);
+    }
+
+    // Halve the least important tiles first until everything fits, then drop the least important ones
+    thread_local std::vector<uint32_t> order;
+    order.resize(requests.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(order,
+                             [&](uint32_t a, uint32_t b)
+                             {
+                                 return requests[a].importance < requests[b].importance;
+                             });
+    while (used > capacity)
+    {
+        bool b_downgraded = false;
+        for (uint32_t index : order)
+        {
+            ShadowAtlasTile& tile = out_tiles[index];
+            if (tile.size <= min_tile_size)
+                continue;
+            used         -= cells(tile.size) - cells(tile.size / 2);
+            tile.size    /= 2;
+            b_downgraded  = true;
+            if (used <= capacity)
+                break;
+        }
+        if (b_downgraded)
+            continue;
+        for (uint32_t index : order)
+            if (out_tiles[index].size != 0)
+            {
+                used                  -= cells(out_tiles[index].size);
+                out_tiles[index].size  = 0;
+                break;
+            }
+    }
+
+    // Every previous tile is a multiple of the current one : placing them by decreasing size along a Z order curve keeps them aligned
+    std::ranges::stable_sort(order,
+                             [&](uint32_t a, uint32_t b)
+                             {
+                                 return out_tiles[a].size > out_tiles[b].size;
+                             });
+    uint64_t cursor = 0;
+    for (uint32_t index : order)
+    {
+        ShadowAtlasTile& tile = out_tiles[index];
+        if (!tile.is_valid())
+            continue;
+        tile.x  = compact_bits(cursor) * min_tile_size;
+        tile.y  = compact_bits(cursor >> 1) * min_tile_size;
+        cursor += cells(tile.size);
+    }
+}
+} // namespace Eng
@@ -0,0 +1,233 @@
+#include "world_partition.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+namespace Eng
+{
+WorldPartition::WorldPartition(float in_cell_size, uint32_t in_level_count, float in_streaming_distance) : cell_size(in_cell_size), level_count(std::clamp(in_level_count, 1u, 16u)), streaming_distance(in_streaming_distance)
+{
+    assert(cell_size > 0);
+}
+
+WorldCell WorldPartition::get_cell(const Bounds& bounds) const
+{
+    const glm::vec3 extent     = bounds.extent();
+    const float     max_extent = std::max(extent.x, extent.z);
+    uint32_t        level      = 0;
+    while (level + 1 < level_count && max_extent > get_cell_size(level))
+        ++level;
+
+    const glm::vec3 center = bounds.center();
+    const float     size   = get_cell_size(level);
+    return {static_cast<int32_t>(std::floor(center.x / size)), static_cast<int32_t>(std::floor(center.z / size)), level};
+}
+
+Bounds WorldPartition::get_cell_bounds(const WorldCell& cell) const
+{
+    const float size = get_cell_size(cell.level);
+    return {{(static_cast<float>(cell.x) - 0.5f) * size, -FLT_MAX, (static_cast<float>(cell.z) - 0.5f) * size},
+            {(static_cast<float>(cell.x) + 1.5f) * size, FLT_MAX, (static_cast<float>(cell.z) + 1.5f) * size}};
+}
+
+float WorldPartition::get_distance(const WorldCell& cell, const glm::vec3& position) const
+{
+    const Bounds bounds = get_cell_bounds(cell);
+    const float  dx     = std::max({bounds.min().x - position.x, 0.f, position.x - bounds.max().x});
+    const float  dz     = std::max({bounds.min().z - position.z, 0.f, position.z - bounds.max().z});
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+void WorldPartition::collect_cells(const glm::vec3& position, std::vector<WorldCell>& out_cells, float distance_scale) const
+{
+    thread_local std::vector<std::pair<float, WorldCell>> found;
+    found.clear();
+
+    for (uint32_t level = 0; level < level_count; ++level)
+    {
+        const float   size     = get_cell_size(level);
+        const float   distance = get_streaming_distance(level) * distance_scale;
+        // The loose bounds of a cell overflow by half a cell
+        const int32_t min_x = static_cast<int32_t>(std::floor((position.x - distance - size * 0.5f) / size)) - 1;
+        const int32_t max_x = static_cast<int32_t>(std::floor((position.x + distance + size * 0.5f) / size));
+        const int32_t min_z = static_cast<int32_t>(std::floor((position.z - distance - size * 0.5f) / size)) - 1;
+        const int32_t max_z = static_cast<int32_t>(std::floor((position.z + distance + size * 0.5f) / size));
+        for (int32_t z = min_z; z <= max_z; ++z)
+            for (int32_t x = min_x; x <= max_x; ++x)
+            {
+                const WorldCell cell{x, z, level};
+                const float     cell_distance = get_distance(cell, position);
+                if (cell_distance <= distance)
+                    found.emplace_back(cell_distance, cell);
+            }
+    }
+
+    std::ranges::sort(found,
+                      [](const auto& a, const auto& b)
+                      {
+                          return a.first < b.first;
+                      });
+    out_cells.reserve(out_cells.size() + found.size());
+    for (const auto& cell : found)
+        out_cells.emplace_back(cell.second);
+}
+
+void WorldStreamer::update(const glm::vec3& position, double budget_ms)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    stats.merged_last_update   = 0;
+    stats.unloaded_last_update = 0;
+
+    // Receive the loads finished since the last update
+    thread_local std::vector<WorldCell> finished;
+    {
+        std::lock_guard lk(finished_mtx);
+        finished.swap(finished_loads);
+    }
+    for (const auto& cell : finished)
+    {
+        auto entry = cells.find(cell);
+        assert(entry != cells.end() && entry->second.state == ECellState::Loading);
+        --loading_count;
+        if (entry->second.b_cancelled)
+        {
+            callbacks.unload(cell, false);
+            cells.erase(entry);
+        }
+        else
+            entry->second.state = ECellState::Loaded;
+    }
+    finished.clear();
+
+    desired.clear();
+    partition.collect_cells(position, desired);
+    for (const auto& cell : desired)
+        cells[cell].b_cancelled = false;
+
+    // Cells out of range (with a margin)
+    thread_local std::vector<WorldCell> out_of_range;
+    out_of_range.clear();
+    for (auto& [cell, entry] : cells)
+    {
+        if (partition.get_distance(cell, position) <= partition.get_streaming_distance(cell.level) * (1.f + unload_margin))
+            continue;
+        if (entry.state == ECellState::Loading)
+            entry.b_cancelled = true;
+        else
+            out_of_range.emplace_back(cell);
+    }
+
+    // Start the closest loads first
+    for (const auto& cell : desired)
+    {
+        if (loading_count >= max_concurrent_loads)
+            break;
+        CellEntry& entry = cells[cell];
+        if (entry.state != ECellState::Unloaded)
+            continue;
+        entry.state = ECellState::Loading;
+        ++loading_count;
+        callbacks.load(cell);
+    }
+
+    bool       b_did_work = false;
+    const auto has_budget = [&]
+    {
+        return !b_did_work || std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() < budget_ms;
+    };
+
+    // Unload before merging to release memory first
+    for (const auto& cell : out_of_range)
+    {
+        auto entry = cells.find(cell);
+        if (entry->second.state == ECellState::Unloaded)
+        {
+            cells.erase(entry);
+            continue;
+        }
+        if (!has_budget())
+            break;
+        unload_cell(cell, entry->second);
+        cells.erase(cell);
+        b_did_work = true;
+    }
+
+    for (const auto& cell : desired)
+    {
+        CellEntry& entry = cells[cell];
+        if (entry.state != ECellState::Loaded)
+            continue;
+        if (!has_budget())
+            break;
+        callbacks.merge(cell);
+        entry.state = ECellState::Merged;
+        ++stats.merged_last_update;
+        b_did_work = true;
+    }
+
+    stats.loading = loading_count;
+    stats.loaded  = 0;
+    stats.merged  = 0;
+    for (const auto& entry : cells)
+    {
+        if (entry.second.state == ECellState::Loaded)
+            ++stats.loaded;
+        else if (entry.second.state == ECellState::Merged)
+            ++stats.merged;
+    }
+    stats.last_update_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void WorldStreamer::finish_load(const WorldCell& cell)
+{
+    std::lock_guard lk(finished_mtx);
+    finished_loads.emplace_back(cell);
+}
+
+void WorldStreamer::unload_all()
+{
+    desired.clear();
+    for (auto entry = cells.begin(); entry != cells.end();)
+    {
+        if (entry->second.state == ECellState::Loading)
+        {
+            entry->second.b_cancelled = true;
+            ++entry;
+            continue;
+        }
+        unload_cell(entry->first, entry->second);
+        entry = cells.erase(entry);
+    }
+}
+
+ECellState WorldStreamer::get_state(const WorldCell& cell) const
+{
+    if (auto entry = cells.find(cell); entry != cells.end())
+        return entry->second.state;
+    return ECellState::Unloaded;
+}
+
+bool WorldStreamer::is_idle() const
+{
+    if (loading_count != 0)
+        return false;
+    for (const auto& cell : desired)
+        if (get_state(cell) != ECellState::Merged)
+            return false;
+    return true;
+}
+
+void WorldStreamer::unload_cell(const WorldCell& cell, CellEntry& entry)
+{
+    if (entry.state == ECellState::Loaded || entry.state == ECellState::Merged)
+    {
+        callbacks.unload(cell, entry.state == ECellState::Merged);
+        ++stats.unloaded_last_update;
+    }
+    entry.state = ECellState::Unloaded;
+}
+} // namespace Eng
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "render_graph_schedule.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Eng
+{
+// Memory requirements of an attachment written by a node of a RenderGraphSchedule
+struct AliasedAttachment
+{
+    uint32_t node;
+    uint64_t size;
+    uint64_t alignment;
+    uint32_t memory_type_bits;
+};
+
+// Memory block shared by a chain of attachments
+struct AliasingSlot
+{
+    uint64_t size             = 0;
+    uint64_t alignment        = 1;
+    uint32_t memory_type_bits = UINT32_MAX;
+};
+
+/**
+ * Share memory between the attachments of a render graph whose lifetimes never overlap. An attachment is used by the node writing it and by the
+ * consumers of this node. Another attachment can reuse its memory only if its node waits (directly or not) for each of these uses : the semaphores
+ * between the passes then guarantee that the gpu is done with the previous content. Every attachment of a slot is placed at offset 0.
+ */
+class AttachmentAliasing
+{
+public:
+    void build(const RenderGraphSchedule& schedule, std::span<const AliasedAttachment> attachments);
+
+    uint32_t get_slot(uint32_t attachment) const
+    {
+        return attachment_slots[attachment];
+    }
+
+    std::span<const AliasingSlot> get_slots() const
+    {
+        return slots;
+    }
+
+    // Memory used by the attachments without aliasing
+    uint64_t get_required_size() const
+    {
+        return required_size;
+    }
+
+    // Memory used by the slots
+    uint64_t get_aliased_size() const
+    {
+        return aliased_size;
+    }
+
+private:
+    std::vector<uint32_t>     attachment_slots;
+    std::vector<AliasingSlot> slots;
+    uint64_t                  required_size = 0;
+    uint64_t                  aliased_size  = 0;
+};
+} // namespace Eng
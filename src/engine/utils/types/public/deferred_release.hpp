@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace Eng
+{
+/**
+ * Objects released while the gpu may still use them, stored in the slot of the frame in flight that released them. They are destroyed when this
+ * slot is used again, once the cpu waited for the gpu to finish its previous frame. Destroying an object can release other objects : they are
+ * destroyed in the same flush.
+ */
+template <typename T> class DeferredRelease
+{
+public:
+    void release(T object, size_t frame)
+    {
+        std::lock_guard lock(mutex);
+        if (frame >= frames.size())
+            frames.resize(frame + 1);
+        frames[frame].emplace_back(std::move(object));
+    }
+
+    // The gpu finished the last frame that used this slot
+    void flush(size_t frame)
+    {
+        while (true)
+        {
+            std::vector<T> released;
+            {
+                std::lock_guard lock(mutex);
+                if (frame >= frames.size() || frames[frame].empty())
+                    return;
+                released = std::move(frames[frame]);
+                frames[frame].clear();
+            }
+            released.clear();
+        }
+    }
+
+    // The gpu is idle : destroy everything
+    void flush_all()
+    {
+        while (pending() != 0)
+            for (size_t frame = 0; frame < frame_count(); ++frame)
+                flush(frame);
+    }
+
+    size_t pending() const
+    {
+        std::lock_guard lock(mutex);
+        size_t          count = 0;
+        for (const auto& frame : frames)
+            count += frame.size();
+        return count;
+    }
+
+    size_t pending(size_t frame) const
+    {
+        std::lock_guard lock(mutex);
+        return frame < frames.size() ? frames[frame].size() : 0;
+    }
+
+private:
+    size_t frame_count() const
+    {
+        std::lock_guard lock(mutex);
+        return frames.size();
+    }
+
+    mutable std::mutex          mutex;
+    std::vector<std::vector<T>> frames;
+};
+} // namespace Eng
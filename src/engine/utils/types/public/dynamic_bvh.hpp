@@ -0,0 +1,144 @@
+#pragma once
+#include "bounds.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+#include <glm/vec3.hpp>
+
+namespace Eng
+{
+struct CullingPlanes;
+
+struct BvhRayHit
+{
+    uint32_t user_data = UINT32_MAX;
+    float    distance  = 0;
+};
+
+/**
+ * Dynamic axis aligned bounding box tree.
+ * Leaves store a tight box and a fat box (tight box + margin). Moving a leaf inside its fat box only updates the tight box,
+ * the tree is only modified when a leaf leaves its fat box. The tree is kept balanced with rotations on insertion.
+ * After large batches of insertions, rebuild() gives a better tree with a cache friendly memory layout. Proxies stay valid.
+ * Not thread safe for writes, queries can run concurrently.
+ */
+class DynamicBvh
+{
+public:
+    static constexpr uint32_t NULL_NODE       = UINT32_MAX;
+    static constexpr uint32_t MAX_QUERY_VIEWS = 16;
+
+    // margin : fraction of the box size added on each side of the fat bounds
+    DynamicBvh(float in_margin = 0.1f) : margin(in_margin)
+    {
+    }
+
+    // Returns the proxy id of the new leaf
+    uint32_t insert(const Bounds& bounds, uint32_t user_data);
+    void     remove(uint32_t proxy);
+
+    // Returns true if the leaf was moved in the tree (false if only the tight bounds were updated)
+    bool update(uint32_t proxy, const Bounds& bounds);
+
+    void clear();
+
+    // Rebuild the whole tree top-down (binned SAH). Nodes are stored in depth first order for better cache locality.
+    void rebuild();
+
+    uint32_t get_user_data(uint32_t proxy) const
+    {
+        return nodes[proxy_nodes[proxy]].user_data;
+    }
+
+    Bounds get_bounds(uint32_t proxy) const
+    {
+        const Node& node = nodes[proxy_nodes[proxy]];
+        return {node.tight_min, node.tight_max};
+    }
+
+    size_t size() const
+    {
+        return leaf_count;
+    }
+
+    // Height of the root node (0 for a tree with a single leaf)
+    int32_t get_height() const
+    {
+        return root == NULL_NODE ? 0 : nodes[root].height;
+    }
+
+    /**
+     * Append the user data of every leaf intersecting the given planes.
+     * Subtrees fully inside the volume are collected without further test, leaves still crossing a plane are tested in batch with the SIMD kernel.
+     */
+    void query_frustum(const CullingPlanes& planes, std::vector<uint32_t>& out_user_data) const;
+
+    /**
+     * Same as query_frustum() for multiple views in a single traversal : each node is fetched once and tested against every view that still sees it.
+     * out_user_data[i] receives the result of views[i]. Views are processed by groups of MAX_QUERY_VIEWS.
+     */
+    void query_frustums(std::span<const CullingPlanes> views, std::span<std::vector<uint32_t>* const> out_user_data) const;
+
+    // Append the user data of every leaf overlapping the given box
+    void query_overlap(const Bounds& bounds, std::vector<uint32_t>& out_user_data) const;
+
+    // Append the user data of every leaf overlapping the given sphere
+    void query_sphere(const glm::vec3& center, float radius, std::vector<uint32_t>& out_user_data) const;
+
+    /**
+     * Find the leaf closest to the position (distance to its bounds, 0 if the position is inside) within max_distance.
+     * The optional filter works like the raycast one : it receives the distance to the bounds and returns the real distance or a negative value to ignore the leaf.
+     */
+    bool nearest(const glm::vec3& position, float max_distance, BvhRayHit& out_hit, const std::function<float(uint32_t user_data, float box_distance)>& filter = {}) const;
+
+    /**
+     * Find the closest leaf hit by the ray. The direction does not need to be normalized (distance is expressed in direction units)
+     * The optional filter is called for each candidate leaf with the distance to its bounds, it should return the distance of the real hit or a negative value to ignore the leaf.
+     */
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, BvhRayHit& out_hit, const std::function<float(uint32_t user_data, float box_distance)>& filter = {}) const;
+
+    // Check the tree structure, used by tests
+    bool validate() const;
+
+private:
+    struct Node
+    {
+        bool is_leaf() const
+        {
+            return left == NULL_NODE;
+        }
+
+        // Fat bounds for leaves, union of the children for internal nodes
+        glm::vec3 min;
+        glm::vec3 max;
+        glm::vec3 tight_min;
+        glm::vec3 tight_max;
+        uint32_t  parent    = NULL_NODE; // Next free node when the node is not used
+        uint32_t  left      = NULL_NODE;
+        uint32_t  right     = NULL_NODE;
+        uint32_t  user_data = 0;
+        uint32_t  proxy     = NULL_NODE;
+        int32_t   height    = -1; // -1 when the node is free
+    };
+
+    uint32_t allocate_node();
+    void     free_node(uint32_t node);
+    void     insert_leaf(uint32_t leaf);
+    void     remove_leaf(uint32_t leaf);
+    uint32_t balance(uint32_t node);
+    void     refit_ancestors(uint32_t node);
+    void     collect_leaves(uint32_t node, std::vector<uint32_t>& out_user_data) const;
+    bool     validate_node(uint32_t node, uint32_t parent) const;
+    uint32_t build_recursive(std::vector<Node>& leaves, size_t first, size_t last, uint32_t parent);
+
+    std::vector<Node>     nodes;
+    std::vector<uint32_t> proxy_nodes; // Proxy to leaf node index
+    std::vector<uint32_t> free_proxies;
+    uint32_t              root       = NULL_NODE;
+    uint32_t              free_list  = NULL_NODE;
+    size_t                leaf_count = 0;
+    float                 margin;
+};
+} // namespace Eng
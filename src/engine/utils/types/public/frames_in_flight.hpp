@@ -0,0 +1,27 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Eng
+{
+/**
+ * Size of the per-frame rings : command buffers, descriptor sets, fences, image available semaphores and pending kill lists have one copy per frame
+ * in flight. The swapchain needs one more image than the frames in flight, so that the next image can be acquired while the last one is presented.
+ */
+struct FramesInFlight
+{
+    // Copies of every per-frame resource (at least one)
+    static uint8_t ring_size(uint8_t frames_in_flight)
+    {
+        return std::max<uint8_t>(frames_in_flight, 1);
+    }
+
+    // Images requested to the presentation engine within the surface limits (max_image_count 0 means no limit)
+    static uint32_t swapchain_image_count(uint8_t frames_in_flight, uint32_t min_image_count, uint32_t max_image_count)
+    {
+        const uint32_t count = std::max<uint32_t>(ring_size(frames_in_flight) + 1u, min_image_count);
+        return max_image_count > 0 ? std::min(count, max_image_count) : count;
+    }
+};
+} // namespace Eng
@@ -0,0 +1,113 @@
+#pragma once
+#include "bounds.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/vec4.hpp>
+
+namespace Eng
+{
+enum class ECullingSimd
+{
+    Scalar,
+    Sse4,
+    Avx2,
+};
+
+/**
+ * Planes of a convex volume. A point p is inside when dot(plane.xyz, p) + plane.w >= 0 for every plane.
+ * Planes does not need to be normalized.
+ */
+struct CullingPlanes
+{
+    static constexpr uint32_t MAX_PLANES = 6;
+
+    // Extract planes from a view projection matrix (left, right, bottom, top, near and optionally far)
+    static CullingPlanes from_view_proj(const glm::mat4& view_proj, bool b_far_plane = false);
+
+    void add_plane(const glm::vec4& plane)
+    {
+        if (count < MAX_PLANES)
+            planes[count++] = plane;
+    }
+
+    // Scalar reference test
+    bool test(const glm::vec3& center, const glm::vec3& half_extent) const;
+
+    bool test(const Bounds& bounds) const
+    {
+        return test(bounds.center(), bounds.extent() * 0.5f);
+    }
+
+    glm::vec4 planes[MAX_PLANES];
+    uint32_t  count = 0;
+};
+
+/**
+ * Structure of arrays storage of axis aligned boxes (center + half extent) consumed by the batch culling kernels.
+ * Arrays are padded with empty boxes to a multiple of 8 elements so the SIMD paths never read out of bounds.
+ */
+class CullingBounds
+{
+public:
+    static constexpr size_t PADDING = 8;
+
+    void reserve(size_t box_count);
+    void clear();
+
+    // Returns the index of the new box
+    size_t push(const Bounds& bounds);
+    size_t push(const glm::vec3& center, const glm::vec3& half_extent);
+    void   set(size_t index, const glm::vec3& center, const glm::vec3& half_extent);
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    // Size of each array including padding
+    size_t padded_size() const
+    {
+        return center_x.size();
+    }
+
+    std::vector<float> center_x;
+    std::vector<float> center_y;
+    std::vector<float> center_z;
+    std::vector<float> half_extent_x;
+    std::vector<float> half_extent_y;
+    std::vector<float> half_extent_z;
+
+private:
+    void resize_padded(size_t box_count);
+
+    size_t count = 0;
+};
+
+namespace Culling
+{
+// Best kernel supported by the current CPU
+ECullingSimd best_simd_level();
+
+// Number of 64 bits words required to store the visibility mask of box_count boxes
+inline size_t mask_word_count(size_t box_count)
+{
+    return (box_count + 63) / 64;
+}
+
+/**
+ * Write one bit per box in out_mask (1 = visible).
+ * out_mask should contain at least mask_word_count(bounds.size()) words. Bits after the last box are cleared.
+ * If the requested simd level is not supported by this CPU the best available one is used instead.
+ */
+void frustum_mask(const CullingPlanes& planes, const CullingBounds& bounds, std::span<uint64_t> out_mask, ECullingSimd simd = best_simd_level());
+
+/**
+ * Append the index of every visible box to out_indices (sorted by index).
+ * Return the number of visible boxes.
+ */
+size_t frustum_indices(const CullingPlanes& planes, const CullingBounds& bounds, std::vector<uint32_t>& out_indices, ECullingSimd simd = best_simd_level());
+} // namespace Culling
+} // namespace Eng
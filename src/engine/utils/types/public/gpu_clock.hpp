@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace Eng
+{
+/**
+ * Convert gpu timestamps to cpu time. With calibrated timestamps, both clocks are sampled at the same time. Otherwise, the only known bound is
+ * that a timestamp is written after the cpu recorded its command : the offset is raised each time a timestamp would be converted before it, which
+ * converges to the shortest observed latency between recording and execution.
+ */
+class GpuClock
+{
+public:
+    // tick_period in nanoseconds, valid_bits of the timestamps (the upper bits wrap around)
+    GpuClock(double tick_period = 1.0, uint32_t valid_bits = 64);
+
+    // The gpu clock was at ticks at the given cpu time
+    void calibrate(uint64_t ticks, std::chrono::steady_clock::time_point time);
+
+    // The gpu wrote ticks after the given cpu time (ignored once calibrated)
+    void align_after(uint64_t ticks, std::chrono::steady_clock::time_point time);
+
+    std::chrono::steady_clock::time_point to_cpu_time(uint64_t ticks) const;
+
+    bool is_calibrated() const
+    {
+        return b_calibrated;
+    }
+
+private:
+    double                                tick_period;
+    uint64_t                              mask;
+    uint64_t                              reference_ticks = 0;
+    std::chrono::steady_clock::time_point reference_time;
+    bool                                  b_has_reference = false;
+    bool                                  b_calibrated    = false;
+};
+} // namespace Eng
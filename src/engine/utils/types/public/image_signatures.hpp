@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace Eng
+{
+/**
+ * Signature of the content last drawn in each image of a pass. Attachments have one copy per frame in flight : a pass can only skip its draws when
+ * the copy of the current frame already holds the same content.
+ */
+class ImageSignatures
+{
+public:
+    // The images were created again : they have no content
+    void reset(size_t image_count)
+    {
+        signatures.assign(image_count, std::nullopt);
+    }
+
+    // Is the image drawn again with this signature (stored until the next change)
+    bool update(size_t image, uint64_t signature)
+    {
+        if (image >= signatures.size())
+            signatures.resize(image + 1);
+        if (signatures[image] == signature)
+            return false;
+        signatures[image] = signature;
+        return true;
+    }
+
+private:
+    std::vector<std::optional<uint64_t>> signatures;
+};
+} // namespace Eng
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/vec3.hpp>
+
+namespace Eng
+{
+// Light influence volume
+struct ClusterLight
+{
+    glm::vec3 position;
+    float     radius;
+};
+
+// Perspective view the clusters are built for. The axes should be normalized and orthogonal, the frustum is symmetric.
+struct LightClusterView
+{
+    glm::vec3 position;
+    glm::vec3 forward;
+    glm::vec3 right;
+    glm::vec3 up;
+    float     tan_half_width;
+    float     tan_half_height;
+    float     z_near;
+    float     z_far;
+};
+
+// Range of the light index list used by a cluster (uploaded as is to the gpu)
+struct LightClusterRange
+{
+    uint32_t offset;
+    uint32_t count;
+};
+
+/**
+ * Assign lights to view space clusters (froxels) : the frustum is split in tiles_x * tiles_y screen tiles and in depth slices with an exponential
+ * distribution between z_near and z_far. The first slice starts at the view position and the last one has no end, so every point in front of the view
+ * belongs to a cluster. A light is added to every cluster whose bounding box intersects its sphere (conservative).
+ * Slices are independent : after begin(), assign_slice() can be called concurrently for different slices, then finalize() builds the compact lists.
+ */
+class LightClusters
+{
+public:
+    LightClusters(uint32_t tiles_x = 16, uint32_t tiles_y = 9, uint32_t slices = 24);
+
+    // Prepare the assignment. The lights are not copied and should stay valid until finalize()
+    void begin(const LightClusterView& view, std::span<const ClusterLight> lights);
+
+    // Assign the lights of a depth slice. Different slices can be assigned from different threads.
+    void assign_slice(uint32_t slice);
+
+    // Assign every slice on the calling thread
+    void assign();
+
+    // Merge the slices into a single index list. Light indices are sorted within each cluster.
+    void finalize();
+
+    uint32_t slice_count() const
+    {
+        return slices;
+    }
+
+    uint32_t cluster_count() const
+    {
+        return tiles_x * tiles_y * slices;
+    }
+
+    uint32_t get_tiles_x() const
+    {
+        return tiles_x;
+    }
+
+    uint32_t get_tiles_y() const
+    {
+        return tiles_y;
+    }
+
+    uint32_t get_cluster_index(uint32_t x, uint32_t y, uint32_t slice) const
+    {
+        return (slice * tiles_y + y) * tiles_x + x;
+    }
+
+    // Cluster containing a world space position (same computation as the resolve shader). Positions behind the view are clamped to the first slice.
+    uint32_t find_cluster(const glm::vec3& world_position) const;
+
+    std::span<const uint32_t> get_cluster_lights(uint32_t cluster) const
+    {
+        const LightClusterRange& range = ranges[cluster];
+        return std::span(light_indices).subspan(range.offset, range.count);
+    }
+
+    const std::vector<LightClusterRange>& get_ranges() const
+    {
+        return ranges;
+    }
+
+    const std::vector<uint32_t>& get_light_indices() const
+    {
+        return light_indices;
+    }
+
+    const LightClusterView& get_view() const
+    {
+        return view;
+    }
+
+    // Start depth of a slice (the end of the last slice is infinite)
+    float get_slice_start(uint32_t slice) const;
+
+private:
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+    uint32_t slices;
+
+    LightClusterView              view{};
+    std::span<const ClusterLight> lights;
+
+    // Per slice light lists of each cluster of the slice
+    std::vector<std::vector<std::vector<uint32_t>>> slice_clusters;
+
+    std::vector<LightClusterRange> ranges;
+    std::vector<uint32_t>          light_indices;
+};
+} // namespace Eng
@@ -3,6 +3,7 @@
 #include "object_ptr.hpp"
 
 #include <memory>
+#include <mutex>
 #include <ranges>
 #include <ankerl/unordered_dense.h>
 
@@ -20,6 +21,12 @@ class ObjectAllocator
   public:
     virtual const ObjectAllocation* allocate(const Reflection::Class* component_class)               = 0;
     virtual void                    free(const Reflection::Class* component_class, void* allocation) = 0;
+
+    // Called when the last TObjectPtr of an object is dropped. Returns true to keep the object alive and destroy it later.
+    virtual bool release(ObjectAllocation*)
+    {
+        return false;
+    }
 };
 
 class ContiguousObjectPool
@@ -190,6 +197,19 @@ class ContiguousObjectAllocator : public ObjectAllocator
 
     ObjectAllocation* allocate(const Reflection::Class* component_class) override;
     void              free(const Reflection::Class* component_class, void* allocation) override;
+    bool              release(ObjectAllocation* allocation) override;
+
+    /**
+     * When enabled, the objects whose last TObjectPtr is dropped are not destroyed in place but kept until flush_released().
+     * Releasing is thread safe, the owner decides when the destructors run (ex : a scene between two frames).
+     */
+    void set_deferred_release(bool b_deferred)
+    {
+        b_deferred_release = b_deferred;
+    }
+
+    // Destroy the released objects, including the ones released by their destructors. Returns the number of destroyed objects.
+    size_t flush_released();
 
     template <typename T, typename... Args> TObjectPtr<T> construct(Args&&... args)
     {
@@ -231,4 +251,8 @@ class ContiguousObjectAllocator : public ObjectAllocator
     std::vector<ContiguousObjectPool*> find_pools(const Reflection::Class* parent_class) const;
 
     ankerl::unordered_dense::map<const Reflection::Class*, std::unique_ptr<ContiguousObjectPool>> pools;
+
+    bool                           b_deferred_release = false;
+    std::mutex                     released_mtx;
+    std::vector<ObjectAllocation*> released;
 };
\ No newline at end of file
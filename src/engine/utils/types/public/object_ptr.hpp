@@ -66,6 +66,7 @@ void TObjectDestructor<T>::destroy()
 class IObject
 {
     friend class ContiguousObjectPool;
+    friend class ContiguousObjectAllocator;
 
     template <typename V> friend class TObjectPtr;
     template <typename V> friend class TObjectRef;
@@ -88,6 +89,9 @@ private:
         allocation = nullptr;
     }
 
+    // Give the last TObjectPtr of this object to its allocator. Returns false if the object should be destroyed immediately.
+    bool release_to_allocator() const;
+
 protected:
     ObjectAllocation* allocation = nullptr;
 };
@@ -110,6 +114,12 @@ template <typename T> class TObjectPtr final : public IObject
             assert(allocation->ptr_count > 0);
             if (allocation->ptr_count == 1)
             {
+                if (release_to_allocator())
+                {
+                    // The allocator owns the last ptr now and will destroy the object later
+                    allocation = nullptr;
+                    return;
+                }
                 destroy();
                 allocation->ptr_count--;
             }
@@ -0,0 +1,101 @@
+#pragma once
+#include "bounds.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/vec2.hpp>
+
+namespace Eng
+{
+/**
+ * Low resolution software depth buffer used for occlusion culling.
+ * Occluders are transformed and binned into horizontal bands of BAND_HEIGHT rows, then each band is rasterized independently
+ * (bands can be rasterized concurrently). Depth is resolved with a min operation so the result does not depend on the order
+ * of the bands or of the occluders. Triangles crossing the near or the far plane are skipped (less occlusion, never wrong occlusion).
+ * Coverage is conservative : a pixel is only written when it is fully inside a polygon, with the farthest depth of the polygon in this pixel.
+ * Coplanar triangles forming a convex quad are merged, so the pixels along their shared edge are still covered.
+ * Stored depth is normalized : 0 = near, 1 = far (whatever the depth convention of the projection).
+ */
+class OcclusionBuffer
+{
+public:
+    static constexpr uint32_t BAND_HEIGHT = 16;
+
+    // Meshes whose two largest sides reach OCCLUDER_MIN_SIZE and with at most OCCLUDER_MAX_TRIANGLES are rasterized as their own occluder
+    static constexpr float  OCCLUDER_MIN_SIZE      = 2.f;
+    static constexpr size_t OCCLUDER_MAX_TRIANGLES = 512;
+
+    // Large meshes hide the others and few triangles keep the rasterization cheap. Their own triangles never occlude more than the mesh itself.
+    static bool is_occluder_candidate(const Bounds& local_bounds, size_t triangle_count);
+
+    // Clear the buffer. The width is rounded up to a multiple of 4.
+    void begin(const glm::mat4& view_proj, const glm::uvec2& in_resolution, bool b_reversed_z = false);
+
+    // Transform an occluder and bin its polygons. Not thread safe, should be called before rasterizing.
+    void add_occluder(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices, const glm::mat4& model);
+
+    uint32_t band_count() const
+    {
+        return (resolution.y + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    }
+
+    // Rasterize every polygon touching this band. Different bands can be rasterized from different threads.
+    void rasterize_band(uint32_t band);
+
+    // Rasterize every band on the calling thread
+    void rasterize();
+
+    // Return false if the box is fully hidden by the rasterized occluders
+    bool test(const Bounds& bounds) const;
+
+    const glm::uvec2& get_resolution() const
+    {
+        return resolution;
+    }
+
+    float get_depth(uint32_t x, uint32_t y) const
+    {
+        return depth[y * resolution.x + x];
+    }
+
+    const std::vector<float>& get_depth_buffer() const
+    {
+        return depth;
+    }
+
+    size_t polygon_count() const
+    {
+        return polygons.size();
+    }
+
+    /**
+     * Triangle or quad in pixel space. A pixel is covered when its center is inside every edge : a * x + (b * y + c) >= 0 (c is moved half a pixel
+     * inward, unused edges are 0). Depth is stored as a plane equation moved to the farthest depth of each pixel : depth = dz_dx * x + (dz_dy * y + z0)
+     */
+    struct Polygon
+    {
+        float   a[4], b[4], c[4];
+        float   dz_dx, dz_dy, z0;
+        int32_t min_x, max_x, min_y, max_y;
+    };
+
+private:
+    // Largest depth difference between the two triangles of a merged quad
+    static constexpr float COPLANAR_TOLERANCE = 1e-5f;
+
+    // Return true if the point is inside the clip volume and write its pixel space position and normalized depth
+    bool project(const glm::vec3& world_position, glm::vec3& out_pixel) const;
+
+    // Bin a convex and counter clockwise polygon of 3 or 4 vertices in pixel space. Return false if it is not convex or not planar.
+    bool add_polygon(std::span<const glm::vec3> vertices);
+
+    glm::mat4                          view_projection;
+    glm::uvec2                         resolution   = {0, 0};
+    bool                               b_reversed   = false;
+    std::vector<float>                 depth;
+    std::vector<Polygon>               polygons;
+    std::vector<std::vector<uint32_t>> bands;
+};
+} // namespace Eng
@@ -2,6 +2,7 @@
 
 #include "logger.hpp"
 #include "spinlock.hpp"
+#include <atomic>
 
 #include <thread>
 #include <ankerl/unordered_dense.h>
@@ -9,12 +10,18 @@
 
 #ifdef ENABLE_PROFILER
 #define PROFILER_MARKER(name)                   Profiler::get().add_marker({#name})
+#define PROFILER_MARKER_NAMED(string_name)      Profiler::get().add_marker({string_name})
 #define PROFILER_SCOPE(name)                    Profiler::EventRecorder __profiler_event__##name(#name)
 #define PROFILER_SCOPE_NAMED(name, string_name) Profiler::EventRecorder __profiler_event__##name(string_name)
+#define PROFILER_COUNTER(name, value)           Profiler::get().add_counter({#name, static_cast<int64_t>(value)})
+#define PROFILER_COUNTER_NAMED(string_name, value) Profiler::get().add_counter({string_name, static_cast<int64_t>(value)})
 #else
 #define PROFILER_MARKER(generic_name)
+#define PROFILER_MARKER_NAMED(string_name)
 #define PROFILER_SCOPE(generic_name)
 #define PROFILER_SCOPE_NAMED(generic_name, string_name)
+#define PROFILER_COUNTER(generic_name, value)
+#define PROFILER_COUNTER_NAMED(string_name, value)
 #endif
 
 class Profiler final
@@ -31,6 +38,19 @@ public:
         std::string                           name;
     };
 
+    // Value sampled once per frame (submissions, draws...)
+    class ProfilerCounter
+    {
+    public:
+        ProfilerCounter(std::string in_name, int64_t in_value) : time(std::chrono::steady_clock::now()), name(std::move(in_name)), value(in_value)
+        {
+        }
+
+        std::chrono::steady_clock::time_point time;
+        std::string                           name;
+        int64_t                               value;
+    };
+
     class ProfilerEvent
     {
     public:
@@ -63,8 +83,9 @@ public:
 
     struct ThreadData final
     {
-        std::vector<ProfilerEvent>  events;
-        std::vector<ProfilerMarker> markers;
+        std::vector<ProfilerEvent>   events;
+        std::vector<ProfilerMarker>  markers;
+        std::vector<ProfilerCounter> counters;
     };
 
     class ProfilerFrameData
@@ -81,6 +102,7 @@ public:
         std::chrono::steady_clock::time_point                                      min;
         std::unique_ptr<Eng::Spinlock>                                             threads_lock;
         ankerl::unordered_dense::map<std::thread::id, std::shared_ptr<ThreadData>> thread_data;
+        std::vector<ProfilerEvent>                                                 gpu_events; // Execution of the render passes, in cpu time
     };
 
     void add_marker(const ProfilerMarker& marker) const
@@ -90,6 +112,13 @@ public:
         get_thread_data().markers.push_back(marker);
     }
 
+    void add_counter(const ProfilerCounter& counter) const
+    {
+        if (!b_record)
+            return;
+        get_thread_data().counters.push_back(counter);
+    }
+
     void add_event(const ProfilerEvent& event) const
     {
         if (!b_record)
@@ -97,6 +126,14 @@ public:
         get_thread_data().events.push_back(event);
     }
 
+    // Gpu timestamps are read a few frames later : the event is stored in the frame it started in
+    void add_gpu_event(const ProfilerEvent& event);
+
+    bool is_recording() const
+    {
+        return b_record.load(std::memory_order_relaxed);
+    }
+
     struct FrameWrapper
     {
         FrameWrapper(Profiler* in_profiler) : profiler(in_profiler)
@@ -134,6 +171,7 @@ private:
 
     std::chrono::steady_clock::time_point           record_start;
     Eng::Spinlock                                   global_lock;
-    bool                                            b_record = false;
+    std::atomic_bool                                b_record = false; // Read without the lock by the recording threads
     std::vector<std::shared_ptr<ProfilerFrameData>> recorded_frames;
+    std::vector<ProfilerEvent>                      gpu_events; // Gpu events of the current frame
 };
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace Eng
+{
+/**
+ * Number of jobs recording the draws of a render pass. The recording cost of a draw is measured over the last frames, then the draws of the
+ * frame are split so that each job records for about target_job_duration. Jobs have a fixed overhead (command buffer begin and end, scheduling) :
+ * few draws are recorded by a single job.
+ */
+class RecordJobEstimator
+{
+public:
+    struct Settings
+    {
+        std::chrono::nanoseconds target_job_duration = std::chrono::microseconds(250);
+        uint32_t                 min_draws_per_job   = 64;
+        float                    smoothing           = 0.1f; // Weight of the last frame in the measured cost of a draw
+    };
+
+    // Number of jobs between 1 and max_jobs (max_jobs are used when the draw count is unknown)
+    uint32_t get_job_count(std::optional<size_t> draw_count, uint32_t max_jobs) const;
+
+    // Measured time of every job of a frame
+    void add_sample(size_t draw_count, std::chrono::nanoseconds record_duration);
+
+    // Average recording time of a draw (0 before the first sample)
+    std::chrono::nanoseconds get_draw_cost() const
+    {
+        return std::chrono::nanoseconds(static_cast<int64_t>(draw_cost));
+    }
+
+    Settings settings;
+
+private:
+    double draw_cost = 0; // In nanoseconds
+};
+} // namespace Eng
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "render_graph_schedule.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Eng
+{
+using ResourceAccess = uint8_t;
+
+// How a node of a render graph uses a resource. The accesses of every reader of a resource are combined.
+enum EResourceAccess : ResourceAccess
+{
+    RESOURCE_ACCESS_NONE             = 0, // The content is discarded
+    RESOURCE_ACCESS_COLOR_ATTACHMENT = 1 << 0,
+    RESOURCE_ACCESS_DEPTH_ATTACHMENT = 1 << 1,
+    RESOURCE_ACCESS_FRAGMENT_READ    = 1 << 2, // Sampled by fragment shaders
+    RESOURCE_ACCESS_COMPUTE_READ     = 1 << 3, // Sampled by compute shaders
+    RESOURCE_ACCESS_PRESENT          = 1 << 4,
+    RESOURCE_ACCESS_COMPUTE_WRITE    = 1 << 5, // Storage image written by compute shaders
+};
+
+// Resource written by a node of a RenderGraphSchedule (an attachment). The final access is the use after the graph (presentation, ui...)
+struct GraphResource
+{
+    uint32_t       node;
+    ResourceAccess write_access;
+    ResourceAccess final_access = RESOURCE_ACCESS_NONE;
+};
+
+struct GraphResourceRead
+{
+    uint32_t       node;
+    uint32_t       resource;
+    ResourceAccess access;
+};
+
+// Transition of a resource between two accesses
+struct ResourceBarrier
+{
+    uint32_t       resource;
+    ResourceAccess src_access;
+    ResourceAccess dst_access;
+
+    bool operator==(const ResourceBarrier&) const = default;
+};
+
+/**
+ * Synchronization of the resources of a render graph. A resource is written by one node then read by the nodes waiting for it.
+ * Each node gets two batches of barriers : before it, its attachments are transitioned for writing (the previous content is discarded) ; after
+ * it, each attachment is transitioned once for all of its readers. Readers only wait for the stages where they actually use the resources of a
+ * dependency, plus the stages writing their own attachments (which may reuse the memory of a resource released by the dependency).
+ */
+class RenderGraphBarriers
+{
+public:
+    // Return false if a resource is read by a node that does not directly wait for the node writing it
+    bool build(const RenderGraphSchedule& schedule, std::span<const GraphResource> resources, std::span<const GraphResourceRead> reads);
+
+    // Recorded before the node (sorted by resource)
+    std::span<const ResourceBarrier> get_begin_barriers(uint32_t node) const
+    {
+        return std::span(begin_barriers).subspan(begin_offsets[node], begin_offsets[node + 1] - begin_offsets[node]);
+    }
+
+    // Recorded after the node (sorted by resource)
+    std::span<const ResourceBarrier> get_end_barriers(uint32_t node) const
+    {
+        return std::span(end_barriers).subspan(end_offsets[node], end_offsets[node + 1] - end_offsets[node]);
+    }
+
+    // Accesses of the node that wait for each of its dependencies, in the order of RenderGraphSchedule::get_waits(). None means execution order only.
+    std::span<const ResourceAccess> get_wait_accesses(uint32_t node) const
+    {
+        return std::span(wait_accesses).subspan(wait_offsets[node], wait_offsets[node + 1] - wait_offsets[node]);
+    }
+
+private:
+    std::vector<ResourceBarrier> begin_barriers;
+    std::vector<uint32_t>        begin_offsets;
+    std::vector<ResourceBarrier> end_barriers;
+    std::vector<uint32_t>        end_offsets;
+    std::vector<ResourceAccess>  wait_accesses;
+    std::vector<uint32_t>        wait_offsets;
+};
+} // namespace Eng
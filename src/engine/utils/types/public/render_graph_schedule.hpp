@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Eng
+{
+/**
+ * Flat execution plan of a dependency graph (render passes). Nodes are identified by their index in the graph given to build().
+ * The order is topological and grouped by level : a node's level is one more than the highest level of its dependencies,
+ * so the nodes of a same level never depend on each other and can be executed in parallel.
+ * Every list is stored in flat arrays : executing the plan does not allocate.
+ */
+class RenderGraphSchedule
+{
+public:
+    // dependencies[i] contains the nodes to execute before node i (duplicates are ignored). Return false if the graph contains a cycle.
+    bool build(std::span<const std::vector<uint32_t>> dependencies);
+
+    size_t node_count() const
+    {
+        return levels.size();
+    }
+
+    // Every node, dependencies first
+    std::span<const uint32_t> get_order() const
+    {
+        return order;
+    }
+
+    uint32_t level_count() const
+    {
+        return static_cast<uint32_t>(level_offsets.empty() ? 0 : level_offsets.size() - 1);
+    }
+
+    uint32_t get_level(uint32_t node) const
+    {
+        return levels[node];
+    }
+
+    // Nodes that can be executed once every previous level is done
+    std::span<const uint32_t> get_level_nodes(uint32_t level) const
+    {
+        return std::span(order).subspan(level_offsets[level], level_offsets[level + 1] - level_offsets[level]);
+    }
+
+    // Nodes to wait before executing this node (sorted)
+    std::span<const uint32_t> get_waits(uint32_t node) const
+    {
+        return std::span(waits).subspan(wait_offsets[node], wait_offsets[node + 1] - wait_offsets[node]);
+    }
+
+    // Nodes waiting for this node (sorted)
+    std::span<const uint32_t> get_consumers(uint32_t node) const
+    {
+        return std::span(consumers).subspan(consumer_offsets[node], consumer_offsets[node + 1] - consumer_offsets[node]);
+    }
+
+private:
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> levels;
+    std::vector<uint32_t> level_offsets;
+    std::vector<uint32_t> waits;
+    std::vector<uint32_t> wait_offsets;
+    std::vector<uint32_t> consumers;
+    std::vector<uint32_t> consumer_offsets;
+};
+} // namespace Eng
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Eng
+{
+/**
+ * 64 bits draw sort key, draws are sorted by increasing key value.
+ * State sorted layout : [layer:4][pipeline:16][material:16][mesh:16][depth:12] (opaque draws : minimize state changes, then front to back)
+ * Depth sorted layout : [layer:4][inverted depth:12][pipeline:16][material:16][mesh:16] (blended draws : back to front first)
+ * Resource ids are 16 bits hashes of the resource address. A collision can only break a group of draws, the bound state is always compared with the real resources.
+ */
+struct DrawSortKey
+{
+    static constexpr uint32_t LAYER_BITS = 4;
+    static constexpr uint32_t DEPTH_BITS = 12;
+
+    static uint16_t resource_id(const void* resource)
+    {
+        uint64_t value = reinterpret_cast<uintptr_t>(resource);
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdull;
+        value ^= value >> 33;
+        return static_cast<uint16_t>(value);
+    }
+
+    // depth is expected to be normalized (0 = near, 1 = far)
+    static uint64_t quantize_depth(float depth)
+    {
+        constexpr float max_depth = static_cast<float>((1u << DEPTH_BITS) - 1);
+        const float     clamped   = depth < 0 ? 0 : depth > 1 ? 1 : depth;
+        return static_cast<uint64_t>(clamped * max_depth);
+    }
+
+    static uint64_t make(uint32_t layer, uint16_t pipeline, uint16_t material, uint16_t mesh, float depth)
+    {
+        return static_cast<uint64_t>(layer & 0xF) << 60 | static_cast<uint64_t>(pipeline) << 44 | static_cast<uint64_t>(material) << 28 | static_cast<uint64_t>(mesh) << 12 | quantize_depth(depth);
+    }
+
+    static uint64_t make_back_to_front(uint32_t layer, float depth, uint16_t pipeline, uint16_t material, uint16_t mesh)
+    {
+        const uint64_t inverted_depth = ((1u << DEPTH_BITS) - 1) - quantize_depth(depth);
+        return static_cast<uint64_t>(layer & 0xF) << 60 | inverted_depth << 48 | static_cast<uint64_t>(pipeline) << 32 | static_cast<uint64_t>(material) << 16 | static_cast<uint64_t>(mesh);
+    }
+};
+
+struct RenderQueueItem
+{
+    uint64_t key;
+    uint32_t index; // Index of the draw in the owner's draw list
+};
+
+// Range of consecutive items of a sorted queue that can be submitted as a single instanced draw
+struct DrawBatch
+{
+    uint32_t first;
+    uint32_t count;
+};
+
+/**
+ * List of draws to sort before submission. Each record thread should use its own queue.
+ * Large queues are sorted with a LSD radix sort (bytes shared by every key are skipped), small ones with std::sort.
+ */
+class RenderQueue
+{
+public:
+    void clear()
+    {
+        queue.clear();
+    }
+
+    void reserve(size_t count)
+    {
+        queue.reserve(count);
+    }
+
+    void push(uint64_t key, uint32_t index)
+    {
+        queue.emplace_back(RenderQueueItem{key, index});
+    }
+
+    void sort();
+
+    std::span<const RenderQueueItem> items() const
+    {
+        return queue;
+    }
+
+    size_t size() const
+    {
+        return queue.size();
+    }
+
+    /**
+     * Group the consecutive items of the sorted queue whose draws can be instanced together.
+     * can_batch(a, b) receives two draw indices and should compare the real resources (keys only contain hashes).
+     */
+    template <typename Predicate> void build_batches(Predicate&& can_batch, std::vector<DrawBatch>& out_batches) const
+    {
+        for (uint32_t i = 0; i < queue.size(); ++i)
+        {
+            if (!out_batches.empty())
+            {
+                DrawBatch& last = out_batches.back();
+                if (last.first + last.count == i && can_batch(queue[last.first].index, queue[i].index))
+                {
+                    ++last.count;
+                    continue;
+                }
+            }
+            out_batches.emplace_back(DrawBatch{i, 1});
+        }
+    }
+
+private:
+    std::vector<RenderQueueItem> queue;
+    std::vector<RenderQueueItem> scratch;
+};
+
+/**
+ * Count the state changes of a draw sequence. Used to filter redundant binds during submission : each set_xxx() returns true if the state changed.
+ */
+class DrawStateTracker
+{
+public:
+    struct Stats
+    {
+        size_t draws             = 0;
+        size_t pipeline_binds    = 0;
+        size_t material_binds    = 0;
+        size_t mesh_binds        = 0;
+        size_t skipped_pipelines = 0;
+        size_t skipped_materials = 0;
+        size_t skipped_meshes    = 0;
+
+        size_t state_changes() const
+        {
+            return pipeline_binds + material_binds + mesh_binds;
+        }
+
+        size_t skipped() const
+        {
+            return skipped_pipelines + skipped_materials + skipped_meshes;
+        }
+    };
+
+    void reset()
+    {
+        pipeline = material = mesh = nullptr;
+        stats    = {};
+    }
+
+    // Changing the pipeline invalidates the material bindings (the layout could be different)
+    bool set_pipeline(const void* in_pipeline)
+    {
+        if (in_pipeline == pipeline)
+        {
+            ++stats.skipped_pipelines;
+            return false;
+        }
+        pipeline = in_pipeline;
+        material = nullptr;
+        ++stats.pipeline_binds;
+        return true;
+    }
+
+    bool set_material(const void* in_material)
+    {
+        if (in_material == material)
+        {
+            ++stats.skipped_materials;
+            return false;
+        }
+        material = in_material;
+        ++stats.material_binds;
+        return true;
+    }
+
+    bool set_mesh(const void* in_mesh)
+    {
+        if (in_mesh == mesh)
+        {
+            ++stats.skipped_meshes;
+            return false;
+        }
+        mesh = in_mesh;
+        ++stats.mesh_binds;
+        return true;
+    }
+
+    void add_draw()
+    {
+        ++stats.draws;
+    }
+
+    const Stats& get_stats() const
+    {
+        return stats;
+    }
+
+private:
+    const void* pipeline = nullptr;
+    const void* material = nullptr;
+    const void* mesh     = nullptr;
+    Stats       stats;
+};
+} // namespace Eng
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/vec3.hpp>
+
+namespace Eng
+{
+struct ShadowAtlasRequest
+{
+    float    importance; // Fraction of the atlas side wanted by the shadow map (see ShadowAtlas::screen_importance())
+    uint32_t max_size;   // Resolution of the shadow map if the atlas is not full
+};
+
+struct ShadowAtlasTile
+{
+    uint32_t x    = 0;
+    uint32_t y    = 0;
+    uint32_t size = 0; // 0 if the request did not fit in the atlas
+
+    bool is_valid() const
+    {
+        return size != 0;
+    }
+
+    bool operator==(const ShadowAtlasTile& other) const = default;
+};
+
+/**
+ * Square atlas split in power of two tiles. Tile sizes are chosen from the importance of each request, then the least important requests are
+ * downgraded until every tile fits. Tiles are placed from the largest to the smallest following a Z order curve, so the packing never leaves holes.
+ */
+class ShadowAtlas
+{
+public:
+    ShadowAtlas(uint32_t size = 4096, uint32_t min_tile_size = 128);
+
+    // Write one tile per request (same order)
+    void allocate(std::span<const ShadowAtlasRequest> requests, std::vector<ShadowAtlasTile>& out_tiles) const;
+
+    // Wanted tile size before downgrades (power of two between min_tile_size and min(max_size, size))
+    uint32_t get_tile_size(float importance, uint32_t max_size) const;
+
+    // Fraction of the screen height covered by a sphere (1 if the view is inside)
+    static float screen_importance(const glm::vec3& center, float radius, const glm::vec3& view_position, float tan_half_fov);
+
+    uint32_t get_size() const
+    {
+        return size;
+    }
+
+    uint32_t get_min_tile_size() const
+    {
+        return min_tile_size;
+    }
+
+private:
+    uint32_t size;
+    uint32_t min_tile_size;
+};
+} // namespace Eng
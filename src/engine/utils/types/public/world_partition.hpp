@@ -0,0 +1,177 @@
+#pragma once
+#include "bounds.hpp"
+
+#include <ankerl/unordered_dense.h>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <glm/vec3.hpp>
+
+namespace Eng
+{
+struct WorldCell
+{
+    int32_t  x     = 0;
+    int32_t  z     = 0;
+    uint32_t level = 0;
+
+    bool operator==(const WorldCell& other) const = default;
+};
+}
+
+template <> struct std::hash<Eng::WorldCell>
+{
+    size_t operator()(const Eng::WorldCell& cell) const noexcept
+    {
+        const uint64_t key = static_cast<uint64_t>(static_cast<uint32_t>(cell.x)) | static_cast<uint64_t>(static_cast<uint32_t>(cell.z)) << 32;
+        return std::hash<uint64_t>()(key) ^ static_cast<size_t>(cell.level) << 58;
+    }
+};
+
+namespace Eng
+{
+/**
+ * Hierarchical grid over the XZ plane (the world is not partitioned vertically).
+ * Level N cells are 2^N times larger than level 0 cells and are streamed from 2^N times farther : small objects live in the
+ * fine levels and are only loaded around the viewer, large objects live in the coarse levels and stay loaded longer.
+ * Cells are loose : an object belongs to the cell containing its center and can overflow by half a cell on each side.
+ */
+class WorldPartition
+{
+public:
+    // cell_size and streaming_distance are given for the level 0
+    WorldPartition(float in_cell_size = 64.f, uint32_t in_level_count = 4, float in_streaming_distance = 128.f);
+
+    float get_cell_size(uint32_t level) const
+    {
+        return cell_size * static_cast<float>(1u << level);
+    }
+
+    float get_streaming_distance(uint32_t level) const
+    {
+        return streaming_distance * static_cast<float>(1u << level);
+    }
+
+    uint32_t get_level_count() const
+    {
+        return level_count;
+    }
+
+    // Finest cell that can contain these bounds (objects larger than the coarsest cells are stored in the coarsest level)
+    WorldCell get_cell(const Bounds& bounds) const;
+
+    // Loose bounds of the cell (including the overflow of its objects). Height is unbounded.
+    Bounds get_cell_bounds(const WorldCell& cell) const;
+
+    // Horizontal distance between the position and the loose bounds of the cell
+    float get_distance(const WorldCell& cell, const glm::vec3& position) const;
+
+    // Append every cell (of every level) closer than its streaming distance * distance_scale, closest first
+    void collect_cells(const glm::vec3& position, std::vector<WorldCell>& out_cells, float distance_scale = 1.f) const;
+
+private:
+    float    cell_size;
+    uint32_t level_count;
+    float    streaming_distance;
+};
+
+enum class ECellState
+{
+    Unloaded,
+    Loading,
+    Loaded,
+    Merged,
+};
+
+struct WorldStreamingStats
+{
+    size_t loading              = 0;
+    size_t loaded               = 0; // Waiting to be merged
+    size_t merged               = 0;
+    size_t merged_last_update   = 0;
+    size_t unloaded_last_update = 0;
+    double last_update_ms       = 0;
+};
+
+/**
+ * Streaming state machine of a world partition. This class does not own any cell data, the work is delegated to callbacks :
+ * - load : start loading a cell in the background. finish_load() must be called once the data is ready (from any thread).
+ * - merge : insert a loaded cell into the world.
+ * - unload : remove a merged cell from the world, or discard a loaded cell that was never merged (b_merged = false).
+ * Merges and unloads happen in update() and are limited by a time budget, the closest cells are merged first.
+ * At least one operation is done per update so the streaming always progresses.
+ */
+class WorldStreamer
+{
+public:
+    struct Callbacks
+    {
+        std::function<void(const WorldCell&)>                load;
+        std::function<void(const WorldCell&)>                merge;
+        std::function<void(const WorldCell&, bool b_merged)> unload;
+    };
+
+    WorldStreamer(WorldPartition in_partition, Callbacks in_callbacks) : partition(std::move(in_partition)), callbacks(std::move(in_callbacks))
+    {
+    }
+
+    // Update the streamed cells around this position. budget_ms limits the time spent in merge and unload callbacks.
+    void update(const glm::vec3& position, double budget_ms);
+
+    // Mark a cell as ready to be merged. Thread safe.
+    void finish_load(const WorldCell& cell);
+
+    // Unload every cell. Cells still loading are discarded once their load is finished.
+    void unload_all();
+
+    // Number of loads running at the same time (the closest cells are started first)
+    void set_max_concurrent_loads(uint32_t count)
+    {
+        max_concurrent_loads = count;
+    }
+
+    // Cells are unloaded when they are farther than their streaming distance * (1 + margin). Avoid load/unload loops at cell boundaries.
+    void set_unload_margin(float margin)
+    {
+        unload_margin = margin;
+    }
+
+    ECellState get_state(const WorldCell& cell) const;
+
+    bool is_idle() const;
+
+    const WorldPartition& get_partition() const
+    {
+        return partition;
+    }
+
+    const WorldStreamingStats& get_stats() const
+    {
+        return stats;
+    }
+
+private:
+    struct CellEntry
+    {
+        ECellState state       = ECellState::Unloaded;
+        bool       b_cancelled = false; // Not wanted anymore, discard once loaded
+    };
+
+    void unload_cell(const WorldCell& cell, CellEntry& entry);
+
+    WorldPartition partition;
+    Callbacks      callbacks;
+
+    ankerl::unordered_dense::map<WorldCell, CellEntry> cells;
+    std::vector<WorldCell>                             desired;
+
+    std::mutex             finished_mtx;
+    std::vector<WorldCell> finished_loads;
+
+    uint32_t            max_concurrent_loads = 4;
+    uint32_t            loading_count        = 0;
+    float               unload_margin        = 0.1f;
+    WorldStreamingStats stats;
+};
+} // namespace Eng
@@ -86,5 +86,19 @@ int main()
     refs_A.clear();
     objects_B.clear();
 
+    // Deferred release : dropping the last ptr keeps the object alive until flush_released()
+    ContiguousObjectAllocator deferred;
+    deferred.set_deferred_release(true);
+    TObjectRef<TestReflectClass> released_ref;
+    {
+        TObjectPtr<TestReflectClass> object(deferred.allocate(TestReflectClass::static_class()));
+        object->identifier = 1;
+        released_ref       = object;
+    }
+    assert(released_ref && released_ref->identifier == 1);
+    assert(deferred.flush_released() == 1);
+    assert(!released_ref);
+    assert(deferred.flush_released() == 0);
+
     return 0;
 }
\ No newline at end of file
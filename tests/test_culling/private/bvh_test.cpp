@@ -0,0 +1,396 @@
+#include "bvh_test.hpp"
+
+#include "dynamic_bvh.hpp"
+#include "frustum_culling.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+using namespace Eng;
+
+static Bounds random_box(std::mt19937& rng, float world_size)
+{
+    std::uniform_real_distribution<float> position(-world_size, world_size);
+    std::uniform_real_distribution<float> extent(0.5f, 20.f);
+    return Bounds::from_extent({position(rng), position(rng), position(rng)}, {extent(rng), extent(rng), extent(rng)});
+}
+
+static CullingPlanes test_planes()
+{
+    return CullingPlanes::from_view_proj(glm::perspective(glm::radians(70.f), 16.f / 9.f, 0.1f, 2000.f) * glm::lookAt(glm::vec3{0, 0, 0}, glm::vec3{1, 0, 1}, glm::vec3{0, 1, 0}), true);
+}
+
+struct BvhTestData
+{
+    DynamicBvh            bvh;
+    std::vector<Bounds>   boxes;
+    std::vector<uint32_t> proxies;
+    std::vector<bool>     alive;
+};
+
+// A camera and a ring of shadow-like views
+static std::vector<CullingPlanes> test_views(size_t count)
+{
+    std::vector<CullingPlanes> views;
+    views.emplace_back(test_planes());
+    for (size_t i = 1; i < count; ++i)
+    {
+        const float     angle = static_cast<float>(i) * 0.7f;
+        const glm::vec3 eye   = glm::vec3{std::cos(angle), 0.5f, std::sin(angle)} * 300.f;
+        views.emplace_back(CullingPlanes::from_view_proj(glm::perspective(glm::radians(40.f), 1.f, 1.f, 1500.f) * glm::lookAt(eye, glm::vec3{0, 0, 0}, glm::vec3{0, 1, 0}), true));
+    }
+    return views;
+}
+
+static void check_multi_view(const DynamicBvh& bvh, size_t view_count)
+{
+    const auto                         views = test_views(view_count);
+    std::vector<std::vector<uint32_t>> results(view_count);
+    std::vector<std::vector<uint32_t>*> outputs;
+    for (auto& result : results)
+        outputs.emplace_back(&result);
+    bvh.query_frustums(views, outputs);
+
+    for (size_t v = 0; v < view_count; ++v)
+    {
+        std::vector<uint32_t> expected;
+        bvh.query_frustum(views[v], expected);
+        std::ranges::sort(expected);
+        std::ranges::sort(results[v]);
+        assert(results[v] == expected);
+    }
+}
+
+static std::vector<uint32_t> brute_force_frustum(const BvhTestData& data, const CullingPlanes& planes)
+{
+    std::vector<uint32_t> result;
+    for (uint32_t i = 0; i < data.boxes.size(); ++i)
+        if (data.alive[i] && planes.test(data.boxes[i]))
+            result.emplace_back(i);
+    return result;
+}
+
+static std::vector<uint32_t> brute_force_overlap(const BvhTestData& data, const Bounds& bounds)
+{
+    std::vector<uint32_t> result;
+    for (uint32_t i = 0; i < data.boxes.size(); ++i)
+    {
+        const Bounds& b = data.boxes[i];
+        if (data.alive[i] && b.min().x <= bounds.max().x && b.min().y <= bounds.max().y && b.min().z <= bounds.max().z && b.max().x >= bounds.min().x && b.max().y >= bounds.min().y && b.max().z >= bounds.min().z)
+            result.emplace_back(i);
+    }
+    return result;
+}
+
+static float point_box_distance(const glm::vec3& point, const Bounds& box)
+{
+    float distance = 0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float delta = std::max({box.min()[axis] - point[axis], 0.f, point[axis] - box.max()[axis]});
+        distance += delta * delta;
+    }
+    return std::sqrt(distance);
+}
+
+static void check_queries(const BvhTestData& data, std::mt19937& rng)
+{
+    const CullingPlanes   planes = test_planes();
+    std::vector<uint32_t> visible;
+    data.bvh.query_frustum(planes, visible);
+    std::ranges::sort(visible);
+    assert(visible == brute_force_frustum(data, planes));
+
+    for (int i = 0; i < 20; ++i)
+    {
+        const Bounds          area = random_box(rng, 500.f);
+        std::vector<uint32_t> overlapping;
+        data.bvh.query_overlap(Bounds::from_extent(area.center(), area.extent() * 5.f), overlapping);
+        std::ranges::sort(overlapping);
+        assert(overlapping == brute_force_overlap(data, Bounds::from_extent(area.center(), area.extent() * 5.f)));
+    }
+
+    for (int i = 0; i < 50; ++i)
+    {
+        const glm::vec3       center = random_box(rng, 1000.f).center();
+        const float           radius = i % 2 ? 30.f : 150.f;
+        std::vector<uint32_t> overlapping, expected;
+        data.bvh.query_sphere(center, radius, overlapping);
+        for (uint32_t b = 0; b < data.boxes.size(); ++b)
+            if (data.alive[b] && point_box_distance(center, data.boxes[b]) <= radius)
+                expected.emplace_back(b);
+        std::ranges::sort(overlapping);
+        assert(overlapping == expected);
+
+        // Closest box within the max distance
+        const float max_distance   = i % 2 ? 10.f : 1000.f;
+        float       best           = max_distance;
+        bool        b_expected_hit = false;
+        for (uint32_t b = 0; b < data.boxes.size(); ++b)
+            if (data.alive[b] && point_box_distance(center, data.boxes[b]) <= best)
+            {
+                best           = point_box_distance(center, data.boxes[b]);
+                b_expected_hit = true;
+            }
+        BvhRayHit  hit;
+        const bool b_hit = data.bvh.nearest(center, max_distance, hit);
+        (void)b_hit;
+        assert(b_hit == b_expected_hit);
+        assert(!b_hit || std::abs(hit.distance - best) < 0.001f);
+    }
+
+    std::uniform_real_distribution<float> dir(-1.f, 1.f);
+    for (int i = 0; i < 100; ++i)
+    {
+        const glm::vec3 origin    = random_box(rng, 500.f).center();
+        const glm::vec3 direction = glm::vec3{dir(rng), dir(rng), dir(rng)};
+
+        BvhRayHit  hit;
+        const bool b_hit = data.bvh.raycast(origin, direction, 10000.f, hit);
+
+        // Reference : closest box along the ray
+        float best = 10000.f;
+        bool  b_expected_hit = false;
+        for (uint32_t b = 0; b < data.boxes.size(); ++b)
+        {
+            if (!data.alive[b])
+                continue;
+            float t_min = 0, t_max = best;
+            bool  b_miss = false;
+            for (int axis = 0; axis < 3 && !b_miss; ++axis)
+            {
+                float t1 = (data.boxes[b].min()[axis] - origin[axis]) / direction[axis];
+                float t2 = (data.boxes[b].max()[axis] - origin[axis]) / direction[axis];
+                t_min    = std::max(t_min, std::min(t1, t2));
+                t_max    = std::min(t_max, std::max(t1, t2));
+                b_miss   = t_min > t_max;
+            }
+            if (!b_miss)
+            {
+                best           = t_min;
+                b_expected_hit = true;
+            }
+        }
+        (void)b_hit;
+        assert(b_hit == b_expected_hit);
+        assert(!b_hit || std::abs(hit.distance - best) < 0.001f);
+    }
+}
+
+void test_bvh()
+{
+    std::mt19937 rng(7);
+    BvhTestData  data;
+
+    for (uint32_t i = 0; i < 5000; ++i)
+    {
+        data.boxes.emplace_back(random_box(rng, 1000.f));
+        data.proxies.emplace_back(data.bvh.insert(data.boxes.back(), i));
+        data.alive.emplace_back(true);
+    }
+    assert(data.bvh.size() == 5000);
+    assert(data.bvh.validate());
+    // Balanced tree
+    assert(data.bvh.get_height() < 40);
+    check_queries(data, rng);
+
+    check_multi_view(data.bvh, 9);
+    // More views than a single traversal can handle
+    check_multi_view(data.bvh, DynamicBvh::MAX_QUERY_VIEWS + 4);
+
+    // Small moves stay in the fat bounds, large ones move the leaf in the tree
+    std::uniform_real_distribution<float> offset(-1.f, 1.f);
+    for (uint32_t i = 0; i < 5000; i += 3)
+    {
+        const float     scale = i % 2 ? 0.1f : 200.f;
+        const glm::vec3 delta = glm::vec3{offset(rng), offset(rng), offset(rng)} * scale;
+        data.boxes[i]         = Bounds{data.boxes[i].min() + delta, data.boxes[i].max() + delta};
+        data.bvh.update(data.proxies[i], data.boxes[i]);
+    }
+    assert(data.bvh.validate());
+    check_queries(data, rng);
+
+    for (uint32_t i = 0; i < 5000; i += 2)
+    {
+        data.bvh.remove(data.proxies[i]);
+        data.alive[i] = false;
+    }
+    assert(data.bvh.size() == 2500);
+    assert(data.bvh.validate());
+    check_queries(data, rng);
+
+    // Proxies should stay valid after a rebuild
+    data.bvh.rebuild();
+    assert(data.bvh.size() == 2500);
+    assert(data.bvh.validate());
+    check_queries(data, rng);
+    for (uint32_t i = 1; i < 5000; i += 2)
+    {
+        assert(data.bvh.get_user_data(data.proxies[i]) == i);
+        data.boxes[i] = Bounds{data.boxes[i].min() + glm::vec3{50, 0, 0}, data.boxes[i].max() + glm::vec3{50, 0, 0}};
+        data.bvh.update(data.proxies[i], data.boxes[i]);
+    }
+    assert(data.bvh.validate());
+    check_queries(data, rng);
+
+    data.bvh.clear();
+    assert(data.bvh.size() == 0 && data.bvh.validate());
+}
+
+template <typename Lambda> static double measure_ms(Lambda&& lambda)
+{
+    const auto start = std::chrono::steady_clock::now();
+    lambda();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void benchmark_bvh()
+{
+    const CullingPlanes planes = test_planes();
+    for (size_t count : {100000ull, 1000000ull})
+    {
+        std::mt19937 rng(3);
+        // Keep the same density whatever the object count
+        const float world_size = 50.f * std::cbrt(static_cast<float>(count));
+
+        std::vector<Bounds> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+            boxes.emplace_back(random_box(rng, world_size));
+
+        DynamicBvh            bvh;
+        std::vector<uint32_t> proxies(count);
+        const double          build_ms = measure_ms(
+            [&]
+            {
+                for (size_t i = 0; i < count; ++i)
+                    proxies[i] = bvh.insert(boxes[i], static_cast<uint32_t>(i));
+            });
+
+        const double rebuild_ms = measure_ms(
+            [&]
+            {
+                bvh.rebuild();
+            });
+
+        // Move 10% of the objects
+        std::uniform_real_distribution<float> offset(-5.f, 5.f);
+        const double                          update_ms = measure_ms(
+            [&]
+            {
+                for (size_t i = 0; i < count; i += 10)
+                {
+                    const glm::vec3 delta{offset(rng), offset(rng), offset(rng)};
+                    bvh.update(proxies[i], Bounds{boxes[i].min() + delta, boxes[i].max() + delta});
+                }
+            });
+
+        std::vector<uint32_t> visible;
+        const double          bvh_cull_ms = measure_ms(
+            [&]
+            {
+                bvh.query_frustum(planes, visible);
+            });
+
+        CullingBounds flat_bounds;
+        flat_bounds.reserve(count);
+        for (const auto& box : boxes)
+            flat_bounds.push(box);
+        std::vector<uint32_t> flat_visible;
+        const double          flat_cull_ms = measure_ms(
+            [&]
+            {
+                Culling::frustum_indices(planes, flat_bounds, flat_visible);
+            });
+
+        // Camera + 8 shadow views : one traversal per view versus a single traversal
+        const auto                          views = test_views(9);
+        std::vector<std::vector<uint32_t>>  view_results(views.size());
+        std::vector<std::vector<uint32_t>*> view_outputs;
+        for (auto& result : view_results)
+            view_outputs.emplace_back(&result);
+        const double separate_views_ms = measure_ms(
+            [&]
+            {
+                for (size_t v = 0; v < views.size(); ++v)
+                    bvh.query_frustum(views[v], view_results[v]);
+            });
+        for (auto& result : view_results)
+            result.clear();
+        const double multi_view_ms = measure_ms(
+            [&]
+            {
+                bvh.query_frustums(views, view_outputs);
+            });
+
+        std::uniform_real_distribution<float> dir(-1.f, 1.f);
+        size_t                                hits       = 0;
+        const double                          raycast_ms = measure_ms(
+            [&]
+            {
+                for (int i = 0; i < 10000; ++i)
+                {
+                    BvhRayHit hit;
+                    hits += bvh.raycast(glm::vec3{0, 0, 0}, glm::vec3{dir(rng), dir(rng), dir(rng)}, world_size, hit) ? 1 : 0;
+                }
+            });
+
+        // Proximity queries (gameplay "what is within 50m") : full scan against the bvh, then the same batch split between threads like Scene::query_batch()
+        constexpr size_t       QUERY_COUNT = 20000;
+        std::vector<glm::vec3> query_positions;
+        for (size_t i = 0; i < QUERY_COUNT; ++i)
+            query_positions.emplace_back(random_box(rng, world_size).center());
+
+        size_t       scan_found = 0;
+        const double scan_ms    = measure_ms(
+            [&]
+            {
+                for (size_t i = 0; i < 10; ++i)
+                    for (const auto& box : boxes)
+                        scan_found += point_box_distance(query_positions[i], box) <= 50.f ? 1 : 0;
+            }) / 10.0 * QUERY_COUNT;
+
+        std::vector<size_t> found_per_query(QUERY_COUNT);
+        const auto          run_queries = [&](size_t first, size_t last)
+        {
+            thread_local std::vector<uint32_t> found;
+            for (size_t i = first; i < last; ++i)
+            {
+                found.clear();
+                bvh.query_sphere(query_positions[i], 50.f, found);
+                BvhRayHit hit;
+                bvh.nearest(query_positions[i], 100.f, hit);
+                found_per_query[i] = found.size();
+            }
+        };
+        const double sphere_ms = measure_ms(
+            [&]
+            {
+                run_queries(0, QUERY_COUNT);
+            });
+        const size_t thread_count     = std::max(1u, std::thread::hardware_concurrency());
+        const double batched_query_ms = measure_ms(
+            [&]
+            {
+                std::vector<std::thread> threads;
+                for (size_t t = 0; t < thread_count; ++t)
+                    threads.emplace_back(run_queries, QUERY_COUNT * t / thread_count, QUERY_COUNT * (t + 1) / thread_count);
+                for (auto& thread : threads)
+                    thread.join();
+            });
+
+        std::cout << "bvh " << count << " objects : build " << build_ms << "ms, rebuild " << rebuild_ms << "ms, update 10% " << update_ms << "ms, height " << bvh.get_height() << std::endl;
+        std::cout << "    frustum : bvh " << bvh_cull_ms << "ms / flat " << flat_cull_ms << "ms (" << visible.size() << " visible)" << std::endl;
+        std::cout << "    9 views : separate " << separate_views_ms << "ms / single traversal " << multi_view_ms << "ms" << std::endl;
+        std::cout << "    10k raycasts : " << raycast_ms << "ms (" << hits << " hits)" << std::endl;
+        std::cout << "    " << QUERY_COUNT << " sphere + nearest queries : full scan ~" << scan_ms << "ms (estimated) / bvh " << sphere_ms << "ms / bvh on " << thread_count << " threads " << batched_query_ms << "ms" << std::endl;
+        (void)scan_found;
+    }
+}
@@ -0,0 +1,153 @@
+#include "bvh_test.hpp"
+#include "frustum_culling.hpp"
+#include "logger.hpp"
+#include "occlusion_test.hpp"
+
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+using namespace Eng;
+
+static const char* simd_name(ECullingSimd simd)
+{
+    switch (simd)
+    {
+    case ECullingSimd::Scalar:
+        return "scalar";
+    case ECullingSimd::Sse4:
+        return "sse4";
+    case ECullingSimd::Avx2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+static CullingBounds random_bounds(size_t count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> position(-500.f, 500.f);
+    std::uniform_real_distribution<float> extent(0.1f, 10.f);
+
+    CullingBounds bounds;
+    bounds.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        bounds.push(glm::vec3{position(rng), position(rng), position(rng)}, glm::vec3{extent(rng), extent(rng), extent(rng)});
+    return bounds;
+}
+
+static void test_simd_matches_scalar(const CullingPlanes& planes)
+{
+    std::mt19937 rng(42);
+    // Odd sizes to check the padding and the last mask word
+    for (size_t count : {0ull, 1ull, 7ull, 63ull, 64ull, 65ull, 1000ull, 4099ull})
+    {
+        CullingBounds bounds = random_bounds(count, rng);
+
+        std::vector<uint64_t> reference(Culling::mask_word_count(count));
+        Culling::frustum_mask(planes, bounds, reference, ECullingSimd::Scalar);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const bool visible = planes.test({bounds.center_x[i], bounds.center_y[i], bounds.center_z[i]}, {bounds.half_extent_x[i], bounds.half_extent_y[i], bounds.half_extent_z[i]});
+            (void)visible;
+            assert(((reference[i / 64] >> (i % 64)) & 1) == (visible ? 1u : 0u));
+        }
+        if (count % 64 != 0)
+        {
+            assert((reference.back() >> (count % 64)) == 0);
+        }
+
+        for (auto simd : {ECullingSimd::Sse4, ECullingSimd::Avx2})
+        {
+            std::vector<uint64_t> mask(Culling::mask_word_count(count));
+            Culling::frustum_mask(planes, bounds, mask, simd);
+            assert(mask == reference);
+
+            std::vector<uint32_t> indices;
+            const size_t          visible_count = Culling::frustum_indices(planes, bounds, indices, simd);
+            (void)visible_count;
+            assert(visible_count == indices.size());
+            size_t expected = 0;
+            for (const auto& word : reference)
+                expected += std::popcount(word);
+            assert(visible_count == expected);
+            for (const auto& index : indices)
+            {
+                (void)index;
+                assert((reference[index / 64] >> (index % 64)) & 1);
+            }
+        }
+    }
+}
+
+static void test_known_boxes(const CullingPlanes& planes)
+{
+    // Camera at the origin looking toward +Z
+    CullingBounds bounds;
+    const size_t  in_front = bounds.push(glm::vec3{0, 0, 10}, glm::vec3{1, 1, 1});
+    const size_t  behind   = bounds.push(glm::vec3{0, 0, -10}, glm::vec3{1, 1, 1});
+    const size_t  left     = bounds.push(glm::vec3{-100, 0, 10}, glm::vec3{1, 1, 1});
+    const size_t  crossing = bounds.push(glm::vec3{0, 0, 0}, glm::vec3{5, 5, 5});
+
+    std::vector<uint32_t> indices;
+    Culling::frustum_indices(planes, bounds, indices);
+    assert(indices.size() == 2);
+    assert(indices[0] == in_front);
+    assert(indices[1] == crossing);
+    (void)behind;
+    (void)left;
+}
+
+static void benchmark(const CullingPlanes& planes)
+{
+    constexpr size_t BOX_COUNT = 1000000;
+    constexpr int    ITERATIONS = 20;
+
+    std::mt19937  rng(1);
+    CullingBounds bounds = random_bounds(BOX_COUNT, rng);
+
+    std::vector<uint64_t> mask(Culling::mask_word_count(BOX_COUNT));
+    for (auto simd : {ECullingSimd::Scalar, ECullingSimd::Sse4, ECullingSimd::Avx2})
+    {
+        if (simd > Culling::best_simd_level())
+        {
+            std::cout << simd_name(simd) << " : not supported" << std::endl;
+            continue;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; ++i)
+            Culling::frustum_mask(planes, bounds, mask, simd);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t visible = 0;
+        for (const auto& word : mask)
+            visible += std::popcount(word);
+
+        std::cout << simd_name(simd) << " : " << static_cast<double>(BOX_COUNT) * ITERATIONS / seconds / 1000000.0 << " Mboxes/s (" << visible << " visible / " << BOX_COUNT << ")" << std::endl;
+    }
+}
+
+int main()
+{
+    Logger::get().enable_logs(Logger::LOG_LEVEL_DEBUG | Logger::LOG_LEVEL_ERROR | Logger::LOG_LEVEL_FATAL | Logger::LOG_LEVEL_INFO | Logger::LOG_LEVEL_WARNING);
+
+    const glm::mat4     view_proj = glm::perspective(glm::radians(70.f), 16.f / 9.f, 0.1f, 1000.f) * glm::lookAt(glm::vec3{0, 0, 0}, glm::vec3{0, 0, 1}, glm::vec3{0, 1, 0});
+    const CullingPlanes planes    = CullingPlanes::from_view_proj(view_proj, true);
+
+    std::cout << "best culling kernel : " << simd_name(Culling::best_simd_level()) << std::endl;
+
+    test_known_boxes(planes);
+    test_simd_matches_scalar(planes);
+    benchmark(planes);
+
+    test_bvh();
+    benchmark_bvh();
+
+    test_occlusion();
+    benchmark_occlusion();
+}
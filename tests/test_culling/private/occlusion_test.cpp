@@ -0,0 +1,267 @@
+#include "occlusion_test.hpp"
+
+#include "occlusion_buffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+using namespace Eng;
+
+static const glm::uvec2 RESOLUTION = {256, 128};
+
+static glm::mat4 test_view_proj()
+{
+    return glm::perspective(glm::radians(90.f), 2.f, 1.f, 1000.f) * glm::lookAt(glm::vec3{0, 0, 0}, glm::vec3{0, 0, 1}, glm::vec3{0, 1, 0});
+}
+
+// Quad facing the camera at the given distance
+static void add_wall(OcclusionBuffer& buffer, const glm::vec2& min, const glm::vec2& max, float distance)
+{
+    const glm::vec3 vertices[] = {{min.x, min.y, distance}, {max.x, min.y, distance}, {max.x, max.y, distance}, {min.x, max.y, distance}};
+    const uint32_t  indices[]  = {0, 1, 2, 0, 2, 3};
+    buffer.add_occluder(vertices, indices, glm::mat4(1));
+}
+
+// Expected depth buffer : pixels fully inside the projected rectangle get the projected depth of the wall
+static std::vector<float> reference_walls(const glm::mat4& view_proj, const std::vector<std::pair<glm::vec4, float>>& walls)
+{
+    std::vector<float> reference(RESOLUTION.x * RESOLUTION.y, 1.f);
+    for (const auto& [rect, distance] : walls)
+    {
+        const glm::vec4 a     = view_proj * glm::vec4(rect.x, rect.y, distance, 1);
+        const glm::vec4 b     = view_proj * glm::vec4(rect.z, rect.w, distance, 1);
+        const float     min_x = (std::min(a.x / a.w, b.x / b.w) * 0.5f + 0.5f) * RESOLUTION.x;
+        const float     max_x = (std::max(a.x / a.w, b.x / b.w) * 0.5f + 0.5f) * RESOLUTION.x;
+        const float     min_y = (std::min(a.y / a.w, b.y / b.w) * 0.5f + 0.5f) * RESOLUTION.y;
+        const float     max_y = (std::max(a.y / a.w, b.y / b.w) * 0.5f + 0.5f) * RESOLUTION.y;
+        const float     depth = a.z / a.w;
+        for (uint32_t y = 0; y < RESOLUTION.y; ++y)
+            for (uint32_t x = 0; x < RESOLUTION.x; ++x)
+            {
+                if (x >= min_x && x + 1 <= max_x && y >= min_y && y + 1 <= max_y)
+                    reference[y * RESOLUTION.x + x] = std::min(reference[y * RESOLUTION.x + x], depth);
+            }
+    }
+    return reference;
+}
+
+static void test_reference_depth()
+{
+    const glm::mat4 view_proj = test_view_proj();
+    OcclusionBuffer buffer;
+    buffer.begin(view_proj, RESOLUTION);
+    // Walls are placed to avoid pixel borders lying exactly on an edge
+    add_wall(buffer, {-10.3f, -5.2f}, {4.1f, 3.3f}, 20.f);
+    add_wall(buffer, {-1.1f, -20.7f}, {30.2f, 1.3f}, 10.f);
+    buffer.rasterize();
+
+    const auto reference = reference_walls(view_proj, {{{-10.3f, -5.2f, 4.1f, 3.3f}, 20.f}, {{-1.1f, -20.7f, 30.2f, 1.3f}, 10.f}});
+    for (size_t i = 0; i < reference.size(); ++i)
+    {
+        (void)i;
+        assert(std::abs(buffer.get_depth_buffer()[i] - reference[i]) < 0.0001f);
+    }
+}
+
+static void test_occlusion_queries()
+{
+    const glm::mat4 view_proj = test_view_proj();
+    OcclusionBuffer buffer;
+    buffer.begin(view_proj, RESOLUTION);
+    add_wall(buffer, {-10, -10}, {10, 10}, 20.f);
+    buffer.rasterize();
+
+    // Behind the wall
+    assert(!buffer.test(Bounds({-2, -2, 30}, {2, 2, 34})));
+    // In front of the wall
+    assert(buffer.test(Bounds({-2, -2, 10}, {2, 2, 14})));
+    // Crossing the wall
+    assert(buffer.test(Bounds({-2, -2, 18}, {2, 2, 22})));
+    // Behind the wall but visible on a side
+    assert(buffer.test(Bounds({12, -2, 30}, {40, 2, 34})));
+    // Crossing the near plane
+    assert(buffer.test(Bounds({-2, -2, -5}, {2, 2, 30})));
+
+    // Empty buffer never occludes
+    buffer.begin(view_proj, RESOLUTION);
+    buffer.rasterize();
+    assert(buffer.test(Bounds({-2, -2, 30}, {2, 2, 34})));
+}
+
+static void test_occluder_selection()
+{
+    // Imported wall : two triangles, selected as its own occluder
+    const std::vector<glm::vec3> wall_vertices = {{-10, -10, 0}, {10, -10, 0}, {10, 10, 0}, {-10, 10, 0}};
+    const std::vector<uint32_t>  wall_indices  = {0, 1, 2, 0, 2, 3};
+    Bounds                       wall_bounds;
+    for (const auto& vertex : wall_vertices)
+        wall_bounds.add_point(vertex);
+    assert(OcclusionBuffer::is_occluder_candidate(wall_bounds, wall_indices.size() / 3));
+
+    // Too small, too thin or too detailed meshes are not selected
+    assert(!OcclusionBuffer::is_occluder_candidate(Bounds({-0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, 0.5f}), 12));
+    assert(!OcclusionBuffer::is_occluder_candidate(Bounds({-0.1f, 0, -0.1f}, {0.1f, 50, 0.1f}), 12));
+    assert(!OcclusionBuffer::is_occluder_candidate(wall_bounds, OcclusionBuffer::OCCLUDER_MAX_TRIANGLES + 1));
+    assert(!OcclusionBuffer::is_occluder_candidate(wall_bounds, 0));
+
+    // The wall placed 20 units in front of the camera hides a mesh standing behind it
+    const glm::mat4 wall_transform = glm::translate(glm::mat4(1), glm::vec3{0, 0, 20});
+    const Bounds    hidden_mesh({-2, -2, 30}, {2, 2, 34});
+    const Bounds    visible_mesh({-2, -2, 10}, {2, 2, 14});
+
+    OcclusionBuffer buffer;
+    buffer.begin(test_view_proj(), RESOLUTION);
+    buffer.add_occluder(wall_vertices, wall_indices, wall_transform);
+    buffer.rasterize();
+    assert(!buffer.test(hidden_mesh));
+    assert(buffer.test(visible_mesh));
+}
+
+static glm::vec3 project_pixel(const glm::mat4& view_proj, const glm::vec3& position)
+{
+    const glm::vec4 clip = view_proj * glm::vec4(position, 1);
+    return {(clip.x / clip.w * 0.5f + 0.5f) * RESOLUTION.x, (clip.y / clip.w * 0.5f + 0.5f) * RESOLUTION.y, clip.z / clip.w};
+}
+
+static void test_conservative_coverage()
+{
+    const glm::mat4 view_proj = test_view_proj();
+
+    // The right side of the wall ends in the middle of a column : a small mesh behind this column, but not behind the wall, is visible
+    OcclusionBuffer buffer;
+    buffer.begin(view_proj, RESOLUTION);
+    const float wall_right = (100.7f - RESOLUTION.x * 0.5f) * 20.f / 64.f;
+    add_wall(buffer, {-30, -10}, {wall_right, 10}, 20.f);
+    buffer.rasterize();
+    const float column_min = (100.75f - RESOLUTION.x * 0.5f) * 30.f / 64.f;
+    const float column_max = (100.95f - RESOLUTION.x * 0.5f) * 30.f / 64.f;
+    assert(static_cast<int32_t>(project_pixel(view_proj, {column_min, 0, 30}).x) == 100 && static_cast<int32_t>(project_pixel(view_proj, {column_max, 0, 30}).x) == 100);
+    assert(buffer.test(Bounds({column_min, -1, 30}, {column_max, 1, 30.01f})));
+    assert(!buffer.test(Bounds({column_min - 2, -1, 30}, {column_max - 2, 1, 30.01f})));
+
+    // Single sloped triangles : every written pixel is inside the triangle, and not closer than the triangle anywhere in this pixel
+    std::mt19937                          rng(3);
+    std::uniform_real_distribution<float> position(-20.f, 20.f);
+    std::uniform_real_distribution<float> distance(5.f, 50.f);
+    for (int i = 0; i < 50; ++i)
+    {
+        const glm::vec3 vertices[] = {{position(rng), position(rng), distance(rng)}, {position(rng), position(rng), distance(rng)}, {position(rng), position(rng), distance(rng)}};
+        const uint32_t  indices[]  = {0, 1, 2};
+        buffer.begin(view_proj, RESOLUTION);
+        buffer.add_occluder(vertices, indices, glm::mat4(1));
+        buffer.rasterize();
+
+        glm::vec3 p0 = project_pixel(view_proj, vertices[0]), p1 = project_pixel(view_proj, vertices[1]), p2 = project_pixel(view_proj, vertices[2]);
+        float     area = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+        if (area < 0)
+        {
+            std::swap(p1, p2);
+            area = -area;
+        }
+        for (uint32_t y = 0; y < RESOLUTION.y; ++y)
+            for (uint32_t x = 0; x < RESOLUTION.x; ++x)
+            {
+                if (buffer.get_depth(x, y) >= 1.f)
+                    continue;
+                for (int corner = 0; corner < 4; ++corner)
+                {
+                    const glm::vec2 p{static_cast<float>(x + (corner & 1)), static_cast<float>(y + (corner >> 1))};
+                    // Barycentric coordinates of the corner
+                    const float w1 = ((p.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p.y - p0.y)) / area;
+                    const float w2 = ((p1.x - p0.x) * (p.y - p0.y) - (p.x - p0.x) * (p1.y - p0.y)) / area;
+                    assert(w1 >= -0.001f && w2 >= -0.001f && w1 + w2 <= 1.001f);
+                    assert(buffer.get_depth(x, y) >= p0.z + w1 * (p1.z - p0.z) + w2 * (p2.z - p0.z) - 0.0001f);
+                }
+            }
+    }
+}
+
+static void add_random_occluders(OcclusionBuffer& buffer, size_t count)
+{
+    std::mt19937                          rng(5);
+    std::uniform_real_distribution<float> position(-200.f, 200.f);
+    std::uniform_real_distribution<float> distance(5.f, 500.f);
+    std::uniform_real_distribution<float> size(1.f, 30.f);
+    // Boxes made of 12 triangles
+    const uint32_t indices[] = {0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1, 2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3};
+    for (size_t i = 0; i < count; ++i)
+    {
+        const glm::vec3 center{position(rng), position(rng) * 0.5f, distance(rng)};
+        const glm::vec3 half{size(rng), size(rng), size(rng)};
+        glm::vec3       vertices[8];
+        for (int c = 0; c < 8; ++c)
+            vertices[c] = center + glm::vec3{c & 1 ? half.x : -half.x, c & 2 ? half.y : -half.y, c & 4 ? half.z : -half.z};
+        buffer.add_occluder(vertices, indices, glm::mat4(1));
+    }
+}
+
+static void test_determinism()
+{
+    const glm::mat4 view_proj = test_view_proj();
+
+    OcclusionBuffer serial;
+    serial.begin(view_proj, RESOLUTION);
+    add_random_occluders(serial, 500);
+    serial.rasterize();
+
+    // Bands rasterized concurrently in reverse order should produce the exact same buffer
+    OcclusionBuffer parallel;
+    parallel.begin(view_proj, RESOLUTION);
+    add_random_occluders(parallel, 500);
+    std::vector<std::thread> threads;
+    for (uint32_t band = parallel.band_count(); band-- > 0;)
+        threads.emplace_back(
+            [&parallel, band]
+            {
+                parallel.rasterize_band(band);
+            });
+    for (auto& thread : threads)
+        thread.join();
+
+    assert(serial.get_depth_buffer() == parallel.get_depth_buffer());
+}
+
+void test_occlusion()
+{
+    test_reference_depth();
+    test_occlusion_queries();
+    test_conservative_coverage();
+    test_occluder_selection();
+    test_determinism();
+}
+
+void benchmark_occlusion()
+{
+    const glm::mat4 view_proj = test_view_proj();
+    OcclusionBuffer buffer;
+
+    auto start = std::chrono::steady_clock::now();
+    buffer.begin(view_proj, RESOLUTION);
+    add_random_occluders(buffer, 2000);
+    const double setup_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    buffer.rasterize();
+    const double raster_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::mt19937                          rng(9);
+    std::uniform_real_distribution<float> position(-200.f, 200.f);
+    std::uniform_real_distribution<float> distance(5.f, 800.f);
+    size_t                                occluded = 0;
+    start                                          = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100000; ++i)
+    {
+        const glm::vec3 center{position(rng), position(rng) * 0.5f, distance(rng)};
+        occluded += buffer.test(Bounds::from_extent(center, {4, 4, 4})) ? 0 : 1;
+    }
+    const double test_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "occlusion " << RESOLUTION.x << "x" << RESOLUTION.y << " : " << buffer.polygon_count() << " polygons, setup " << setup_ms << "ms, raster " << raster_ms << "ms, 100k tests " << test_ms << "ms (" << occluded << " occluded)"
+              << std::endl;
+}
@@ -0,0 +1,10 @@
+declare_module(
+    "test_culling", 
+    {
+        deps = {"types"},
+        is_executable = true
+    }
+)
+
+target("test_culling")
+    set_group("test")
@@ -5,6 +5,8 @@
 #include "assets/sampler_asset.hpp"
 #include "config.hpp"
 #include "engine.hpp"
+#include "light_clusters.hpp"
+#include "profiler.hpp"
 #include "spinlock.hpp"
 #include "gfx/renderer/definition/renderer.hpp"
 #include "gfx/renderer/instance/render_pass_instance.hpp"
@@ -17,6 +19,7 @@
 #include "scene/components/camera_component.hpp"
 #include "scene/components/mesh_component.hpp"
 #include "scene/scene.hpp"
+#include "scene/scene_shadows.hpp"
 #include "scene/scene_view.hpp"
 #include "scene/components/directional_light_component.hpp"
 #include "widgets/content_browser.hpp"
@@ -39,12 +42,23 @@ public:
 
     void pre_draw(const Gfx::RenderPassInstanceBase& rp) override
     {
-        scene->get_active_camera()->get_view().pre_draw(rp);
+        scene->get_active_camera()->get_view().pre_draw(*scene, rp);
+    }
+
+    // The draws are only recorded again when the camera or the visible meshes changed
+    uint64_t get_content_signature(const Gfx::RenderPassInstanceBase&) override
+    {
+        return scene->get_active_camera()->get_view().get_content_signature();
+    }
+
+    std::optional<size_t> get_draw_count(const Gfx::RenderPassInstanceBase&) override
+    {
+        return scene->get_active_camera()->get_view().get_visible_count();
     }
 
     void draw(const Gfx::RenderPassInstanceBase& rp, Gfx::CommandBuffer& command_buffer, size_t thread_index) override
     {
-        scene->get_active_camera()->get_view().draw(*scene, rp, command_buffer, thread_index, record_threads());
+        scene->get_active_camera()->get_view().draw(*scene, rp, command_buffer, thread_index, rp.get_record_jobs());
     }
 
     size_t record_threads() override
@@ -65,9 +79,13 @@ class GBufferResolveInterface : public Gfx::IRenderPass
 public:
     GBufferResolveInterface(const std::shared_ptr<Scene>& in_scene) : scene(in_scene)
     {
-        light_buffer = Gfx::Buffer::create("light_buffer", Engine::get().get_device(), Gfx::Buffer::CreateInfos{.usage = Gfx::EBufferUsage::GPU_MEMORY, .type = Gfx::EBufferType::IMMEDIATE}, sizeof(Light), 1);
+        light_buffer          = Gfx::Buffer::create("light_buffer", Engine::get().get_device(), Gfx::Buffer::CreateInfos{.usage = Gfx::EBufferUsage::GPU_MEMORY, .type = Gfx::EBufferType::IMMEDIATE}, sizeof(Light), 1);
+        cluster_params        = Gfx::Buffer::create("cluster_params", Engine::get().get_device(), Gfx::Buffer::CreateInfos{.usage = Gfx::EBufferUsage::GPU_MEMORY, .type = Gfx::EBufferType::IMMEDIATE}, sizeof(ClusterParams), 1);
+        cluster_ranges        = Gfx::Buffer::create("cluster_ranges", Engine::get().get_device(), Gfx::Buffer::CreateInfos{.usage = Gfx::EBufferUsage::GPU_MEMORY, .type = Gfx::EBufferType::IMMEDIATE}, sizeof(LightClusterRange), clusters.cluster_count());
+        cluster_light_indices = Gfx::Buffer::create("cluster_light_indices", Engine::get().get_device(), Gfx::Buffer::CreateInfos{.usage = Gfx::EBufferUsage::GPU_MEMORY, .type = Gfx::EBufferType::IMMEDIATE}, sizeof(uint32_t), 1);
     }
 
+    // Type 0 : point light, type 1 : directional light
     struct Light
     {
         glm::mat4 shadow_matrix;
@@ -75,6 +93,24 @@ public:
         alignas(8) glm::vec3 pos;
         alignas(4) uint32_t  has_shadows;
         alignas(4) uint32_t type;
+        alignas(4) float    radius;
+        alignas(16) glm::vec4 shadow_rect; // Tile of the shadow atlases (uv offset and scale)
+    };
+
+    struct ClusterParams
+    {
+        glm::vec3 position;
+        float     tan_half_width;
+        glm::vec3 forward;
+        float     tan_half_height;
+        glm::vec3 right;
+        float     z_near;
+        glm::vec3 up;
+        float     z_far;
+        uint32_t  tiles_x;
+        uint32_t  tiles_y;
+        uint32_t  slices;
+        uint32_t  global_light_count;
     };
 
     void init(const Gfx::RenderPassInstanceBase&) override
@@ -105,38 +141,91 @@ public:
     void pre_draw(const Gfx::RenderPassInstanceBase& render_pass) override
     {
         lights.clear();
-        std::vector<std::shared_ptr<Gfx::ImageView>> shadow_maps;
         scene->for_each<LightComponent>(
             [&](const LightComponent& comp)
             {
-                if (comp.get_shadow_pass())
+                if (comp.has_shadows() && comp.get_shadow_tile().is_valid())
                 {
-                    auto resource = comp.get_shadow_pass()->get_image_resource("depth");
-
-                    if (!resource.lock())
-                    {
-                        LOG_WARNING("bah ?");
-                        return;
-                    }
-                    auto light_mat = comp.get_shadow_view()->get_projection_view_matrix();
-                    lights.emplace_back(light_mat, comp.get_relative_rotation() * glm::vec3{-1, 0, 0}, comp.get_relative_position(), 1, 1);
+                    const ShadowAtlasTile& tile      = comp.get_shadow_tile();
+                    const glm::vec4        rect      = glm::vec4{tile.x, tile.y, tile.size, tile.size} / static_cast<float>(SceneShadows::ATLAS_SIZE);
+                    auto                   light_mat = comp.get_shadow_view()->get_projection_view_matrix();
+                    lights.emplace_back(light_mat, comp.get_relative_rotation() * glm::vec3{-1, 0, 0}, comp.get_relative_position(), 1, 1, 0.f, rect);
+                }
+            });
 
-                    shadow_maps.emplace_back(resource);
+        scene->for_each<LightComponent>(
+            [&](const LightComponent& comp)
+            {
+                // Lights without a shadow tile (atlas full) are still lit
+                if ((!comp.has_shadows() || !comp.get_shadow_tile().is_valid()) && comp.get_attenuation_radius() <= 0)
+                {
+                    lights.emplace_back(glm::identity<glm::mat4>(), comp.get_relative_rotation() * glm::vec3{-1, 0, 0}, comp.get_relative_position(), 0, 1, 0.f, glm::vec4{0});
                 }
             });
 
+        // Lights with a limited range are only evaluated by the pixels of the clusters they touch
+        const uint32_t global_light_count = static_cast<uint32_t>(lights.size());
+        local_lights.clear();
         scene->for_each<LightComponent>(
             [&](const LightComponent& comp)
             {
-                if (!comp.get_shadow_pass())
+                if ((!comp.has_shadows() || !comp.get_shadow_tile().is_valid()) && comp.get_attenuation_radius() > 0)
                 {
-                    lights.emplace_back(glm::identity<glm::mat4>(), comp.get_relative_rotation() * glm::vec3{-1, 0, 0}, comp.get_relative_position(), 0, 1);
+                    lights.emplace_back(glm::identity<glm::mat4>(), comp.get_relative_rotation() * glm::vec3{-1, 0, 0}, comp.get_relative_position(), 0, 0, comp.get_attenuation_radius(), glm::vec4{0});
+                    local_lights.emplace_back(comp.get_relative_position(), comp.get_attenuation_radius());
                 }
             });
 
+        {
+            PROFILER_SCOPE_NAMED(AssignLightClusters, "Assign light clusters");
+            const LightClusterView view = scene->get_active_camera()->get_view().get_light_cluster_view();
+            clusters.begin(view, local_lights);
+            if (!local_lights.empty())
+            {
+                std::vector<JobHandle<void>> jobs;
+                for (uint32_t slice = 0; slice < clusters.slice_count(); ++slice)
+                    jobs.emplace_back(JobSystem::get().schedule(
+                        [this, slice]
+                        {
+                            clusters.assign_slice(slice);
+                        }));
+                for (const auto& job : jobs)
+                    job.await();
+            }
+            clusters.finalize();
+
+            cluster_params->set_data(0, Gfx::BufferData{ClusterParams{.position           = view.position,
+                                                                      .tan_half_width     = view.tan_half_width,
+                                                                      .forward            = view.forward,
+                                                                      .tan_half_height    = view.tan_half_height,
+                                                                      .right              = view.right,
+                                                                      .z_near             = view.z_near,
+                                                                      .up                 = view.up,
+                                                                      .z_far              = view.z_far,
+                                                                      .tiles_x            = clusters.get_tiles_x(),
+                                                                      .tiles_y            = clusters.get_tiles_y(),
+                                                                      .slices             = clusters.slice_count(),
+                                                                      .global_light_count = global_light_count}});
+            cluster_ranges->set_data(0, Gfx::BufferData(clusters.get_ranges()));
+            // Empty buffers cannot be bound
+            if (clusters.get_light_indices().empty())
+                cluster_light_indices->set_data(0, Gfx::BufferData{0u});
+            else
+                cluster_light_indices->set_data(0, Gfx::BufferData(clusters.get_light_indices()));
+        }
+
         auto desc_resource = material->get_descriptor_resource(render_pass.get_definition().render_pass_ref);
-        if (!shadow_maps.empty())
-            desc_resource->bind_images("shadow_maps", shadow_maps);
+        const SceneShadows& shadows = scene->get_shadows();
+        if (shadows.get_atlas_pass())
+        {
+            auto atlas         = shadows.get_atlas_pass()->get_image_resource("depth").lock();
+            auto dynamic_atlas = shadows.get_dynamic_atlas_pass()->get_image_resource("depth").lock();
+            if (atlas && dynamic_atlas)
+            {
+                desc_resource->bind_image("shadow_atlas", atlas);
+                desc_resource->bind_image("dynamic_shadow_atlas", dynamic_atlas);
+            }
+        }
         light_buffer->set_data(0, Gfx::BufferData(lights));
     }
 
@@ -148,6 +237,9 @@ public:
 
         auto desc_resource = material->get_descriptor_resource(render_pass.get_definition().render_pass_ref);
         desc_resource->bind_buffer("light_buffer", light_buffer);
+        desc_resource->bind_buffer("cluster_params", cluster_params);
+        desc_resource->bind_buffer("cluster_ranges", cluster_ranges);
+        desc_resource->bind_buffer("cluster_light_indices", cluster_light_indices);
         desc_resource->bind_buffer("scene_data_buffer", scene->get_active_camera()->get_view().get_view_buffer());
 
         struct PcData
@@ -168,14 +260,22 @@ public:
     void pre_submit(const Gfx::RenderPassInstanceBase&) override
     {
         light_buffer->wait_data_upload();
+        cluster_params->wait_data_upload();
+        cluster_ranges->wait_data_upload();
+        cluster_light_indices->wait_data_upload();
     }
 
-    std::vector<Light> lights;
+    std::vector<Light>        lights;
+    std::vector<ClusterLight> local_lights;
+    LightClusters             clusters;
 
     TObjectRef<MaterialInstanceAsset> material;
     TObjectRef<SamplerAsset>          sampler;
     std::shared_ptr<Scene>            scene;
     std::shared_ptr<Gfx::Buffer>      light_buffer;
+    std::shared_ptr<Gfx::Buffer>      cluster_params;
+    std::shared_ptr<Gfx::Buffer>      cluster_ranges;
+    std::shared_ptr<Gfx::Buffer>      cluster_light_indices;
 };
 
 
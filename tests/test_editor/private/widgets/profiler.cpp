@@ -99,6 +99,10 @@ void ProfilerWindow::DisplayData::build(const Profiler::FrameWrapper& profiler_f
             if (thread.min < global_min)
                 global_min = thread.min;
         }
+
+        // The render passes executed by the gpu are displayed as an additional thread
+        for (const auto& event : frame->gpu_events)
+            all_events.emplace(std::thread::id{}, std::vector<Profiler::ProfilerEvent>{}).first->second.emplace_back(event);
     }
 
     // Sort events by start time
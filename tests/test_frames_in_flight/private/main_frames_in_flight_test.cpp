@@ -0,0 +1,162 @@
+#include "deferred_release.hpp"
+#include "frames_in_flight.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace Eng;
+
+// Frames the simulated gpu finished (every frame before this one)
+static int64_t completed_frames = 0;
+static int64_t destroyed        = 0;
+
+class Resource;
+static DeferredRelease<std::shared_ptr<Resource>>* pending_kill = nullptr;
+
+// Gpu resource that must not be destroyed before the last frame using it is finished
+class Resource
+{
+public:
+    ~Resource()
+    {
+        assert(last_use < completed_frames);
+        ++destroyed;
+        // Destroying a resource can release the resources it owns
+        if (owned)
+            pending_kill->release(std::move(owned), slot);
+    }
+
+    int64_t                   last_use = -1;
+    size_t                    slot     = 0;
+    std::shared_ptr<Resource> owned;
+};
+
+// Sizes used by the device and the swapchain
+static void test_ring_sizes(uint8_t frames_in_flight)
+{
+    // Device image count, image available semaphores and render finished fences
+    assert(FramesInFlight::ring_size(frames_in_flight) == frames_in_flight);
+
+    // One more image than the frames in flight, within the limits of the surface
+    assert(FramesInFlight::swapchain_image_count(frames_in_flight, 0, 0) == frames_in_flight + 1u);
+    assert(FramesInFlight::swapchain_image_count(frames_in_flight, 2, 8) == frames_in_flight + 1u);
+    assert(FramesInFlight::swapchain_image_count(frames_in_flight, 4, 0) == std::max(frames_in_flight + 1u, 4u));
+    assert(FramesInFlight::swapchain_image_count(frames_in_flight, 1, 2) == 2);
+}
+
+/**
+ * Same loop as Swapchain::render_internal() : the fence of the frame slot is waited, then an image is acquired with the semaphore of this slot. The
+ * presentation engine gives the images back in order and keeps the last presented one.
+ */
+static void test_swapchain_loop(uint8_t frames_in_flight)
+{
+    const uint8_t  ring_size   = FramesInFlight::ring_size(frames_in_flight);
+    const uint32_t image_count = FramesInFlight::swapchain_image_count(frames_in_flight, 0, 0);
+
+    std::vector<int64_t> fences(ring_size, -1);          // Last frame submitted with the fence of each slot
+    std::vector<int64_t> image_available(ring_size, -1); // Last frame that waited for the semaphore of each slot
+    std::vector<int64_t> image_users(image_count, -1);   // Last frame rendered in each image
+    int64_t              completed = 0;                  // Every frame before this one is done
+
+    for (int64_t frame = 0; frame < 100; ++frame)
+    {
+        const size_t slot = frame % ring_size;
+
+        // The gpu finished the previous frame of this slot : its semaphore can be signaled again
+        completed = std::max(completed, fences[slot] + 1);
+        assert(image_available[slot] < completed);
+
+        // The acquired image is neither presented nor rendered by a frame in flight
+        const uint32_t image = static_cast<uint32_t>(frame % image_count);
+        assert(frame == 0 || image != static_cast<uint32_t>((frame - 1) % image_count));
+        assert(image_users[image] < completed);
+
+        // The submit waits for the semaphore and signals the fence of the slot
+        image_available[slot] = frame;
+        fences[slot]          = frame;
+        image_users[image]    = frame;
+
+        // The cpu is never more than frames_in_flight frames ahead
+        assert(frame - completed < frames_in_flight);
+    }
+}
+
+/**
+ * Same loop as the swapchain : before recording a frame, the cpu waits for the gpu to finish the previous frame of the same slot, then flushes the
+ * resources released by this slot.
+ */
+static void test_frames_in_flight(uint8_t frames_in_flight)
+{
+    DeferredRelease<std::shared_ptr<Resource>> release;
+    pending_kill     = &release;
+    completed_frames = 0;
+    destroyed        = 0;
+
+    std::vector<std::shared_ptr<Resource>> per_slot(frames_in_flight); // Like the descriptor sets of each frame
+    std::shared_ptr<Resource>              shared;                     // Like a buffer used by every frame
+    int64_t                                created = 0;
+
+    constexpr int64_t frame_count = 100;
+    for (int64_t frame = 0; frame < frame_count; ++frame)
+    {
+        const size_t slot = frame % frames_in_flight;
+
+        // The fence of the slot is waited : the frames before frame - frames_in_flight + 1 are done
+        completed_frames = std::max<int64_t>(completed_frames, frame - frames_in_flight + 1);
+        release.flush(slot);
+        assert(release.pending(slot) == 0);
+
+        // Recreated every few frames, while the gpu can still use the previous one
+        if (frame % 3 == 0)
+        {
+            if (shared)
+                release.release(std::move(shared), slot);
+            shared        = std::make_shared<Resource>();
+            shared->owned = std::make_shared<Resource>();
+            created += 2;
+        }
+        shared->last_use        = frame;
+        shared->owned->last_use = frame;
+
+        // Per slot resources are only used by the frames of their slot
+        if (frame % 5 == 0 && per_slot[slot])
+            release.release(std::move(per_slot[slot]), slot);
+        if (!per_slot[slot])
+        {
+            per_slot[slot]       = std::make_shared<Resource>();
+            per_slot[slot]->slot = slot;
+            ++created;
+        }
+        per_slot[slot]->last_use = frame;
+
+        // Every released resource is destroyed within frames_in_flight frames
+        assert(release.pending() <= static_cast<size_t>(frames_in_flight) * 3);
+    }
+
+    // Device::destroy_resources() : the gpu is idle
+    completed_frames = frame_count;
+    shared           = nullptr;
+    per_slot.clear();
+    release.flush_all();
+    assert(release.pending() == 0);
+    assert(destroyed == created);
+    pending_kill = nullptr;
+}
+
+int main()
+{
+    Logger::get().enable_logs(Logger::LOG_LEVEL_DEBUG | Logger::LOG_LEVEL_ERROR | Logger::LOG_LEVEL_FATAL | Logger::LOG_LEVEL_INFO | Logger::LOG_LEVEL_WARNING);
+
+    assert(FramesInFlight::ring_size(0) == 1);
+    for (uint8_t frames_in_flight = 1; frames_in_flight <= 3; ++frames_in_flight)
+    {
+        test_ring_sizes(frames_in_flight);
+        test_swapchain_loop(frames_in_flight);
+        test_frames_in_flight(frames_in_flight);
+    }
+    std::cout << "Frames in flight tests passed" << std::endl;
+}
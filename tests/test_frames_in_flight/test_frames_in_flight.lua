@@ -0,0 +1,10 @@
+declare_module(
+    "test_frames_in_flight", 
+    {
+        deps = {"types"},
+        is_executable = true
+    }
+)
+
+target("test_frames_in_flight")
+    set_group("test")
@@ -0,0 +1,96 @@
+#include "gpu_clock.hpp"
+#include "logger.hpp"
+#include "profiler.hpp"
+
+#include <cassert>
+#include <iostream>
+
+using namespace Eng;
+using namespace std::chrono_literals;
+
+static void test_calibrated()
+{
+    const auto origin = std::chrono::steady_clock::now();
+
+    // 2ns per tick
+    GpuClock clock(2.0);
+    clock.calibrate(1000, origin);
+    assert(clock.is_calibrated());
+    assert(clock.to_cpu_time(1000) == origin);
+    assert(clock.to_cpu_time(1500) == origin + 1us);
+    assert(clock.to_cpu_time(500) == origin - 1us);
+
+    // The recording time is ignored once calibrated
+    clock.align_after(1000, origin + 1ms);
+    assert(clock.to_cpu_time(1000) == origin);
+}
+
+static void test_wrap_around()
+{
+    const auto origin = std::chrono::steady_clock::now();
+
+    // 16 valid bits : the timestamps after 0xFFFF start again from 0
+    GpuClock clock(1.0, 16);
+    clock.calibrate(0xFFF0, origin);
+    assert(clock.to_cpu_time(0x0010) == origin + 32ns);
+    assert(clock.to_cpu_time(0xFFE0) == origin - 16ns);
+
+    // The upper bits are not significant
+    assert(clock.to_cpu_time(0xABCD0010) == origin + 32ns);
+}
+
+static void test_aligned()
+{
+    const auto origin = std::chrono::steady_clock::now();
+
+    GpuClock clock;
+    assert(!clock.is_calibrated());
+
+    // The first timestamp is executed when it was recorded
+    clock.align_after(10000, origin);
+    assert(clock.to_cpu_time(10000) == origin);
+    assert(clock.to_cpu_time(12000) == origin + 2us);
+
+    // Executed later than recorded : the offset does not change
+    clock.align_after(20000, origin + 5us);
+    assert(clock.to_cpu_time(20000) == origin + 10us);
+
+    // Would have been executed before being recorded : the offset is raised
+    clock.align_after(30000, origin + 25us);
+    assert(clock.to_cpu_time(30000) == origin + 25us);
+    assert(clock.to_cpu_time(20000) == origin + 15us);
+}
+
+static void test_profiler_frames()
+{
+    Profiler& profiler = Profiler::get();
+    profiler.set_record(true);
+    const auto first_frame = std::chrono::steady_clock::now();
+    profiler.next_frame();
+    const auto second_frame = std::chrono::steady_clock::now();
+    profiler.next_frame();
+
+    // Gpu events are stored in the frame they started in, even when they are read later
+    profiler.add_gpu_event({"late", first_frame, second_frame});
+    profiler.add_gpu_event({"current", std::chrono::steady_clock::now(), std::chrono::steady_clock::now()});
+    profiler.add_gpu_event({"before recording", first_frame - 1s, first_frame});
+    profiler.next_frame();
+    profiler.set_record(false);
+
+    const auto frames = profiler.frames();
+    assert(frames->size() == 3);
+    assert(frames->at(0)->gpu_events.size() == 1 && frames->at(0)->gpu_events[0].name == "late");
+    assert(frames->at(1)->gpu_events.empty());
+    assert(frames->at(2)->gpu_events.size() == 1 && frames->at(2)->gpu_events[0].name == "current");
+}
+
+int main()
+{
+    Logger::get().enable_logs(Logger::LOG_LEVEL_DEBUG | Logger::LOG_LEVEL_ERROR | Logger::LOG_LEVEL_FATAL | Logger::LOG_LEVEL_INFO | Logger::LOG_LEVEL_WARNING);
+
+    test_calibrated();
+    test_wrap_around();
+    test_aligned();
+    test_profiler_frames();
+    std::cout << "Gpu clock tests passed" << std::endl;
+}
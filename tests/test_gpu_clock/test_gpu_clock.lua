@@ -0,0 +1,10 @@
+declare_module(
+    "test_gpu_clock", 
+    {
+        deps = {"types"},
+        is_executable = true
+    }
+)
+
+target("test_gpu_clock")
+    set_group("test")
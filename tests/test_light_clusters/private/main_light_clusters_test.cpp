@@ -0,0 +1,183 @@
+#include "light_clusters.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <glm/geometric.hpp>
+
+using namespace Eng;
+
+static LightClusterView test_view()
+{
+    // Tilted view to make sure the clusters don't rely on the world axes
+    const glm::vec3 forward = glm::normalize(glm::vec3{1, 0.2f, 0.5f});
+    const glm::vec3 right   = glm::normalize(glm::cross(glm::vec3{0, 1, 0}, forward));
+    const glm::vec3 up      = glm::cross(forward, right);
+    const float     tan_fov = std::tan(glm::radians(45.f));
+    return {.position = {10, -5, 3}, .forward = forward, .right = right, .up = up, .tan_half_width = tan_fov * 16.f / 9.f, .tan_half_height = tan_fov, .z_near = 0.5f, .z_far = 1000.f};
+}
+
+static std::vector<ClusterLight> random_lights(const LightClusterView& view, size_t count, uint32_t seed)
+{
+    std::mt19937                          rng(seed);
+    std::uniform_real_distribution<float> lateral(-1.f, 1.f);
+    std::uniform_real_distribution<float> depth(-20.f, 1100.f);
+    std::uniform_real_distribution<float> radius(0.5f, 30.f);
+    std::vector<ClusterLight>             lights;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float z = depth(rng);
+        // Slightly wider than the frustum to test the lights partially visible
+        const float x = lateral(rng) * std::abs(z) * view.tan_half_width * 1.2f;
+        const float y = lateral(rng) * std::abs(z) * view.tan_half_height * 1.2f;
+        lights.emplace_back(ClusterLight{view.position + view.forward * z + view.right * x + view.up * y, radius(rng)});
+    }
+    return lights;
+}
+
+static void test_slices()
+{
+    LightClusters clusters(16, 9, 24);
+    clusters.begin(test_view(), {});
+    assert(clusters.get_slice_start(0) == 0);
+    assert(std::abs(clusters.get_slice_start(24) - 1000.f) < 0.01f);
+    for (uint32_t slice = 1; slice < clusters.slice_count(); ++slice)
+        assert(clusters.get_slice_start(slice) > clusters.get_slice_start(slice - 1));
+
+    // Every point of the frustum maps to the cluster of its tile and slice
+    const LightClusterView view = test_view();
+    const glm::vec3        point = view.position + view.forward * 50.f;
+    const uint32_t         slice = static_cast<uint32_t>(std::log(50.f / 0.5f) / std::log(1000.f / 0.5f) * 24.f);
+    assert(clusters.find_cluster(point) == clusters.get_cluster_index(8, 4, slice));
+    assert(clusters.find_cluster(view.position - view.forward * 10.f) < 16 * 9);
+    assert(clusters.find_cluster(view.position + view.forward * 1e6f) >= 16 * 9 * 23);
+}
+
+static void test_assignment()
+{
+    const LightClusterView          view   = test_view();
+    const std::vector<ClusterLight> lights = random_lights(view, 300, 3);
+
+    LightClusters clusters;
+    clusters.begin(view, lights);
+    clusters.assign();
+    clusters.finalize();
+
+    // Lists are compact and sorted
+    uint32_t offset = 0;
+    for (uint32_t cluster = 0; cluster < clusters.cluster_count(); ++cluster)
+    {
+        assert(clusters.get_ranges()[cluster].offset == offset);
+        offset += clusters.get_ranges()[cluster].count;
+        auto cluster_lights = clusters.get_cluster_lights(cluster);
+        assert(std::ranges::is_sorted(cluster_lights));
+    }
+    assert(offset == clusters.get_light_indices().size());
+
+    // Conservative : every light touching a point is in the cluster of this point
+    std::mt19937                          rng(7);
+    std::uniform_real_distribution<float> lateral(-1.f, 1.f);
+    std::uniform_real_distribution<float> depth(0.f, 1200.f);
+    size_t                                checked = 0, culled = 0;
+    for (int i = 0; i < 20000; ++i)
+    {
+        const float     z              = depth(rng);
+        const glm::vec3 point          = view.position + view.forward * z + view.right * (lateral(rng) * z * view.tan_half_width) + view.up * (lateral(rng) * z * view.tan_half_height);
+        auto            cluster_lights = clusters.get_cluster_lights(clusters.find_cluster(point));
+        for (uint32_t light = 0; light < lights.size(); ++light)
+        {
+            // Small margin for the precision of the slice boundaries
+            const bool b_touching = glm::distance(point, lights[light].position) < lights[light].radius * 0.999f;
+            const bool b_assigned = std::ranges::binary_search(cluster_lights, light);
+            assert(!b_touching || b_assigned);
+            checked += b_touching ? 1 : 0;
+            culled += b_assigned ? 0 : 1;
+        }
+    }
+    assert(checked > 0 && culled > 0);
+
+    // Slices assigned concurrently in any order produce the same lists
+    LightClusters parallel;
+    parallel.begin(view, lights);
+    std::vector<std::thread> threads;
+    for (uint32_t slice = parallel.slice_count(); slice-- > 0;)
+        threads.emplace_back(
+            [&parallel, slice]
+            {
+                parallel.assign_slice(slice);
+            });
+    for (auto& thread : threads)
+        thread.join();
+    parallel.finalize();
+    assert(parallel.get_light_indices() == clusters.get_light_indices());
+
+    // Lights behind the view or out of range are never assigned
+    const std::vector<ClusterLight> hidden = {{view.position - view.forward * 50.f, 10.f}, {view.position + view.forward * 2000.f, 1.f}};
+    clusters.begin(view, hidden);
+    clusters.assign();
+    clusters.finalize();
+    assert(std::ranges::count(clusters.get_light_indices(), 0u) == 0);
+    assert(std::ranges::count(clusters.get_light_indices(), 1u) > 0); // The last slice has no end
+}
+
+static void benchmark()
+{
+    const LightClusterView view = test_view();
+    for (size_t light_count : {256ull, 1024ull, 4096ull})
+    {
+        const std::vector<ClusterLight> lights = random_lights(view, light_count, 11);
+        constexpr int                   ITERATIONS = 20;
+
+        LightClusters clusters;
+        auto          start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; ++i)
+        {
+            clusters.begin(view, lights);
+            clusters.assign();
+            clusters.finalize();
+        }
+        const double serial_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+
+        const uint32_t thread_count = std::clamp(std::thread::hardware_concurrency(), 1u, clusters.slice_count());
+        start                       = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; ++i)
+        {
+            clusters.begin(view, lights);
+            std::vector<std::thread> threads;
+            for (uint32_t t = 0; t < thread_count; ++t)
+                threads.emplace_back(
+                    [&clusters, t, thread_count]
+                    {
+                        for (uint32_t slice = t; slice < clusters.slice_count(); slice += thread_count)
+                            clusters.assign_slice(slice);
+                    });
+            for (auto& thread : threads)
+                thread.join();
+            clusters.finalize();
+        }
+        const double parallel_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+
+        // Average light count evaluated per shaded point : every light without clusters
+        size_t max_cluster = 0;
+        for (const auto& range : clusters.get_ranges())
+            max_cluster = std::max(max_cluster, static_cast<size_t>(range.count));
+        const double average = static_cast<double>(clusters.get_light_indices().size()) / clusters.cluster_count();
+
+        std::cout << light_count << " lights : " << serial_ms << "ms (1 thread), " << parallel_ms << "ms (" << thread_count << " threads), " << clusters.get_light_indices().size() << " indices, " << average
+                  << " lights per cluster (max " << max_cluster << ") instead of " << light_count << " per pixel" << std::endl;
+    }
+}
+
+int main()
+{
+    Logger::get().enable_logs(Logger::LOG_LEVEL_DEBUG | Logger::LOG_LEVEL_ERROR | Logger::LOG_LEVEL_FATAL | Logger::LOG_LEVEL_INFO | Logger::LOG_LEVEL_WARNING);
+
+    test_slices();
+    test_assignment();
+    benchmark();
+}
@@ -0,0 +1,10 @@
+declare_module(
+    "test_light_clusters", 
+    {
+        deps = {"types"},
+        is_executable = true
+    }
+)
+
+target("test_light_clusters")
+    set_group("test")
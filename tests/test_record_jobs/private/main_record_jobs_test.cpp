@@ -0,0 +1,66 @@
+#include "logger.hpp"
+#include "record_job_estimator.hpp"
+
+#include <cassert>
+#include <iostream>
+
+using namespace Eng;
+using namespace std::chrono_literals;
+
+static void test_without_samples()
+{
+    RecordJobEstimator estimator;
+    estimator.settings.min_draws_per_job = 64;
+
+    // Unknown draw count : every job is used
+    assert(estimator.get_job_count(std::nullopt, 24) == 24);
+    assert(estimator.get_job_count(std::nullopt, 0) == 1);
+
+    // Nothing to draw : a single job
+    assert(estimator.get_job_count(0, 24) == 1);
+    assert(estimator.get_job_count(0, 0) == 1);
+
+    // Only the minimum number of draws per job applies
+    assert(estimator.get_job_count(20, 24) == 1);
+    assert(estimator.get_job_count(640, 24) == 10);
+    assert(estimator.get_job_count(100000, 24) == 24);
+    assert(estimator.get_draw_cost() == 0ns);
+}
+
+static void test_measured_cost()
+{
+    RecordJobEstimator estimator;
+    estimator.settings.target_job_duration = 100us;
+    estimator.settings.min_draws_per_job   = 10;
+    estimator.settings.smoothing           = 0.5f;
+
+    // The first sample is used as is
+    estimator.add_sample(1000, 1000us);
+    assert(estimator.get_draw_cost() == 1000ns);
+    // 1000 draws * 1us = 10 jobs of 100us
+    assert(estimator.get_job_count(1000, 64) == 10);
+    assert(estimator.get_job_count(1000, 4) == 4);
+    assert(estimator.get_job_count(50, 64) == 1);
+
+    // Cheaper draws : fewer jobs
+    estimator.add_sample(1000, 0us);
+    assert(estimator.get_draw_cost() == 500ns);
+    assert(estimator.get_job_count(1000, 64) == 5);
+
+    // Frames without draws are ignored
+    estimator.add_sample(0, 1000us);
+    assert(estimator.get_draw_cost() == 500ns);
+
+    // Expensive draws are still limited by the minimum draws per job
+    estimator.add_sample(10, 10000us);
+    assert(estimator.get_job_count(100, 64) == 10);
+}
+
+int main()
+{
+    Logger::get().enable_logs(Logger::LOG_LEVEL_DEBUG | Logger::LOG_LEVEL_ERROR | Logger::LOG_LEVEL_FATAL | Logger::LOG_LEVEL_INFO | Logger::LOG_LEVEL_WARNING);
+
+    test_without_samples();
+    test_measured_cost();
+    std::cout << "Record job estimator tests passed" << std::endl;
+}
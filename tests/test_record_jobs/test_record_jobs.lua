@@ -0,0 +1,10 @@
+declare_module(
+    "test_record_jobs", 
+    {
+        deps = {"types"},
+        is_executable = true
+    }
+)
+
+target("test_record_jobs")
+    set_group("test")
@@ -0,0 +1,317 @@
+#include "attachment_aliasing.hpp"
+#include "logger.hpp"
+#include "render_graph_barriers.hpp"
+#include "render_graph_schedule.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace Eng;
+
+// Every node appears once, after its dependencies, at one level more than its deepest dependency
+static void check_schedule(const RenderGraphSchedule& schedule, const std::vector<std::vector<uint32_t>>& graph)
+{
+    assert(schedule.node_count() == graph.size());
+    assert(schedule.get_order().size() == graph.size());
+
+    std::vector<uint32_t> position(graph.size(), UINT32_MAX);
+    for (uint32_t i = 0; i < schedule.get_order().size(); ++i)
+    {
+        assert(position[schedule.get_order()[i]] == UINT32_MAX);
+        position[schedule.get_order()[i]] = i;
+    }
+
+    uint32_t level_nodes = 0;
+    for (uint32_t level = 0; level < schedule.level_count(); ++level)
+    {
+        assert(!schedule.get_level_nodes(level).empty());
+        for (uint32_t node : schedule.get_level_nodes(level))
+            assert(schedule.get_level(node) == level);
+        level_nodes += static_cast<uint32_t>(schedule.get_level_nodes(level).size());
+    }
+    assert(level_nodes == graph.size());
+
+    for (uint32_t node = 0; node < graph.size(); ++node)
+    {
+        uint32_t level = 0;
+        for (uint32_t dependency : graph[node])
+        {
+            assert(position[dependency] < position[node]);
+            assert(std::ranges::binary_search(schedule.get_waits(node), dependency));
+            assert(std::ranges::binary_search(schedule.get_consumers(dependency), node));
+            level = std::max(level, schedule.get_level(dependency) + 1);
+        }
+        assert(schedule.get_level(node) == level);
+        assert(std::ranges::is_sorted(schedule.get_waits(node)));
+        assert(std::ranges::adjacent_find(schedule.get_waits(node)) == schedule.get_waits(node).end());
+    }
+}
+
+static void test_simple_graphs()
+{
+    RenderGraphSchedule schedule;
+
+    // Empty graph
+    assert(schedule.build({}));
+    assert(schedule.node_count() == 0 && schedule.level_count() == 0);
+
+    // Chain : present <- post process <- lighting <- gbuffer
+    const std::vector<std::vector<uint32_t>> chain = {{1}, {2}, {3}, {}};
+    assert(schedule.build(chain));
+    check_schedule(schedule, chain);
+    assert(schedule.level_count() == 4);
+    assert(std::ranges::equal(schedule.get_order(), std::vector<uint32_t>{3, 2, 1, 0}));
+
+    // Diamond with a duplicated edge : both middle passes can be recorded in parallel
+    const std::vector<std::vector<uint32_t>> diamond = {{1, 2, 1}, {3}, {3}, {}};
+    assert(schedule.build(diamond));
+    check_schedule(schedule, diamond);
+    assert(schedule.level_count() == 3);
+    assert(std::ranges::equal(schedule.get_level_nodes(1), std::vector<uint32_t>{1, 2}));
+    assert(schedule.get_waits(0).size() == 2);
+    assert(schedule.get_consumers(3).size() == 2);
+
+    // A shadow pass shared by two targets is executed once
+    const std::vector<std::vector<uint32_t>> shared = {{1, 2}, {3}, {3, 4}, {4}, {}};
+    assert(schedule.build(shared));
+    check_schedule(schedule, shared);
+    assert(schedule.get_level(0) == 3);
+
+    // Cycles are rejected
+    assert(!schedule.build(std::vector<std::vector<uint32_t>>{{1}, {2}, {0}}));
+    assert(!schedule.build(std::vector<std::vector<uint32_t>>{{0}}));
+}
+
+static std::vector<std::vector<uint32_t>> random_graph(uint32_t node_count, uint32_t max_dependencies, uint32_t seed)
+{
+    // Node i only depends on nodes with a higher index : the graph is acyclic. Indices are shuffled to hide this order.
+    std::mt19937          rng(seed);
+    std::vector<uint32_t> remap(node_count);
+    for (uint32_t i = 0; i < node_count; ++i)
+        remap[i] = i;
+    std::ranges::shuffle(remap, rng);
+
+    std::vector<std::vector<uint32_t>> graph(node_count);
+    for (uint32_t i = 0; i + 1 < node_count; ++i)
+    {
+        std::uniform_int_distribution<uint32_t> dependency(i + 1, node_count - 1);
+        const uint32_t                          count = std::uniform_int_distribution<uint32_t>(0, max_dependencies)(rng);
+        for (uint32_t d = 0; d < count; ++d)
+            graph[remap[i]].emplace_back(remap[dependency(rng)]);
+    }
+    return graph;
+}
+
+static void test_random_graphs()
+{
+    RenderGraphSchedule schedule;
+    for (uint32_t seed = 0; seed < 50; ++seed)
+    {
+        auto graph = random_graph(1 + seed * 7, 4, seed);
+        assert(schedule.build(graph));
+        check_schedule(schedule, graph);
+
+        // Closing a loop makes the build fail
+        const uint32_t first = schedule.get_order().front();
+        if (!schedule.get_consumers(first).empty())
+        {
+            graph[first].emplace_back(schedule.get_consumers(first).front());
+            assert(!schedule.build(graph));
+        }
+    }
+}
+
+// Does node wait for every use of the attachment (directly or not)
+static bool released_before(const RenderGraphSchedule& schedule, const AliasedAttachment& attachment, uint32_t node)
+{
+    std::vector<bool>     visited(schedule.node_count(), false);
+    std::vector<uint32_t> stack(schedule.get_waits(node).begin(), schedule.get_waits(node).end());
+    while (!stack.empty())
+    {
+        const uint32_t current = stack.back();
+        stack.pop_back();
+        if (visited[current])
+            continue;
+        visited[current] = true;
+        stack.insert(stack.end(), schedule.get_waits(current).begin(), schedule.get_waits(current).end());
+    }
+    if (!visited[attachment.node])
+        return false;
+    return std::ranges::all_of(schedule.get_consumers(attachment.node),
+                               [&](uint32_t consumer)
+                               {
+                                   return visited[consumer];
+                               });
+}
+
+// Attachments sharing a slot are never used at the same time and fit in the slot
+static void check_aliasing(const RenderGraphSchedule& schedule, const AttachmentAliasing& aliasing, const std::vector<AliasedAttachment>& attachments)
+{
+    uint64_t required = 0;
+    for (uint32_t a = 0; a < attachments.size(); ++a)
+    {
+        const AliasingSlot& slot = aliasing.get_slots()[aliasing.get_slot(a)];
+        assert(slot.size >= attachments[a].size && slot.alignment >= attachments[a].alignment && (slot.memory_type_bits & attachments[a].memory_type_bits) == slot.memory_type_bits);
+        assert(slot.memory_type_bits != 0);
+        required += attachments[a].size;
+        for (uint32_t b = a + 1; b < attachments.size(); ++b)
+            if (aliasing.get_slot(a) == aliasing.get_slot(b))
+                assert(released_before(schedule, attachments[a], attachments[b].node) || released_before(schedule, attachments[b], attachments[a].node));
+    }
+    assert(aliasing.get_required_size() == required);
+    assert(aliasing.get_aliased_size() <= required);
+}
+
+static void test_attachment_aliasing()
+{
+    RenderGraphSchedule schedule;
+    AttachmentAliasing  aliasing;
+
+    // present(0) <- cmaa(1) <- resolve(2) <- gbuffers(3), shadows(4)
+    const std::vector<std::vector<uint32_t>> graph = {{1}, {2}, {3, 4}, {}, {}};
+    assert(schedule.build(graph));
+    constexpr uint64_t                   MB          = 1024 * 1024;
+    const std::vector<AliasedAttachment> attachments = {
+        {3, 32 * MB, 256, 0b11},  // position
+        {3, 8 * MB, 256, 0b11},   // albedo
+        {3, 8 * MB, 256, 0b11},   // normal
+        {3, 8 * MB, 256, 0b11},   // depth
+        {4, 64 * MB, 1024, 0b01}, // shadows
+        {2, 8 * MB, 256, 0b11},   // resolve target
+        {1, 8 * MB, 512, 0b11},   // cmaa target
+    };
+    aliasing.build(schedule, attachments);
+    check_aliasing(schedule, aliasing, attachments);
+
+    // The gbuffers are released once the resolve pass is done : the cmaa target reuses the memory of one of them
+    assert(aliasing.get_slots().size() == 6);
+    assert(aliasing.get_slot(6) < 4 && aliasing.get_slot(6) != aliasing.get_slot(5));
+    // Attachments of a same pass, or read by the pass, are never aliased
+    for (uint32_t a = 0; a < 6; ++a)
+        for (uint32_t b = a + 1; b < 6; ++b)
+            assert(aliasing.get_slot(a) != aliasing.get_slot(b));
+    assert(aliasing.get_aliased_size() == aliasing.get_required_size() - 8 * MB);
+
+    // Long chains only need two slots
+    std::vector<std::vector<uint32_t>> chain(16);
+    std::vector<AliasedAttachment>     chain_attachments;
+    for (uint32_t node = 0; node < chain.size(); ++node)
+    {
+        if (node + 1 < chain.size())
+            chain[node].emplace_back(node + 1);
+        chain_attachments.emplace_back(AliasedAttachment{node, 8 * MB, 256, 1});
+    }
+    assert(schedule.build(chain));
+    aliasing.build(schedule, chain_attachments);
+    check_aliasing(schedule, aliasing, chain_attachments);
+    assert(aliasing.get_slots().size() == 2);
+
+    // Random graphs
+    std::mt19937 rng(5);
+    for (uint32_t seed = 0; seed < 30; ++seed)
+    {
+        const auto random = random_graph(2 + seed * 3, 3, seed);
+        assert(schedule.build(random));
+        std::vector<AliasedAttachment> random_attachments;
+        for (uint32_t node = 0; node < random.size(); ++node)
+            for (uint32_t i = std::uniform_int_distribution<uint32_t>(0, 3)(rng); i > 0; --i)
+                random_attachments.emplace_back(AliasedAttachment{node, std::uniform_int_distribution<uint64_t>(1, 64)(rng) * MB, 256, std::uniform_int_distribution<uint32_t>(1, 3)(rng)});
+        aliasing.build(schedule, random_attachments);
+        check_aliasing(schedule, aliasing, random_attachments);
+    }
+}
+
+static void test_barriers()
+{
+    RenderGraphSchedule schedule;
+    RenderGraphBarriers barriers;
+
+    // present(0) <- resolve(1) <- gbuffers(2), shadows(3). The shadows are also read by a compute effect of the present pass.
+    const std::vector<std::vector<uint32_t>> graph = {{1, 3}, {2, 3}, {}, {}};
+    assert(schedule.build(graph));
+    const std::vector<GraphResource> resources = {
+        {2, RESOURCE_ACCESS_COLOR_ATTACHMENT},                                // albedo
+        {2, RESOURCE_ACCESS_DEPTH_ATTACHMENT},                                // depth
+        {3, RESOURCE_ACCESS_DEPTH_ATTACHMENT, RESOURCE_ACCESS_FRAGMENT_READ}, // shadows (persistent)
+        {1, RESOURCE_ACCESS_COLOR_ATTACHMENT},                                // resolve target
+        {0, RESOURCE_ACCESS_COLOR_ATTACHMENT, RESOURCE_ACCESS_PRESENT},       // swapchain
+        {2, RESOURCE_ACCESS_COLOR_ATTACHMENT},                                // velocity (never read)
+    };
+    const std::vector<GraphResourceRead> reads = {
+        {1, 0, RESOURCE_ACCESS_FRAGMENT_READ},
+        {1, 1, RESOURCE_ACCESS_FRAGMENT_READ},
+        {1, 2, RESOURCE_ACCESS_FRAGMENT_READ},
+        {0, 3, RESOURCE_ACCESS_FRAGMENT_READ},
+        {0, 2, RESOURCE_ACCESS_COMPUTE_READ},
+    };
+    assert(barriers.build(schedule, resources, reads));
+
+    using Barriers = std::vector<ResourceBarrier>;
+    // Attachments are prepared for writing in a single batch, their previous content is discarded
+    assert(std::ranges::equal(barriers.get_begin_barriers(2), Barriers{{0, RESOURCE_ACCESS_NONE, RESOURCE_ACCESS_COLOR_ATTACHMENT},
+                                                                        {1, RESOURCE_ACCESS_NONE, RESOURCE_ACCESS_DEPTH_ATTACHMENT},
+                                                                        {5, RESOURCE_ACCESS_NONE, RESOURCE_ACCESS_COLOR_ATTACHMENT}}));
+    assert(std::ranges::equal(barriers.get_begin_barriers(0), Barriers{{4, RESOURCE_ACCESS_NONE, RESOURCE_ACCESS_COLOR_ATTACHMENT}}));
+
+    // Unread attachments are left as they are
+    assert(std::ranges::equal(barriers.get_end_barriers(2), Barriers{{0, RESOURCE_ACCESS_COLOR_ATTACHMENT, RESOURCE_ACCESS_FRAGMENT_READ},
+                                                                      {1, RESOURCE_ACCESS_DEPTH_ATTACHMENT, RESOURCE_ACCESS_FRAGMENT_READ}}));
+    // Readers of different stages share the same transition
+    assert(std::ranges::equal(barriers.get_end_barriers(3), Barriers{{2, RESOURCE_ACCESS_DEPTH_ATTACHMENT, RESOURCE_ACCESS_FRAGMENT_READ | RESOURCE_ACCESS_COMPUTE_READ}}));
+    assert(std::ranges::equal(barriers.get_end_barriers(1), Barriers{{3, RESOURCE_ACCESS_COLOR_ATTACHMENT, RESOURCE_ACCESS_FRAGMENT_READ}}));
+    assert(std::ranges::equal(barriers.get_end_barriers(0), Barriers{{4, RESOURCE_ACCESS_COLOR_ATTACHMENT, RESOURCE_ACCESS_PRESENT}}));
+
+    // Each dependency is only waited by the stages using it
+    using Accesses = std::vector<ResourceAccess>;
+    assert(std::ranges::equal(barriers.get_wait_accesses(1), Accesses{RESOURCE_ACCESS_FRAGMENT_READ | RESOURCE_ACCESS_COLOR_ATTACHMENT, RESOURCE_ACCESS_FRAGMENT_READ | RESOURCE_ACCESS_COLOR_ATTACHMENT}));
+    assert(std::ranges::equal(barriers.get_wait_accesses(0), Accesses{RESOURCE_ACCESS_FRAGMENT_READ | RESOURCE_ACCESS_COLOR_ATTACHMENT, RESOURCE_ACCESS_COMPUTE_READ | RESOURCE_ACCESS_COLOR_ATTACHMENT}));
+    assert(barriers.get_wait_accesses(2).empty() && barriers.get_wait_accesses(3).empty());
+
+    // A pass without attachment only waits for what it reads
+    const std::vector<std::vector<uint32_t>> compute_graph = {{1, 2, 3}, {}, {}, {}};
+    assert(schedule.build(compute_graph));
+    const std::vector<GraphResource>     compute_resources = {{1, RESOURCE_ACCESS_COLOR_ATTACHMENT}, {2, RESOURCE_ACCESS_COMPUTE_WRITE}};
+    const std::vector<GraphResourceRead> compute_reads     = {{0, 0, RESOURCE_ACCESS_COMPUTE_READ}, {0, 1, RESOURCE_ACCESS_COMPUTE_READ}};
+    assert(barriers.build(schedule, compute_resources, compute_reads));
+    assert(std::ranges::equal(barriers.get_wait_accesses(0), Accesses{RESOURCE_ACCESS_COMPUTE_READ, RESOURCE_ACCESS_COMPUTE_READ, RESOURCE_ACCESS_NONE}));
+    assert(barriers.get_begin_barriers(0).empty() && barriers.get_end_barriers(0).empty() && barriers.get_end_barriers(3).empty());
+    assert(std::ranges::equal(barriers.get_end_barriers(2), Barriers{{1, RESOURCE_ACCESS_COMPUTE_WRITE, RESOURCE_ACCESS_COMPUTE_READ}}));
+
+    // Reading a resource of a pass that is not a direct dependency is rejected
+    assert(schedule.build(graph));
+    const std::vector<GraphResourceRead> invalid_reads = {{0, 0, RESOURCE_ACCESS_FRAGMENT_READ}};
+    assert(!barriers.build(schedule, resources, invalid_reads));
+}
+
+static void benchmark()
+{
+    for (uint32_t node_count : {64u, 1024u, 16384u})
+    {
+        const auto          graph = random_graph(node_count, 3, 42);
+        RenderGraphSchedule schedule;
+        constexpr int       ITERATIONS = 20;
+        const auto          start      = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; ++i)
+            schedule.build(graph);
+        const double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+
+        size_t widest = 0;
+        for (uint32_t level = 0; level < schedule.level_count(); ++level)
+            widest = std::max(widest, schedule.get_level_nodes(level).size());
+        std::cout << node_count << " passes : compiled in " << build_ms << "ms, " << schedule.level_count() << " levels (widest : " << widest << " passes)" << std::endl;
+    }
+}
+
+int main()
+{
+    Logger::get().enable_logs(Logger::LOG_LEVEL_DEBUG | Logger::LOG_LEVEL_ERROR | Logger::LOG_LEVEL_FATAL | Logger::LOG_LEVEL_INFO | Logger::LOG_LEVEL_WARNING);
+
+    test_simple_graphs();
+    test_random_graphs();
+    test_attachment_aliasing();
+    test_barriers();
+    benchmark();
+}
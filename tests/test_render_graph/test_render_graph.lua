@@ -0,0 +1,10 @@
+declare_module(
+    "test_render_graph", 
+    {
+        deps = {"types"},
+        is_executable = true
+    }
+)
+
+target("test_render_graph")
+    set_group("test")
@@ -0,0 +1,220 @@
+#include "logger.hpp"
+#include "render_queue.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace Eng;
+
+static void test_sort()
+{
+    std::mt19937_64 rng(5);
+    for (size_t count : {0ull, 1ull, 100ull, 255ull, 256ull, 257ull, 10000ull})
+    {
+        RenderQueue           queue;
+        std::vector<uint64_t> expected;
+        for (size_t i = 0; i < count; ++i)
+        {
+            // Constant high bits to check the skipped bytes
+            const uint64_t key = 0x3ull << 60 | (rng() & 0x0000FFFFFFFFFFFFull);
+            queue.push(key, static_cast<uint32_t>(i));
+            expected.emplace_back(key);
+        }
+        std::ranges::sort(expected);
+        queue.sort();
+
+        assert(queue.size() == count);
+        std::vector<bool> seen(count, false);
+        for (size_t i = 0; i < count; ++i)
+        {
+            assert(queue.items()[i].key == expected[i]);
+            assert(!seen[queue.items()[i].index]);
+            seen[queue.items()[i].index] = true;
+        }
+    }
+
+    // Large radix sort is stable : equal keys keep the push order
+    RenderQueue queue;
+    for (uint32_t i = 0; i < 1000; ++i)
+        queue.push(i % 3, i);
+    queue.sort();
+    for (size_t i = 1; i < queue.size(); ++i)
+        assert(queue.items()[i - 1].key < queue.items()[i].key || queue.items()[i - 1].index < queue.items()[i].index);
+}
+
+static void test_keys()
+{
+    // Layer first, then pipeline, material, mesh and depth
+    assert(DrawSortKey::make(0, 0xFFFF, 0xFFFF, 0xFFFF, 1.f) < DrawSortKey::make(1, 0, 0, 0, 0.f));
+    assert(DrawSortKey::make(0, 1, 0xFFFF, 0xFFFF, 1.f) < DrawSortKey::make(0, 2, 0, 0, 0.f));
+    assert(DrawSortKey::make(0, 1, 1, 0xFFFF, 1.f) < DrawSortKey::make(0, 1, 2, 0, 0.f));
+    assert(DrawSortKey::make(0, 1, 1, 1, 1.f) < DrawSortKey::make(0, 1, 1, 2, 0.f));
+    assert(DrawSortKey::make(0, 1, 1, 1, 0.2f) < DrawSortKey::make(0, 1, 1, 1, 0.8f));
+    // Depth is clamped
+    assert(DrawSortKey::make(0, 1, 1, 1, -5.f) == DrawSortKey::make(0, 1, 1, 1, 0.f));
+    assert(DrawSortKey::make(0, 1, 1, 1, 5.f) == DrawSortKey::make(0, 1, 1, 1, 1.f));
+
+    // Blended draws : back to front whatever the state
+    assert(DrawSortKey::make_back_to_front(1, 0.8f, 0xFFFF, 0xFFFF, 0xFFFF) < DrawSortKey::make_back_to_front(1, 0.2f, 0, 0, 0));
+    assert(DrawSortKey::make(0, 0xFFFF, 0xFFFF, 0xFFFF, 1.f) < DrawSortKey::make_back_to_front(1, 1.f, 0, 0, 0));
+
+    DrawStateTracker tracker;
+    int              a = 0, b = 0;
+    assert(tracker.set_pipeline(&a));
+    assert(tracker.set_material(&a));
+    assert(!tracker.set_material(&a));
+    assert(!tracker.set_pipeline(&a));
+    // A new pipeline invalidates the material
+    assert(tracker.set_pipeline(&b));
+    assert(tracker.set_material(&a));
+    assert(tracker.get_stats().pipeline_binds == 2 && tracker.get_stats().material_binds == 2);
+    assert(tracker.get_stats().skipped_pipelines == 1 && tracker.get_stats().skipped_materials == 1);
+    (void)a;
+    (void)b;
+}
+
+static void test_batches()
+{
+    // Draws of the same mesh are grouped only when they are consecutive in the sorted queue
+    const std::vector<int> meshes = {1, 1, 2, 1, 1, 1, 3, 3};
+    RenderQueue            queue;
+    for (uint32_t i = 0; i < meshes.size(); ++i)
+        queue.push(i, i);
+    queue.sort();
+
+    std::vector<DrawBatch> batches;
+    queue.build_batches(
+        [&](uint32_t a, uint32_t b)
+        {
+            return meshes[a] == meshes[b];
+        },
+        batches);
+    assert(batches.size() == 4);
+    assert(batches[0].first == 0 && batches[0].count == 2);
+    assert(batches[1].first == 2 && batches[1].count == 1);
+    assert(batches[2].first == 3 && batches[2].count == 3);
+    assert(batches[3].first == 6 && batches[3].count == 2);
+
+    // Non instanced draws are never grouped
+    batches.clear();
+    queue.build_batches(
+        [](uint32_t, uint32_t)
+        {
+            return false;
+        },
+        batches);
+    assert(batches.size() == meshes.size());
+
+    batches.clear();
+    RenderQueue().build_batches(
+        [](uint32_t, uint32_t)
+        {
+            return true;
+        },
+        batches);
+    assert(batches.empty());
+}
+
+struct SyntheticDraw
+{
+    const void* pipeline;
+    const void* material;
+    const void* mesh;
+    float       depth;
+};
+
+static DrawStateTracker::Stats submit(std::span<const SyntheticDraw> draws, std::span<const RenderQueueItem> order)
+{
+    DrawStateTracker tracker;
+    for (const auto& item : order)
+    {
+        const SyntheticDraw& draw = draws[item.index];
+        tracker.set_pipeline(draw.pipeline);
+        tracker.set_material(draw.material);
+        tracker.set_mesh(draw.mesh);
+        tracker.add_draw();
+    }
+    return tracker.get_stats();
+}
+
+static void benchmark()
+{
+    constexpr size_t DRAW_COUNT     = 100000;
+    constexpr size_t PIPELINE_COUNT = 24;
+    constexpr size_t MATERIAL_COUNT = 600;
+    constexpr size_t MESH_COUNT     = 3000;
+    constexpr int    ITERATIONS     = 20;
+
+    // Resource addresses, every material uses a single pipeline
+    std::vector<uint64_t> pipelines(PIPELINE_COUNT), materials(MATERIAL_COUNT), meshes(MESH_COUNT);
+    std::vector<size_t>   material_pipeline(MATERIAL_COUNT);
+    std::mt19937          rng(9);
+    for (auto& pipeline : material_pipeline)
+        pipeline = rng() % PIPELINE_COUNT;
+
+    // Scenes usually reuse a few meshes a lot
+    std::vector<SyntheticDraw>            draws;
+    std::exponential_distribution<double> mesh_distribution(8.0);
+    std::uniform_real_distribution<float> depth(0.f, 1.f);
+    for (size_t i = 0; i < DRAW_COUNT; ++i)
+    {
+        const size_t mesh     = std::min(MESH_COUNT - 1, static_cast<size_t>(mesh_distribution(rng) * MESH_COUNT));
+        const size_t material = (mesh * 7 + rng() % 2) % MATERIAL_COUNT;
+        draws.emplace_back(SyntheticDraw{&pipelines[material_pipeline[material]], &materials[material], &meshes[mesh], depth(rng)});
+    }
+
+    RenderQueue scene_order;
+    for (uint32_t i = 0; i < DRAW_COUNT; ++i)
+        scene_order.push(0, i);
+
+    RenderQueue queue;
+    const auto  start = std::chrono::steady_clock::now();
+    for (int iteration = 0; iteration < ITERATIONS; ++iteration)
+    {
+        queue.clear();
+        for (uint32_t i = 0; i < DRAW_COUNT; ++i)
+        {
+            const SyntheticDraw& draw = draws[i];
+            queue.push(DrawSortKey::make(0, DrawSortKey::resource_id(draw.pipeline), DrawSortKey::resource_id(draw.material), DrawSortKey::resource_id(draw.mesh), draw.depth), i);
+        }
+        queue.sort();
+    }
+    const double sort_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+
+    const auto unsorted = submit(draws, scene_order.items());
+    const auto sorted   = submit(draws, queue.items());
+
+    // Previous submission : only the pipeline bind was filtered, descriptors and buffers were bound for every draw
+    const size_t previous = unsorted.pipeline_binds + DRAW_COUNT * 2;
+    assert(sorted.state_changes() <= unsorted.state_changes());
+    assert(sorted.pipeline_binds <= PIPELINE_COUNT);
+
+    std::cout << DRAW_COUNT << " draws, key build + sort : " << sort_ms << "ms" << std::endl;
+    std::cout << "previous submission : " << previous << " state changes" << std::endl;
+    std::cout << "scene order + filtering : " << unsorted.state_changes() << " state changes (" << unsorted.pipeline_binds << " pipelines, " << unsorted.material_binds << " materials, " << unsorted.mesh_binds << " meshes)" << std::endl;
+    std::vector<DrawBatch> batches;
+    queue.build_batches(
+        [&](uint32_t a, uint32_t b)
+        {
+            return draws[a].pipeline == draws[b].pipeline && draws[a].material == draws[b].material && draws[a].mesh == draws[b].mesh;
+        },
+        batches);
+    assert(batches.size() <= sorted.draws);
+
+    std::cout << "sorted + filtering : " << sorted.state_changes() << " state changes (" << sorted.pipeline_binds << " pipelines, " << sorted.material_binds << " materials, " << sorted.mesh_binds << " meshes), " << previous - sorted.state_changes()
+              << " avoided" << std::endl;
+    std::cout << "instancing : " << batches.size() << " draw calls instead of " << sorted.draws << std::endl;
+}
+
+int main()
+{
+    Logger::get().enable_logs(Logger::LOG_LEVEL_DEBUG | Logger::LOG_LEVEL_ERROR | Logger::LOG_LEVEL_FATAL | Logger::LOG_LEVEL_INFO | Logger::LOG_LEVEL_WARNING);
+
+    test_keys();
+    test_sort();
+    test_batches();
+    benchmark();
+}
@@ -0,0 +1,10 @@
+declare_module(
+    "test_render_queue", 
+    {
+        deps = {"types"},
+        is_executable = true
+    }
+)
+
+target("test_render_queue")
+    set_group("test")
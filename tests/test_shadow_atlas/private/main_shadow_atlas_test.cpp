@@ -0,0 +1,151 @@
+#include "image_signatures.hpp"
+#include "logger.hpp"
+#include "shadow_atlas.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace Eng;
+
+// Tiles are inside the atlas, aligned on their size and never overlap
+static void check_tiles(const ShadowAtlas& atlas, std::span<const ShadowAtlasTile> tiles)
+{
+    const uint32_t        side = atlas.get_size() / atlas.get_min_tile_size();
+    std::vector<uint32_t> owners(side * side, UINT32_MAX);
+    for (uint32_t i = 0; i < tiles.size(); ++i)
+    {
+        const ShadowAtlasTile& tile = tiles[i];
+        if (!tile.is_valid())
+            continue;
+        assert(tile.size >= atlas.get_min_tile_size() && (tile.size & (tile.size - 1)) == 0);
+        assert(tile.x % tile.size == 0 && tile.y % tile.size == 0);
+        assert(tile.x + tile.size <= atlas.get_size() && tile.y + tile.size <= atlas.get_size());
+        for (uint32_t y = tile.y / atlas.get_min_tile_size(); y < (tile.y + tile.size) / atlas.get_min_tile_size(); ++y)
+            for (uint32_t x = tile.x / atlas.get_min_tile_size(); x < (tile.x + tile.size) / atlas.get_min_tile_size(); ++x)
+            {
+                assert(owners[y * side + x] == UINT32_MAX);
+                owners[y * side + x] = i;
+            }
+    }
+}
+
+static void test_tile_size()
+{
+    const ShadowAtlas atlas(4096, 128);
+    assert(atlas.get_tile_size(1.f, 2048) == 2048);
+    assert(atlas.get_tile_size(1.f, 8192) == 4096);
+    assert(atlas.get_tile_size(0.3f, 8192) == 1024);
+    assert(atlas.get_tile_size(0.f, 2048) == 128);
+    assert(atlas.get_tile_size(0.3f, 3000) == 1024);
+    assert(atlas.get_tile_size(1.f, 3000) == 2048);
+
+    assert(ShadowAtlas::screen_importance({0, 0, 0}, 10, {5, 0, 0}, 1) == 1);
+    assert(ShadowAtlas::screen_importance({0, 0, 0}, 10, {100, 0, 0}, 1) < ShadowAtlas::screen_importance({0, 0, 0}, 10, {50, 0, 0}, 1));
+}
+
+static void test_allocation()
+{
+    const ShadowAtlas            atlas(4096, 128);
+    std::vector<ShadowAtlasTile> tiles;
+
+    // Everything fits : requested sizes are kept
+    const std::vector<ShadowAtlasRequest> few = {{1.f, 2048}, {0.2f, 2048}, {0.6f, 1024}, {0.05f, 2048}};
+    atlas.allocate(few, tiles);
+    check_tiles(atlas, tiles);
+    assert(tiles[0].size == 2048 && tiles[1].size == 512 && tiles[2].size == 1024 && tiles[3].size == 128);
+
+    // Full atlas : the least important tiles are downgraded first
+    std::vector<ShadowAtlasRequest> many;
+    for (int i = 0; i < 8; ++i)
+        many.emplace_back(ShadowAtlasRequest{static_cast<float>(i) / 8.f + 0.5f, 2048});
+    atlas.allocate(many, tiles);
+    check_tiles(atlas, tiles);
+    for (size_t i = 1; i < tiles.size(); ++i)
+        assert(tiles[i].size >= tiles[i - 1].size);
+    assert(tiles.back().size == 2048);
+
+    // More requests than min tiles : the least important are dropped
+    std::vector<ShadowAtlasRequest> too_many(2000, ShadowAtlasRequest{0.f, 2048});
+    too_many[1234].importance = 1.f;
+    atlas.allocate(too_many, tiles);
+    check_tiles(atlas, tiles);
+    assert(std::ranges::count_if(tiles, [](const ShadowAtlasTile& tile) { return tile.is_valid(); }) <= 32 * 32);
+    assert(tiles[1234].is_valid());
+
+    atlas.allocate({}, tiles);
+    assert(tiles.empty());
+}
+
+/**
+ * Same loop as the atlas passes : each frame draws in the copy of its frame in flight, and is skipped when this copy already holds the current
+ * content.
+ */
+static void test_cached_images()
+{
+    for (uint8_t frames_in_flight = 1; frames_in_flight <= 3; ++frames_in_flight)
+    {
+        ImageSignatures      signatures;
+        std::vector<int64_t> drawn(frames_in_flight, -1); // Last frame drawn in each copy
+        signatures.reset(frames_in_flight);
+
+        uint64_t signature = 1;
+        for (int64_t frame = 0; frame < 20; ++frame)
+        {
+            // The atlas layout or a caster changed
+            if (frame == 10)
+                ++signature;
+
+            const size_t image = frame % frames_in_flight;
+            if (signatures.update(image, signature))
+            {
+                // Each copy is drawn once for each content, before any skip
+                assert(frame < frames_in_flight || (frame >= 10 && frame < 10 + frames_in_flight));
+                drawn[image] = frame;
+            }
+            else
+                assert(drawn[image] >= 0 && (frame < 10 || drawn[image] >= 10));
+        }
+
+        // New attachments are drawn again
+        signatures.reset(frames_in_flight);
+        for (size_t image = 0; image < frames_in_flight; ++image)
+            assert(signatures.update(image, signature));
+    }
+}
+
+static void benchmark()
+{
+    const ShadowAtlas                     atlas(8192, 64);
+    std::mt19937                          rng(4);
+    std::exponential_distribution<float>  importance(10.f);
+    std::vector<ShadowAtlasRequest>       requests;
+    for (int i = 0; i < 1000; ++i)
+        requests.emplace_back(ShadowAtlasRequest{importance(rng), 2048});
+
+    constexpr int                ITERATIONS = 100;
+    std::vector<ShadowAtlasTile> tiles;
+    const auto                   start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+        atlas.allocate(requests, tiles);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+    check_tiles(atlas, tiles);
+
+    uint64_t area = 0;
+    for (const auto& tile : tiles)
+        area += static_cast<uint64_t>(tile.size) * tile.size;
+    std::cout << requests.size() << " shadow maps : allocated in " << ms << "ms, " << 100.0 * static_cast<double>(area) / (8192.0 * 8192.0) << "% of the atlas used, "
+              << std::ranges::count_if(tiles, [](const ShadowAtlasTile& tile) { return tile.is_valid(); }) << " tiles" << std::endl;
+}
+
+int main()
+{
+    Logger::get().enable_logs(Logger::LOG_LEVEL_DEBUG | Logger::LOG_LEVEL_ERROR | Logger::LOG_LEVEL_FATAL | Logger::LOG_LEVEL_INFO | Logger::LOG_LEVEL_WARNING);
+
+    test_tile_size();
+    test_allocation();
+    test_cached_images();
+    benchmark();
+}
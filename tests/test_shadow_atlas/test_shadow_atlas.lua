@@ -0,0 +1,10 @@
+declare_module(
+    "test_shadow_atlas", 
+    {
+        deps = {"types"},
+        is_executable = true
+    }
+)
+
+target("test_shadow_atlas")
+    set_group("test")
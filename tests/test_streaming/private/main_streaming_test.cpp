@@ -0,0 +1,336 @@
+#include "dynamic_bvh.hpp"
+#include "logger.hpp"
+#include "world_partition.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <random>
+#include <thread>
+
+using namespace Eng;
+
+// Synthetic world : objects are generated procedurally and stored in the cell owning them
+struct SyntheticWorld
+{
+    SyntheticWorld(const WorldPartition& partition, size_t object_count, float world_size, uint32_t seed)
+    {
+        std::mt19937                          rng(seed);
+        std::uniform_real_distribution<float> position(-world_size * 0.5f, world_size * 0.5f);
+        std::uniform_real_distribution<float> height(0.f, 20.f);
+        std::uniform_real_distribution<float> size_distribution(0.f, 1.f);
+        for (size_t i = 0; i < object_count; ++i)
+        {
+            // Mostly small props, a few large buildings
+            const float  size   = size_distribution(rng) < 0.98f ? 1.f + size_distribution(rng) * 4.f : 50.f + size_distribution(rng) * 300.f;
+            const Bounds bounds = Bounds::from_extent({position(rng), height(rng), position(rng)}, glm::vec3{size});
+            cells[partition.get_cell(bounds)].emplace_back(bounds);
+        }
+    }
+
+    size_t count(std::span<const WorldCell> in_cells) const
+    {
+        size_t total = 0;
+        for (const auto& cell : in_cells)
+            if (auto found = cells.find(cell); found != cells.end())
+                total += found->second.size();
+        return total;
+    }
+
+    ankerl::unordered_dense::map<WorldCell, std::vector<Bounds>> cells;
+};
+
+// Streamed world : chunks are "deserialized" on worker threads then merged in a bvh
+class StreamedWorld
+{
+public:
+    StreamedWorld(const SyntheticWorld& in_source, const WorldPartition& partition)
+        : source(in_source), streamer(partition, {[this](const WorldCell& cell)
+                                                   {
+                                                       load(cell);
+                                                   },
+                                                   [this](const WorldCell& cell)
+                                                   {
+                                                       merge(cell);
+                                                   },
+                                                   [this](const WorldCell& cell, bool b_merged)
+                                                   {
+                                                       unload(cell, b_merged);
+                                                   }})
+    {
+    }
+
+    ~StreamedWorld()
+    {
+        wait_loads();
+    }
+
+    void wait_loads()
+    {
+        for (auto& load : running_loads)
+            load.wait();
+        running_loads.clear();
+    }
+
+    const SyntheticWorld& source;
+    WorldStreamer         streamer;
+    DynamicBvh            bvh;
+    std::chrono::microseconds load_latency{0};
+    std::chrono::nanoseconds  merge_cost_per_object{0}; // Simulate the creation of the components
+
+    std::mutex                                                   loaded_mtx;
+    ankerl::unordered_dense::map<WorldCell, std::vector<Bounds>> loaded;
+
+    ankerl::unordered_dense::map<WorldCell, std::vector<uint32_t>> merged;
+    size_t                                                         merge_count   = 0;
+    size_t                                                         discard_count = 0;
+    std::vector<std::future<void>>                                 running_loads;
+
+private:
+    void load(const WorldCell& cell)
+    {
+        running_loads.emplace_back(std::async(std::launch::async,
+                                              [this, cell]
+                                              {
+                                                  std::this_thread::sleep_for(load_latency);
+                                                  std::vector<Bounds> chunk;
+                                                  if (auto found = source.cells.find(cell); found != source.cells.end())
+                                                      chunk = found->second;
+                                                  {
+                                                      std::lock_guard lk(loaded_mtx);
+                                                      assert(!loaded.contains(cell));
+                                                      loaded.emplace(cell, std::move(chunk));
+                                                  }
+                                                  streamer.finish_load(cell);
+                                              }));
+    }
+
+    void merge(const WorldCell& cell)
+    {
+        std::vector<Bounds> chunk;
+        {
+            std::lock_guard lk(loaded_mtx);
+            auto            found = loaded.find(cell);
+            assert(found != loaded.end());
+            chunk = std::move(found->second);
+            loaded.erase(found);
+        }
+        assert(!merged.contains(cell));
+        auto& proxies = merged[cell];
+        for (const auto& bounds : chunk)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            proxies.emplace_back(bvh.insert(bounds, 0));
+            while (std::chrono::steady_clock::now() - start < merge_cost_per_object)
+            {
+            }
+        }
+        ++merge_count;
+    }
+
+    void unload(const WorldCell& cell, bool b_merged)
+    {
+        if (!b_merged)
+        {
+            std::lock_guard lk(loaded_mtx);
+            assert(loaded.contains(cell));
+            loaded.erase(cell);
+            ++discard_count;
+            return;
+        }
+        auto found = merged.find(cell);
+        assert(found != merged.end());
+        for (const auto& proxy : found->second)
+            bvh.remove(proxy);
+        merged.erase(found);
+    }
+};
+
+static void test_partition()
+{
+    const WorldPartition partition(64.f, 4, 128.f);
+
+    // Level selection
+    assert(partition.get_cell(Bounds::from_extent({10, 0, 10}, glm::vec3{2})).level == 0);
+    assert(partition.get_cell(Bounds::from_extent({10, 0, 10}, glm::vec3{100})).level == 1);
+    assert(partition.get_cell(Bounds::from_extent({10, 0, 10}, glm::vec3{10000})).level == 3);
+    const WorldCell negative = partition.get_cell(Bounds::from_extent({-10, 0, -70}, glm::vec3{2}));
+    assert(negative.x == -1 && negative.z == -2 && negative.level == 0);
+    (void)negative;
+
+    // Objects always fit in the loose bounds of their cell
+    std::mt19937                          rng(3);
+    std::uniform_real_distribution<float> position(-2000.f, 2000.f);
+    std::uniform_real_distribution<float> size(0.1f, 600.f);
+    for (int i = 0; i < 10000; ++i)
+    {
+        const Bounds    bounds      = Bounds::from_extent({position(rng), 0, position(rng)}, glm::vec3{size(rng)});
+        const WorldCell cell        = partition.get_cell(bounds);
+        const Bounds    cell_bounds = partition.get_cell_bounds(cell);
+        assert(cell.level == 3 || (bounds.min().x >= cell_bounds.min().x && bounds.max().x <= cell_bounds.max().x && bounds.min().z >= cell_bounds.min().z && bounds.max().z <= cell_bounds.max().z));
+        (void)cell_bounds;
+    }
+
+    // Collected cells are sorted and match a brute force search
+    for (int i = 0; i < 100; ++i)
+    {
+        const glm::vec3        viewer{position(rng), 0, position(rng)};
+        std::vector<WorldCell> cells;
+        partition.collect_cells(viewer, cells);
+        for (size_t c = 1; c < cells.size(); ++c)
+            assert(partition.get_distance(cells[c - 1], viewer) <= partition.get_distance(cells[c], viewer));
+
+        size_t expected = 0;
+        for (uint32_t level = 0; level < partition.get_level_count(); ++level)
+        {
+            const float   cell_size = partition.get_cell_size(level);
+            const int32_t range     = static_cast<int32_t>(partition.get_streaming_distance(level) / cell_size) + 3;
+            const int32_t base_x    = static_cast<int32_t>(std::floor(viewer.x / cell_size));
+            const int32_t base_z    = static_cast<int32_t>(std::floor(viewer.z / cell_size));
+            for (int32_t z = base_z - range; z <= base_z + range; ++z)
+                for (int32_t x = base_x - range; x <= base_x + range; ++x)
+                    if (partition.get_distance({x, z, level}, viewer) <= partition.get_streaming_distance(level))
+                    {
+                        ++expected;
+                        assert(std::ranges::find(cells, WorldCell{x, z, level}) != cells.end());
+                    }
+        }
+        assert(cells.size() == expected);
+    }
+}
+
+static void settle(StreamedWorld& world, const glm::vec3& position, double budget_ms)
+{
+    world.streamer.update(position, budget_ms);
+    for (int i = 0; i < 100000 && !world.streamer.is_idle(); ++i)
+    {
+        std::this_thread::yield();
+        world.streamer.update(position, budget_ms);
+    }
+    assert(world.streamer.is_idle());
+}
+
+static void check_streamed_cells(const StreamedWorld& world, const SyntheticWorld& source, const WorldPartition& partition, const glm::vec3& position, float unload_margin)
+{
+    std::vector<WorldCell> desired;
+    partition.collect_cells(position, desired);
+    for (const auto& cell : desired)
+    {
+        (void)cell;
+        assert(world.merged.contains(cell));
+    }
+    // Nothing merged outside of the unload range
+    size_t merged_objects = 0;
+    for (const auto& [cell, proxies] : world.merged)
+    {
+        assert(partition.get_distance(cell, position) <= partition.get_streaming_distance(cell.level) * (1.f + unload_margin));
+        merged_objects += proxies.size();
+    }
+    assert(world.bvh.size() == merged_objects);
+    assert(merged_objects >= source.count(desired));
+    assert(world.bvh.validate());
+    (void)source;
+    (void)merged_objects;
+}
+
+static void test_streaming()
+{
+    const WorldPartition partition(32.f, 3, 64.f);
+    const SyntheticWorld source(partition, 20000, 2000.f, 7);
+    StreamedWorld        world(source, partition);
+    world.streamer.set_max_concurrent_loads(8);
+
+    // Walk along a path and check that the streamed cells follow the viewer
+    const glm::vec3 path[] = {{0, 0, 0}, {300, 0, 0}, {300, 0, 400}, {-500, 0, 400}, {-500, 0, -700}, {0, 0, 0}};
+    for (const auto& position : path)
+    {
+        settle(world, position, 1.0);
+        check_streamed_cells(world, source, partition, position, 0.1f);
+    }
+
+    // Zero budget : a single merge or unload per update
+    world.streamer.update({900, 0, 900}, 0.0);
+    for (int i = 0; i < 1000 && !world.streamer.is_idle(); ++i)
+    {
+        world.streamer.update({900, 0, 900}, 0.0);
+        assert(world.streamer.get_stats().merged_last_update + world.streamer.get_stats().unloaded_last_update <= 1);
+        world.wait_loads();
+    }
+    settle(world, {900, 0, 900}, 0.0);
+    check_streamed_cells(world, source, partition, {900, 0, 900}, 0.1f);
+
+    // Leave before the loads are finished : they are discarded once received, then come back
+    world.load_latency = std::chrono::milliseconds(2);
+    world.streamer.update({-900, 0, -900}, 1.0);
+    world.streamer.update({900, 0, 900}, 1.0);
+    world.streamer.update({-900, 0, -900}, 1.0);
+    world.wait_loads();
+    settle(world, {-900, 0, -900}, 1.0);
+    check_streamed_cells(world, source, partition, {-900, 0, -900}, 0.1f);
+    world.load_latency = std::chrono::microseconds(0);
+
+    // Unload everything, loads still running are discarded by the next update
+    world.streamer.update({0, 0, 0}, 1.0);
+    world.streamer.unload_all();
+    world.wait_loads();
+    world.streamer.set_max_concurrent_loads(0);
+    world.streamer.update({0, 0, 0}, 1.0);
+    assert(world.streamer.get_stats().loading == 0);
+    assert(world.merged.empty());
+    assert(world.loaded.empty());
+    assert(world.bvh.size() == 0);
+}
+
+static void benchmark_streaming()
+{
+    constexpr size_t OBJECT_COUNT = 2000000;
+    constexpr float  WORLD_SIZE   = 16000.f;
+    constexpr double BUDGET_MS    = 2.0;
+
+    const WorldPartition partition(64.f, 4, 256.f);
+    const SyntheticWorld source(partition, OBJECT_COUNT, WORLD_SIZE, 11);
+
+    // Fly through the world at ~200 m/s (60 fps)
+    std::vector<glm::vec3> frames;
+    for (int i = 0; i < 3000; ++i)
+    {
+        const float t = static_cast<float>(i) / 3000.f;
+        frames.emplace_back(glm::vec3{(t - 0.5f) * WORLD_SIZE * 0.8f, 0, std::sin(t * 12.f) * WORLD_SIZE * 0.3f} * 0.5f);
+    }
+
+    for (const double budget : {BUDGET_MS, 1000.0})
+    {
+        StreamedWorld world(source, partition);
+        world.streamer.set_max_concurrent_loads(64);
+        world.merge_cost_per_object = std::chrono::microseconds(5);
+        double worst       = 0;
+        double total       = 0;
+        size_t max_merge   = 0;
+        size_t over_budget = 0;
+        for (const auto& position : frames)
+        {
+            world.streamer.update(position, budget);
+            const WorldStreamingStats& stats = world.streamer.get_stats();
+            worst                            = std::max(worst, stats.last_update_ms);
+            total                           += stats.last_update_ms;
+            max_merge                        = std::max(max_merge, stats.merged_last_update);
+            if (stats.last_update_ms > BUDGET_MS * 1.5)
+                ++over_budget;
+            // Loads are considered finished within a frame
+            world.wait_loads();
+        }
+        std::cout << "streaming (budget " << budget << "ms) : avg " << total / static_cast<double>(frames.size()) << "ms, worst " << worst << "ms, " << over_budget << " frames over " << BUDGET_MS * 1.5 << "ms, max merges per frame " << max_merge
+            << ", " << world.merge_count << " merges, " << world.bvh.size() << " objects resident / " << OBJECT_COUNT << std::endl;
+    }
+}
+
+int main()
+{
+    Logger::get().enable_logs(Logger::LOG_LEVEL_DEBUG | Logger::LOG_LEVEL_ERROR | Logger::LOG_LEVEL_FATAL | Logger::LOG_LEVEL_INFO | Logger::LOG_LEVEL_WARNING);
+
+    test_partition();
+    test_streaming();
+    benchmark_streaming();
+}
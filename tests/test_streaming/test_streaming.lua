@@ -0,0 +1,10 @@
+declare_module(
+    "test_streaming", 
+    {
+        deps = {"types"},
+        is_executable = true
+    }
+)
+
+target("test_streaming")
+    set_group("test")